@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Renderer_Hook.h"
+
+namespace ingame_overlay {
+
+enum class AssetType : uint32_t
+{
+    // Tightly packed straight RGBA pixels.
+    Image,
+    // Rows of 4x4 blocks, see CompressedFormat.
+    CompressedImage,
+    // Anything else: font files, serialized font atlases...
+    Blob,
+};
+
+enum AssetFlags : uint32_t
+{
+    // Build the image mip chain when it is uploaded.
+    AssetFlag_Mipmaps = 1 << 0,
+};
+
+// Pack file layout, little endian:
+//   AssetPackHeader_t
+//   AssetPackEntry_t[AssetCount], sorted by name
+//   the names, then the assets data, each one 16 bytes aligned.
+// Offsets are from the start of the file.
+struct AssetPackHeader_t
+{
+    // "IGOPACK", nul terminated.
+    char Magic[8];
+    uint32_t Version;
+    uint32_t AssetCount;
+};
+
+struct AssetPackEntry_t
+{
+    uint64_t NameOffset;
+    uint32_t NameSize;
+    // AssetType
+    uint32_t Type;
+    // CompressedFormat of a CompressedImage, 0 otherwise.
+    uint32_t Format;
+    uint32_t Width, Height;
+    // AssetFlags
+    uint32_t Flags;
+    uint64_t DataOffset;
+    uint64_t DataSize;
+};
+
+static_assert(sizeof(AssetPackHeader_t) == 16, "AssetPackHeader_t is part of the file format.");
+static_assert(sizeof(AssetPackEntry_t) == 48, "AssetPackEntry_t is part of the file format.");
+
+constexpr char AssetPackMagic[8] = { 'I', 'G', 'O', 'P', 'A', 'C', 'K', '\0' };
+constexpr uint32_t AssetPackVersion = 1;
+
+// A read only asset pack, mapped in memory. Assets are uploaded straight from the mapping.
+class Asset_Pack
+{
+    void* _File;
+    void* _Mapping;
+    const uint8_t* _Data;
+    size_t _Size;
+    const AssetPackEntry_t* _Entries;
+    uint32_t _AssetCount;
+
+    bool _Validate() const;
+
+    Asset_Pack(const Asset_Pack&) = delete;
+    Asset_Pack(Asset_Pack&&) = delete;
+    Asset_Pack& operator =(const Asset_Pack&) = delete;
+    Asset_Pack& operator =(Asset_Pack&&) = delete;
+
+public:
+    Asset_Pack();
+    ~Asset_Pack();
+
+    /// <summary>
+    ///   Maps a pack file made by ingame_overlay_packer. Only the header and the index are checked, the assets data is paged in on use.
+    /// </summary>
+    /// <returns>false if the file can't be mapped or isn't a valid pack.</returns>
+    bool Open(std::string const& path);
+
+    /// <summary>
+    ///   Unmaps the pack. Pointers returned by GetAssetData become invalid, image resources are left alone.
+    /// </summary>
+    void Close();
+
+    bool IsOpen() const;
+
+    uint32_t AssetCount() const;
+
+    /// <returns>The asset at index, nullptr if out of range.</returns>
+    const AssetPackEntry_t* GetAsset(uint32_t index) const;
+
+    /// <returns>The asset named name, nullptr if there is none.</returns>
+    const AssetPackEntry_t* FindAsset(std::string const& name) const;
+
+    std::string GetAssetName(AssetPackEntry_t const& asset) const;
+
+    /// <returns>The asset data, in the mapping.</returns>
+    const void* GetAssetData(AssetPackEntry_t const& asset) const;
+
+    /// <summary>
+    ///   Creates the image resource of an Image or CompressedImage asset, straight from the mapping.
+    /// </summary>
+    /// <returns>The resource handle, 0 on failure.</returns>
+    ImageResourceHandle CreateImageResource(Renderer_Hook* renderer, AssetPackEntry_t const& asset) const;
+};
+
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct ImDrawData;
+struct ImDrawList;
+
+namespace ingame_overlay {
+
+// Portable binary encoding of an ImDrawData, to send a frame to another process, record it or compare it in a test.
+// Format version 2, little endian:
+//   - positions in 1/64 pixel, as 16 bits deltas from the previous vertex,
+//   - UVs as 16 bits unsigned normalized values, or as floats in the lists with UVs outside of [0, 1],
+//   - colors as 8 bits indices in a per frame palette, after the positions and UVs of the list,
+//   - indices as 8 bits deltas from the previous index,
+//   - the fixed width fields that don't fit are escaped and followed by their full value,
+//   - textures as varint indices in a per frame table of the encoder ImTextureIDs,
+//   - a draw list identical to the one at the same position in the previous frame is only a repeat tag.
+// Positions and UVs are rounded, so a decoded frame is close to the original, and decoding the same bytes always gives
+// the same frame. Draw callbacks can't cross processes, only ImDrawCallback_ResetRenderState is kept.
+class Draw_Data_Encoder
+{
+    std::vector<uint64_t> _PreviousHashes;
+    uint64_t _FrameNumber;
+    bool _ForceKeyframe;
+
+    // Reused between frames, so encoding doesn't allocate once the buffers reached their size.
+    std::vector<uint8_t> _Header;
+    std::vector<uint8_t> _Body;
+    std::vector<uint32_t> _Palette;
+    std::vector<uint32_t> _PaletteTable;
+    std::vector<uint64_t> _Textures;
+    std::vector<uint64_t> _Hashes;
+
+    uint32_t _PaletteIndex(uint32_t color);
+    uint32_t _TextureIndex(uint64_t texture);
+
+    Draw_Data_Encoder(const Draw_Data_Encoder&) = delete;
+    Draw_Data_Encoder(Draw_Data_Encoder&&) = delete;
+    Draw_Data_Encoder& operator =(const Draw_Data_Encoder&) = delete;
+    Draw_Data_Encoder& operator =(Draw_Data_Encoder&&) = delete;
+
+public:
+    static constexpr uint32_t Version = 2;
+
+    Draw_Data_Encoder();
+
+    /// <summary>
+    ///   Encodes a frame.
+    /// </summary>
+    /// <param name="imgui_draw_data">
+    ///   The ImDrawData, like ImGui::GetDrawData() after ImGui::Render().
+    /// </param>
+    /// <param name="output">
+    ///   Replaced by the encoded frame. Reuse it between frames to avoid allocations.
+    /// </param>
+    /// <param name="keyframe">
+    ///   Encodes every draw list, for a decoder that didn't decode the previous frame, like a late joiner or a reader that skips frames.
+    /// </param>
+    void Encode(/*ImDrawData* */ const void* imgui_draw_data, std::vector<uint8_t>& output, bool keyframe = false);
+
+    /// <summary>
+    ///   The next frame is encoded as a keyframe.
+    /// </summary>
+    void Reset();
+};
+
+// Decodes the frames of a Draw_Data_Encoder in order. The draw lists are decoded straight into ImDrawList buffers reused
+// between frames, and the repeated lists are kept as is, the result can be given to any ImGui renderer without a copy.
+class Draw_Data_Decoder
+{
+    std::vector<ImDrawList*> _Lists;
+    std::vector<ImDrawList*> _PreviousLists;
+    // Draw lists not used by the current frame, kept for their buffers.
+    std::vector<ImDrawList*> _FreeLists;
+    std::unique_ptr<ImDrawData> _DrawData;
+    std::vector<uint32_t> _Palette;
+    std::vector<void*> _Textures;
+    std::function<void*(uint64_t)> _TextureRemap;
+    uint64_t _FrameNumber;
+
+    ImDrawList* _AcquireList();
+
+    Draw_Data_Decoder(const Draw_Data_Decoder&) = delete;
+    Draw_Data_Decoder(Draw_Data_Decoder&&) = delete;
+    Draw_Data_Decoder& operator =(const Draw_Data_Decoder&) = delete;
+    Draw_Data_Decoder& operator =(Draw_Data_Decoder&&) = delete;
+
+public:
+    Draw_Data_Decoder();
+    ~Draw_Data_Decoder();
+
+    /// <summary>
+    ///   Maps the encoder ImTextureIDs to this process textures, like the encoder font atlas to the local one.
+    ///   Without remap, the encoder ImTextureIDs are used as is, which only works in the same process.
+    /// </summary>
+    void SetTextureRemap(std::function<void*(uint64_t texture)> remap);
+
+    /// <summary>
+    ///   Decodes a frame. The previous decoded frame is replaced, even on failure.
+    /// </summary>
+    /// <returns>false if data is corrupted, of another version, or repeats lists of a frame this decoder didn't decode. Ask the encoder for a keyframe then.</returns>
+    bool Decode(const void* data, size_t size);
+
+    /// <summary>
+    ///   The last decoded frame, valid until the next Decode. nullptr if the last Decode failed.
+    /// </summary>
+    /*ImDrawData* */ void* GetDrawData();
+};
+
+}
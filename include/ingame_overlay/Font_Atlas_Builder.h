@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace ingame_overlay {
+
+// An ImFontAtlas builder that rasterizes the glyphs on worker threads.
+// The glyph sizes are gathered and packed with imstb_rectpack first, like the ImGui stb_truetype builder does,
+// then each worker renders its own glyphs into their packed rectangles. The rectangles don't overlap, so the
+// texture and glyph tables are byte identical to the ones ImGui builds on a single thread.
+//
+//   ImFontAtlas* atlas = new ImFontAtlas();
+//   atlas->AddFontFromFileTTF("font.ttf", 16.0f, nullptr, atlas->GetGlyphRangesChineseFull());
+//   Font_Atlas_Builder::Build(atlas);
+//   renderer->StartHook(callback, toggle_keys, atlas);
+namespace Font_Atlas_Builder {
+
+/// <summary>
+///   Builds the atlas, replacing ImFontAtlas::Build.
+/// </summary>
+/// <param name="imgui_font_atlas">
+///   The ImFontAtlas, with its fonts added.
+/// </param>
+/// <param name="thread_count">
+///   The number of rasterizing threads, the calling thread included. 0 uses std::thread::hardware_concurrency.
+/// </param>
+bool Build(/*ImFontAtlas* */ void* imgui_font_atlas, uint32_t thread_count = 0);
+
+/// <summary>
+///   Sets ImFontAtlas::FontBuilderIO, so the builds ImGui or the renderer backends start use this builder too.
+/// </summary>
+void SetAsFontBuilder(/*ImFontAtlas* */ void* imgui_font_atlas);
+
+}
+
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ingame_overlay {
+
+// Serializes a built ImFontAtlas, texture pixels and glyph tables, so the next runs can skip ImFontAtlas::Build.
+// A loaded atlas is ready to be given to Renderer_Hook::StartHook, it must not be built again.
+//
+//   ImFontAtlas* atlas = new ImFontAtlas();
+//   atlas->AddFontFromFileTTF("font.ttf", 16.0f, nullptr, atlas->GetGlyphRangesChineseFull());
+//   uint64_t key = Font_Atlas_Cache::ComputeKey(atlas);
+//   if (!Font_Atlas_Cache::Load(atlas, "font.cache", key))
+//   {
+//       atlas->Build();
+//       Font_Atlas_Cache::Save(atlas, "font.cache", key);
+//   }
+namespace Font_Atlas_Cache {
+
+/// <summary>
+///   Hashes what a build depends on: the fonts data, their ImFontConfig and glyph ranges, the atlas settings and the ImGui version.
+/// </summary>
+/// <param name="imgui_font_atlas">
+///   The ImFontAtlas, with its fonts added and not built yet.
+/// </param>
+uint64_t ComputeKey(/*ImFontAtlas* */ const void* imgui_font_atlas);
+
+/// <summary>
+///   Serializes a built atlas.
+/// </summary>
+/// <param name="key">
+///   The ComputeKey result, taken before the build.
+/// </param>
+bool Save(/*ImFontAtlas* */ void* imgui_font_atlas, uint64_t key, std::vector<uint8_t>& cache);
+bool Save(/*ImFontAtlas* */ void* imgui_font_atlas, std::string const& path, uint64_t key);
+
+/// <summary>
+///   Replaces the fonts and the texture of an atlas with a serialized build.
+///   Nothing is changed when the cache is missing, corrupted, or was saved for another key or ImGui version.
+/// </summary>
+/// <returns>true if the atlas has been loaded, it is then built.</returns>
+bool Load(/*ImFontAtlas* */ void* imgui_font_atlas, const void* cache, size_t cache_size, uint64_t key);
+bool Load(/*ImFontAtlas* */ void* imgui_font_atlas, std::string const& path, uint64_t key);
+
+}
+
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(__has_include)
+    #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+        #include <coroutine>
+        #include <exception>
+        #define INGAMEOVERLAY_HAS_COROUTINES
+    #endif
+#endif
+
+namespace ingame_overlay {
+
+// What a frame task wants after one of its steps.
+enum class FrameTaskStatus
+{
+    // Run the next step as soon as possible, in this frame if the budget allows it.
+    Yield,
+    // Run the next step in the next frame.
+    NextFrame,
+    // The task is finished.
+    Done,
+};
+
+// Runs long overlay work in small steps on the render thread, inside the hooked present, right after OverlayProc.
+// The GL context (or the D3D device) and the ImGui frame are current during a step, like in OverlayProc.
+// Each frame, the ready tasks run one step after the other, round robin, until the frame budget is spent. At least one step
+// runs per frame, so a step longer than the budget still makes progress. A step should stay well below the budget and
+// check TimeLeft to split loops.
+//
+//   renderer->FrameScheduler.Post([state = std::make_shared<upload_state_t>()]()
+//   {
+//       while (state->next < state->images.size() && renderer->FrameScheduler.TimeLeft())
+//           state->Upload(state->next++);
+//
+//       return state->next == state->images.size() ? FrameTaskStatus::Done : FrameTaskStatus::NextFrame;
+//   });
+class Frame_Scheduler
+{
+public:
+    using Task = std::function<FrameTaskStatus()>;
+
+private:
+    // Tasks posted since the last frame, from any thread.
+    std::mutex _PostedMutex;
+    std::vector<Task> _Posted;
+    std::atomic<size_t> _PendingCount;
+
+    // Render thread side.
+    std::deque<Task> _Ready;
+    std::vector<Task> _Parked;
+    std::chrono::steady_clock::time_point _FrameDeadline;
+
+    std::atomic<int64_t> _BudgetMicroseconds;
+
+    Frame_Scheduler(const Frame_Scheduler&) = delete;
+    Frame_Scheduler(Frame_Scheduler&&) = delete;
+    Frame_Scheduler& operator =(const Frame_Scheduler&) = delete;
+    Frame_Scheduler& operator =(Frame_Scheduler&&) = delete;
+
+public:
+    // Default time given to the tasks each frame.
+    static constexpr std::chrono::microseconds DefaultFrameBudget{ 1000 };
+
+    Frame_Scheduler();
+
+    /// <summary>
+    ///   Queues a task, its first step runs in the next frame. Can be called from any thread, and from a task.
+    /// </summary>
+    void Post(Task task);
+
+    void SetFrameBudget(std::chrono::microseconds budget);
+    std::chrono::microseconds GetFrameBudget() const;
+
+    /// <summary>
+    ///   From a task step, tells if the frame budget has time left for more work.
+    /// </summary>
+    bool TimeLeft() const;
+
+    /// <summary>
+    ///   The tasks not finished yet, including the ones posted since the last frame.
+    /// </summary>
+    size_t PendingTasks() const;
+
+    /// <summary>
+    ///   Drops every task. Call it from OverlayProc or when no frame is drawn, like in OverlayHookReady(false), never from a task.
+    /// </summary>
+    void Clear();
+
+    /// <summary>
+    ///   Runs the task steps of a frame, called by the renderer hooks after OverlayProc.
+    /// </summary>
+    void RunFrame();
+
+#if defined(INGAMEOVERLAY_HAS_COROUTINES)
+    class Frame_Task;
+
+    // co_await NextFrame() in a Frame_Task ends the step and resumes in the next frame.
+    struct NextFrameAwaitable
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    // co_await Yield() in a Frame_Task goes on right away while the frame budget has time left, else resumes later.
+    struct YieldAwaitable
+    {
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle) const noexcept;
+        void await_resume() const noexcept {}
+    };
+
+    static NextFrameAwaitable NextFrame() { return NextFrameAwaitable{}; }
+    static YieldAwaitable Yield() { return YieldAwaitable{}; }
+
+    // Coroutine return type for tasks written with co_await, started by Post.
+    //
+    //   Frame_Scheduler::Frame_Task UploadImages(Renderer_Hook* renderer, std::vector<image_t> images)
+    //   {
+    //       for (auto& image : images)
+    //       {
+    //           image.handle = renderer->CreateImageResource(image.pixels.data(), image.width, image.height);
+    //           co_await Frame_Scheduler::Yield();
+    //       }
+    //   }
+    //   ...
+    //   renderer->FrameScheduler.Post(UploadImages(renderer, std::move(images)));
+    class Frame_Task
+    {
+    public:
+        struct promise_type
+        {
+            Frame_Scheduler* Scheduler = nullptr;
+            FrameTaskStatus Status = FrameTaskStatus::Done;
+
+            Frame_Task get_return_object() { return Frame_Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() noexcept {}
+            // The library doesn't use exceptions, a task that throws on the render thread can't be recovered.
+            void unhandled_exception() noexcept { std::terminate(); }
+        };
+
+    private:
+        std::coroutine_handle<promise_type> _Handle;
+
+        friend class Frame_Scheduler;
+
+        explicit Frame_Task(std::coroutine_handle<promise_type> handle) :
+            _Handle(handle)
+        {}
+
+    public:
+        Frame_Task(Frame_Task&& other) noexcept :
+            _Handle(other._Handle)
+        {
+            other._Handle = nullptr;
+        }
+
+        Frame_Task& operator =(Frame_Task&& other) noexcept
+        {
+            if (this != &other)
+            {
+                if (_Handle)
+                    _Handle.destroy();
+
+                _Handle = other._Handle;
+                other._Handle = nullptr;
+            }
+            return *this;
+        }
+
+        Frame_Task(const Frame_Task&) = delete;
+        Frame_Task& operator =(const Frame_Task&) = delete;
+
+        ~Frame_Task()
+        {
+            if (_Handle)
+                _Handle.destroy();
+        }
+    };
+
+    /// <summary>
+    ///   Queues a coroutine task, like Post(Task). The coroutine frame is destroyed when it returns or when the task is dropped.
+    /// </summary>
+    void Post(Frame_Task task)
+    {
+        auto shared_task = std::make_shared<Frame_Task>(std::move(task));
+        Post([this, shared_task]() -> FrameTaskStatus
+        {
+            auto handle = shared_task->_Handle;
+            handle.promise().Scheduler = this;
+            handle.promise().Status = FrameTaskStatus::Done;
+            handle.resume();
+            return handle.done() ? FrameTaskStatus::Done : handle.promise().Status;
+        });
+    }
+#endif
+};
+
+#if defined(INGAMEOVERLAY_HAS_COROUTINES)
+inline void Frame_Scheduler::NextFrameAwaitable::await_suspend(std::coroutine_handle<> handle) const noexcept
+{
+    std::coroutine_handle<Frame_Task::promise_type>::from_address(handle.address()).promise().Status = FrameTaskStatus::NextFrame;
+}
+
+inline bool Frame_Scheduler::YieldAwaitable::await_suspend(std::coroutine_handle<> handle) const noexcept
+{
+    auto& promise = std::coroutine_handle<Frame_Task::promise_type>::from_address(handle.address()).promise();
+    if (promise.Scheduler->TimeLeft())
+        return false;
+
+    promise.Status = FrameTaskStatus::Yield;
+    return true;
+}
+#endif
+
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer_Hook.h"
+
+namespace ingame_overlay {
+
+enum class GlyphRasterMode
+{
+    // Alpha coverage at the font size, drawn with the ImGui shader. Other sizes are stretched and blurry.
+    Bitmap,
+    // Distance to the glyph edge, drawn with the renderer distance field shader (see Renderer_Hook::BeginSdfDraw).
+    // The glyphs rasterized once at the font size stay sharp at any draw size.
+    SignedDistanceField,
+};
+
+struct Cached_Glyph
+{
+    // The cache page holding this glyph, to be used as the ImTextureID. nullptr for blank glyphs like spaces.
+    /*ImTextureID*/ void* Texture;
+    // Quad relative to the pen position, the top of the line, like ImFontGlyph.
+    float X0, Y0, X1, Y1;
+    float U0, V0, U1, V1;
+    float AdvanceX;
+};
+
+// Rasterizes the glyphs of a font the first time they are drawn, instead of baking whole glyph ranges in the ImFontAtlas.
+// Glyphs are packed in a few pages, updated with UpdateImageResource one glyph at a time. When the pages are full, the
+// least recently used page is emptied and reused, pages drawn during the current ImGui frame are never evicted.
+// Only use it from OverlayProc, its pages are created and updated with the renderer.
+//
+//   Glyph_Cache chat_font(renderer);
+//   chat_font.LoadFontFromFile("NotoSansCJK.ttc", 18.0f);
+//   ...
+//   chat_font.AddText(ImGui::GetWindowDrawList(), x, y, IM_COL32_WHITE, message.c_str());
+class Glyph_Cache
+{
+    struct Font_t;
+    struct Page_t;
+
+    struct Entry_t
+    {
+        Cached_Glyph Glyph;
+        Page_t* Page;
+        int LastUsedFrame;
+    };
+
+    Renderer_Hook* _Renderer;
+    uint32_t _PageSize;
+    uint32_t _MaxPages;
+    GlyphRasterMode _Mode;
+    std::vector<std::unique_ptr<Page_t>> _Pages;
+    std::unordered_map<uint32_t, Entry_t> _Glyphs;
+    std::unique_ptr<Font_t> _Font;
+    int _Frame;
+    std::vector<uint8_t> _Bitmap;
+    std::vector<uint8_t> _StagingBuffer;
+
+    void _BeginFrame();
+    Page_t* _CreatePage();
+    void _EvictPage(Page_t* page);
+    bool _AllocateSlot(uint32_t width, uint32_t height, bool allow_eviction, Page_t*& target_page, uint32_t& x, uint32_t& y);
+    Entry_t* _RasterizeGlyph(uint32_t codepoint, bool allow_eviction);
+
+    Glyph_Cache(const Glyph_Cache&) = delete;
+    Glyph_Cache(Glyph_Cache&&) = delete;
+    Glyph_Cache& operator =(const Glyph_Cache&) = delete;
+    Glyph_Cache& operator =(Glyph_Cache&&) = delete;
+
+public:
+    /// <summary>
+    ///   Creates an empty glyph cache, LoadFont must be called before drawing.
+    /// </summary>
+    /// <param name="renderer">
+    ///   The renderer used to create and update the cache pages. The renderer must support UpdateImageResource.
+    /// </param>
+    /// <param name="page_size">
+    ///   The width and height of a cache page, in pixels.
+    /// </param>
+    /// <param name="max_pages">
+    ///   The number of pages kept alive. It can only be exceeded when a single frame draws more glyphs than the pages hold.
+    /// </param>
+    /// <param name="mode">
+    ///   How the glyphs are rasterized. SignedDistanceField needs a renderer where BeginSdfDraw succeeds, the OpenGL ones.
+    /// </param>
+    Glyph_Cache(Renderer_Hook* renderer, uint32_t page_size = 512, uint32_t max_pages = 4, GlyphRasterMode mode = GlyphRasterMode::Bitmap);
+    ~Glyph_Cache();
+
+    /// <summary>
+    ///   Loads a TrueType or OpenType font and rasterizes its ASCII glyphs. The previous font glyphs are dropped.
+    /// </summary>
+    /// <param name="font_data">
+    ///   The font file content, it is copied.
+    /// </param>
+    /// <param name="size_pixels">
+    ///   The line height in pixels, like ImFontConfig::SizePixels. In SignedDistanceField mode it is the rasterization size,
+    ///   32 or more keeps the glyph corners sharp.
+    /// </param>
+    /// <param name="font_index">
+    ///   The font to use in a font collection (.ttc).
+    /// </param>
+    bool LoadFont(const void* font_data, size_t font_data_size, float size_pixels, int font_index = 0);
+    bool LoadFontFromFile(std::string const& path, float size_pixels, int font_index = 0);
+
+    /// <summary>
+    ///   Rasterizes glyphs ahead of time, for example the ones GetRecentCodepoints returned during the last run.
+    /// </summary>
+    void Preload(const uint32_t* codepoints, size_t count);
+
+    /// <returns>The cached codepoints, most recently drawn first.</returns>
+    std::vector<uint32_t> GetRecentCodepoints() const;
+
+    /// <summary>
+    ///   Gets a glyph, rasterizing it if it is not cached. Codepoints missing from the font use the '?' glyph.
+    /// </summary>
+    /// <returns>The glyph, valid until the next GetGlyph or AddText call. nullptr if no font is loaded. Its texture is nullptr while the renderer can't give the page texture yet.</returns>
+    const Cached_Glyph* GetGlyph(uint32_t codepoint);
+
+    float GetFontSize() const;
+
+    /// <summary>
+    ///   Measures an UTF-8 text, lines are split on '\n'.
+    /// </summary>
+    void CalcTextSize(const char* text_begin, const char* text_end, float& width, float& height);
+    void CalcTextSize(float size_pixels, const char* text_begin, const char* text_end, float& width, float& height);
+
+    /// <summary>
+    ///   Draws an UTF-8 text, lines are split on '\n'.
+    /// </summary>
+    /// <param name="imgui_draw_list">
+    ///   The ImDrawList to draw into, ImGui::GetWindowDrawList() for example.
+    /// </param>
+    /// <param name="size_pixels">
+    ///   The line height the text is drawn at, GetFontSize() when omitted.
+    /// </param>
+    /// <param name="x">
+    ///   Left of the text, in screen pixels.
+    /// </param>
+    /// <param name="y">
+    ///   Top of the text, in screen pixels.
+    /// </param>
+    /// <param name="color">
+    ///   The text color, an IM_COL32.
+    /// </param>
+    void AddText(/*ImDrawList* */ void* imgui_draw_list, float x, float y, uint32_t color, const char* text_begin, const char* text_end = nullptr);
+    void AddText(/*ImDrawList* */ void* imgui_draw_list, float size_pixels, float x, float y, uint32_t color, const char* text_begin, const char* text_end = nullptr);
+
+    /// <summary>
+    ///   Frees the font, the glyphs and the cache pages.
+    /// </summary>
+    void Clear();
+};
+
+}
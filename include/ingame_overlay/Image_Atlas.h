@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <vector>
+
+#include "Renderer_Hook.h"
+#include "Slot_Map.h"
+
+namespace ingame_overlay {
+
+struct Atlas_Image
+{
+    // The atlas page holding this image, to be used as the ImTextureID.
+    /*ImTextureID*/ void* Texture;
+    // UV rectangle of this image inside its page, usable as ImGui::Image uv0/uv1.
+    float U0, V0;
+    float U1, V1;
+};
+
+class Image_Atlas
+{
+    struct Page_t;
+
+    struct Entry_t
+    {
+        Atlas_Image Image;
+        Page_t* Page;
+        uint32_t SlotX, SlotY;
+        uint32_t SlotWidth, SlotHeight;
+    };
+
+    Renderer_Hook* _Renderer;
+    uint32_t _PageSize;
+    std::vector<std::unique_ptr<Page_t>> _Pages;
+    Slot_Map<Entry_t> _Images;
+    std::vector<uint8_t> _StagingBuffer;
+
+    Page_t* _CreatePage();
+    bool _AllocateSlot(uint32_t width, uint32_t height, Entry_t& entry);
+    void _ReleaseSlot(Entry_t const& entry);
+    void _ReleasePage(Page_t* page);
+
+    Image_Atlas(const Image_Atlas&) = delete;
+    Image_Atlas(Image_Atlas&&) = delete;
+    Image_Atlas& operator =(const Image_Atlas&) = delete;
+    Image_Atlas& operator =(Image_Atlas&&) = delete;
+
+public:
+    /// <summary>
+    ///   Creates an atlas that packs small images into shared pages created with the renderer's CreateImageResource.
+    /// </summary>
+    /// <param name="renderer">
+    ///   The renderer used to create and update the atlas pages. The renderer must support UpdateImageResource.
+    /// </param>
+    /// <param name="page_size">
+    ///   The width and height of an atlas page, in pixels.
+    /// </param>
+    Image_Atlas(Renderer_Hook* renderer, uint32_t page_size = 1024);
+    ~Image_Atlas();
+
+    /// <summary>
+    ///   Packs an RGBA ordered buffer into an atlas page and returns a handle to it, use GetImage to draw it with ImGui.
+    /// </summary>
+    /// <param name="image_data">
+    ///   The RGBA buffer.
+    /// </param>
+    /// <param name="width">
+    ///   Your RGBA image width, must fit in a page with a 1 pixel border.
+    /// </param>
+    /// <param name="height">
+    ///   Your RGBA image height, must fit in a page with a 1 pixel border.
+    /// </param>
+    /// <returns>The image handle, 0 on failure.</returns>
+    ImageResourceHandle CreateImage(const void* image_data, uint32_t width, uint32_t height);
+
+    /// <summary>
+    ///   Frees an image created with CreateImage, its region will be reused by the next images.
+    /// </summary>
+    /// <param name="image">
+    ///   The image handle. Its safe to call with a stale or invalid handle.
+    /// </param>
+    void ReleaseImage(ImageResourceHandle image);
+
+    /// <summary>
+    ///   Get the page texture and UV rectangle of an image created with CreateImage.
+    ///   Call it from OverlayProc, some renderers only resolve textures on their render thread.
+    /// </summary>
+    /// <param name="image">
+    ///   The image handle.
+    /// </param>
+    /// <param name="infos">
+    ///   Filled with the image page texture and UV rectangle.
+    /// </param>
+    /// <returns>false if the handle is stale or invalid. The texture is nullptr while the renderer can't give it yet.</returns>
+    bool GetImage(ImageResourceHandle image, Atlas_Image& infos) const;
+
+    /// <summary>
+    ///   Frees all the images and atlas pages.
+    /// </summary>
+    void Clear();
+};
+
+}
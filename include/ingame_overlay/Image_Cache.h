@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer_Hook.h"
+#include "Slot_Map.h"
+
+namespace ingame_overlay {
+
+class Image_Cache
+{
+    struct Entry_t
+    {
+        uint64_t Hash;
+        uint32_t Width, Height;
+        // Number of CreateImage calls that returned this entry.
+        uint32_t References;
+        // Compressed RGBA copy, used to upload the image again after an eviction.
+        std::vector<uint8_t> CompressedPixels;
+        // 0 while evicted.
+        ImageResourceHandle Resource;
+        void* TextureId;
+        uint64_t LastDrawnFrame;
+    };
+
+    Renderer_Hook* _Renderer;
+    uint64_t _Budget;
+    uint64_t _UsedBytes;
+    uint64_t _FrameCount;
+    Slot_Map<Entry_t> _Images;
+    std::unordered_multimap<uint64_t, ImageResourceHandle> _ImagesByHash;
+    std::vector<uint8_t> _DecompressBuffer;
+
+    static uint64_t _TextureSize(Entry_t const& entry);
+    bool _Upload(Entry_t& entry, const void* image_data);
+    void _Evict(Entry_t& entry);
+    void _EnforceBudget();
+
+    Image_Cache(const Image_Cache&) = delete;
+    Image_Cache(Image_Cache&&) = delete;
+    Image_Cache& operator =(const Image_Cache&) = delete;
+    Image_Cache& operator =(Image_Cache&&) = delete;
+
+public:
+    /// <summary>
+    ///   Creates a cache that keeps the images created through it under a GPU memory budget.
+    /// </summary>
+    /// <param name="renderer">
+    ///   The renderer used to create the image resources.
+    /// </param>
+    /// <param name="budget">
+    ///   The GPU memory the cached images may use, in bytes. 0 means no limit.
+    /// </param>
+    Image_Cache(Renderer_Hook* renderer, uint64_t budget = 0);
+    ~Image_Cache();
+
+    /// <summary>
+    ///   Change the GPU memory budget, in bytes. 0 means no limit.
+    ///   Images above the budget are evicted on the next Update.
+    /// </summary>
+    void SetBudget(uint64_t budget);
+
+    uint64_t GetBudget() const;
+
+    /// <summary>
+    ///   Get the GPU memory used by the images currently uploaded, in bytes.
+    /// </summary>
+    uint64_t GetUsedBytes() const;
+
+    /// <summary>
+    ///   Caches an RGBA ordered buffer and uploads it to the GPU.
+    ///   Creating an image identical to a cached one returns the cached image handle.
+    /// </summary>
+    /// <param name="image_data">
+    ///   The RGBA buffer.
+    /// </param>
+    /// <param name="width">
+    ///   Your RGBA image width.
+    /// </param>
+    /// <param name="height">
+    ///   Your RGBA image height.
+    /// </param>
+    /// <returns>The image handle, 0 on failure. Each successful call must be matched by a ReleaseImage.</returns>
+    ImageResourceHandle CreateImage(const void* image_data, uint32_t width, uint32_t height);
+
+    /// <summary>
+    ///   Drops a reference to an image created with CreateImage, the image is freed with its last reference.
+    /// </summary>
+    /// <param name="image">
+    ///   The image handle. Its safe to call with a stale or invalid handle.
+    /// </param>
+    void ReleaseImage(ImageResourceHandle image);
+
+    /// <summary>
+    ///   Get the texture of an image, to be used as an ImTextureID. An evicted image is uploaded again.
+    ///   Call it every frame the image is drawn, it marks the image as used for the budget.
+    /// </summary>
+    /// <param name="image">
+    ///   The image handle.
+    /// </param>
+    /// <returns>The ImTextureID, nullptr if the handle is stale or the upload failed.</returns>
+    void* GetTexture(ImageResourceHandle image);
+
+    /// <summary>
+    ///   Starts a new frame, then evicts the least recently drawn images until the budget is met.
+    ///   Images whose texture was asked during the previous frame are never evicted.
+    ///   Call it once at the beginning of OverlayProc, before any GetTexture.
+    /// </summary>
+    void Update();
+
+    /// <summary>
+    ///   Frees all the images.
+    /// </summary>
+    void Clear();
+};
+
+}
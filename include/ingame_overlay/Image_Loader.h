@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Renderer_Hook.h"
+
+namespace ingame_overlay {
+
+enum class ImageLoadStatus
+{
+    // Waiting for a worker.
+    Queued,
+    // A worker is reading and decoding the image.
+    Decoding,
+    // Decoded, waiting for its upload in the hooked present.
+    Uploading,
+    Ready,
+    Failed,
+    Canceled,
+};
+
+/// <summary>
+///   Called from Image_Loader::Update each time a load changes status.
+/// </summary>
+/// <param name="request">The value returned by CreateImageResourceFromMemory or CreateImageResourceFromFile.</param>
+/// <param name="status">The new status of the load.</param>
+/// <param name="progress">Load progress between 0 and 1.</param>
+/// <param name="resource">The image resource once status is Ready, 0 otherwise.</param>
+using ImageLoadCallback = std::function<void(uint64_t request, ImageLoadStatus status, float progress, ImageResourceHandle resource)>;
+
+/// <summary>
+///   Decodes an encoded image (PNG, JPEG...) into tightly packed RGBA. Called from the worker threads.
+/// </summary>
+using ImageDecoder = std::function<bool(const void* encoded_data, size_t encoded_size, std::vector<uint8_t>& rgba, uint32_t& width, uint32_t& height)>;
+
+class Image_Loader
+{
+    struct Request_t;
+
+    struct Event_t
+    {
+        std::shared_ptr<Request_t> Request;
+        ImageLoadStatus Status;
+        float Progress;
+    };
+
+    Renderer_Hook* _Renderer;
+    // Guarded by _JobsMutex, each worker takes a copy with its job.
+    ImageDecoder _Decoder;
+    std::atomic<uint64_t> _NextRequest;
+    uint64_t _UploadBudget;
+
+    std::vector<std::thread> _Workers;
+    std::mutex _JobsMutex;
+    std::condition_variable _JobsCV;
+    std::deque<std::shared_ptr<Request_t>> _Jobs;
+    // Requests by id, for Cancel.
+    std::unordered_map<uint64_t, std::weak_ptr<Request_t>> _Requests;
+    bool _StopWorkers;
+
+    // Status changes filled by the workers. Update only try-locks it, so the render thread never waits on a worker.
+    std::mutex _EventsMutex;
+    std::vector<Event_t> _Events;
+    std::vector<Event_t> _EventsSwap;
+    // Decoded images waiting for their upload, only touched by Update.
+    std::deque<std::shared_ptr<Request_t>> _PendingUploads;
+
+    void _WorkerProc();
+    void _ProcessRequest(std::shared_ptr<Request_t> const& request, ImageDecoder const& decoder);
+    void _PushEvent(std::shared_ptr<Request_t> const& request, ImageLoadStatus status, float progress);
+    uint64_t _Enqueue(std::shared_ptr<Request_t> request);
+
+    Image_Loader(const Image_Loader&) = delete;
+    Image_Loader(Image_Loader&&) = delete;
+    Image_Loader& operator =(const Image_Loader&) = delete;
+    Image_Loader& operator =(Image_Loader&&) = delete;
+
+public:
+    /// <summary>
+    ///   Creates a loader that decodes images on its own worker threads and creates their resources with the renderer.
+    /// </summary>
+    /// <param name="renderer">
+    ///   The renderer used to create the image resources.
+    /// </param>
+    /// <param name="worker_count">
+    ///   The number of decoding threads.
+    /// </param>
+    Image_Loader(Renderer_Hook* renderer, uint32_t worker_count = 2);
+    ~Image_Loader();
+
+    /// <summary>
+    ///   Replace the image decoder. When built with USE_STB_IMAGE, the default decoder uses stb_image, otherwise there is no default decoder.
+    ///   Loads already taken by a worker keep the previous decoder.
+    /// </summary>
+    void SetDecoder(ImageDecoder decoder);
+
+    /// <summary>
+    ///   Change the number of bytes uploaded to the GPU by a single Update, at least one image is uploaded per Update. 0 means no limit.
+    /// </summary>
+    void SetUploadBudget(uint64_t bytes_per_frame);
+
+    /// <summary>
+    ///   Decodes an encoded image on a worker thread and creates its resource in a following Update. Never blocks.
+    /// </summary>
+    /// <param name="encoded_data">
+    ///   The encoded image, it is copied.
+    /// </param>
+    /// <param name="encoded_size">
+    ///   The encoded image size in bytes.
+    /// </param>
+    /// <param name="max_width">
+    ///   The image is shrunk to fit this width, keeping its aspect ratio. 0 means no limit.
+    /// </param>
+    /// <param name="max_height">
+    ///   The image is shrunk to fit this height, keeping its aspect ratio. 0 means no limit.
+    /// </param>
+    /// <param name="callback">
+    ///   *Can be empty*. Called from Update with the load progress, see ImageLoadCallback.
+    /// </param>
+    /// <returns>The load request, never 0.</returns>
+    uint64_t CreateImageResourceFromMemory(const void* encoded_data, size_t encoded_size, uint32_t max_width, uint32_t max_height, ImageLoadCallback callback);
+
+    /// <summary>
+    ///   Same as CreateImageResourceFromMemory, the file is read by the worker thread.
+    /// </summary>
+    uint64_t CreateImageResourceFromFile(std::string const& path, uint32_t max_width, uint32_t max_height, ImageLoadCallback callback);
+
+    /// <summary>
+    ///   Cancels a load, its callback is called with the Canceled status if it didn't complete yet.
+    /// </summary>
+    void Cancel(uint64_t request);
+
+    /// <summary>
+    ///   Uploads the decoded images within the upload budget and calls the load callbacks.
+    ///   Call it from OverlayProc, so the uploads happen in the hooked present.
+    /// </summary>
+    void Update();
+};
+
+}
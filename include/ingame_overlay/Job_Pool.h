@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ingame_overlay {
+
+enum class JobPriority
+{
+    // Runs before any Normal or Low job, like work the user is waiting for.
+    High,
+    Normal,
+    // Prefetching and other work nobody waits for.
+    Low,
+};
+
+struct JobOptions
+{
+    JobPriority Priority = JobPriority::Normal;
+    // Index of the worker the job should run on, -1 for any. Jobs sharing a worker run in order and keep their data in
+    // the same cache unless an idle worker steals them.
+    int32_t Worker = -1;
+};
+
+struct JobPoolOptions
+{
+    // Worker threads count, 0 for Job_Pool::DefaultWorkerCount().
+    uint32_t WorkerCount = 0;
+    // CPUs the workers may run on, bit N for CPU N. 0 leaves it to the system. Not supported on MacOS.
+    uint64_t CpuMask = 0;
+    // Runs the workers below the normal thread priority, so the game threads get the CPU first.
+    bool BelowNormalPriority = true;
+};
+
+// Small work-stealing thread pool for the overlay background work, like data fetching, image decoding or text layout.
+// Each worker has its own queues, an idle worker steals the newest jobs of the others, higher priorities first.
+// A job completion runs on the render thread: DrainCompletions pops them from a lock-free queue, call it from OverlayProc.
+//
+//   auto layout = std::make_shared<text_layout_t>();
+//   pool.Submit([layout, text]() { layout->Build(text); }, [layout]() { overlay_datas->layout = std::move(*layout); });
+class Job_Pool
+{
+public:
+    using Job = std::function<void()>;
+
+private:
+    struct Worker_t;
+    struct Completions_t;
+
+    std::vector<std::unique_ptr<Worker_t>> _Workers;
+    std::unique_ptr<Completions_t> _Completions;
+    std::atomic<uint32_t> _NextWorker;
+    // Jobs submitted and not started yet, the workers sleep when it's 0.
+    std::atomic<size_t> _QueuedJobs;
+    std::mutex _SleepMutex;
+    std::condition_variable _SleepCV;
+    bool _Stop;
+
+    void _WorkerProc(uint32_t index, JobPoolOptions options);
+    bool _PopJob(uint32_t index, Job& job);
+    void _Push(Job job, JobOptions const& options);
+
+    Job_Pool(const Job_Pool&) = delete;
+    Job_Pool(Job_Pool&&) = delete;
+    Job_Pool& operator =(const Job_Pool&) = delete;
+    Job_Pool& operator =(Job_Pool&&) = delete;
+
+public:
+    /// <summary>
+    ///   A quarter of the hardware threads, between 1 and 4, so most cores are left to the game.
+    /// </summary>
+    static uint32_t DefaultWorkerCount();
+
+    Job_Pool(JobPoolOptions const& options = JobPoolOptions());
+
+    /// <summary>
+    ///   Stops the workers after their current job. The jobs not started and the completions not drained are dropped.
+    /// </summary>
+    ~Job_Pool();
+
+    uint32_t WorkerCount() const;
+
+    /// <summary>
+    ///   Runs a job on a worker. Never blocks, can be called from any thread, including a job.
+    /// </summary>
+    void Submit(Job job, JobOptions const& options = JobOptions());
+
+    /// <summary>
+    ///   Runs a job on a worker, then its completion on the next DrainCompletions.
+    /// </summary>
+    /// <param name="job">
+    ///   The job, run on a worker thread.
+    /// </param>
+    /// <param name="completion">
+    ///   Run on the render thread after job, share the job result through both captures.
+    /// </param>
+    void Submit(Job job, Job completion, JobOptions const& options = JobOptions());
+
+    /// <summary>
+    ///   Posts a completion without a job, to run it on the render thread. Never blocks, can be called from any thread.
+    /// </summary>
+    void PostCompletion(Job completion);
+
+    /// <summary>
+    ///   Runs the completions of the finished jobs. Call it from OverlayProc, always from the same thread.
+    /// </summary>
+    /// <param name="max_count">
+    ///   The most completions to run, 0 means no limit.
+    /// </param>
+    /// <returns>The completions count run.</returns>
+    size_t DrainCompletions(size_t max_count = 0);
+};
+
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+namespace ingame_overlay {
+
+/// <summary>
+///   Bounded multiple producers, single consumer queue, to send commands from the game or worker threads to Renderer_Hook::OverlayProc.
+///   TryPush never blocks and fails when the queue is full, Consume runs from OverlayProc without ever waiting on a producer.
+///   Commands are consumed in the order their TryPush reserved their slot.
+/// </summary>
+template<typename T, size_t Capacity>
+class Command_Queue
+{
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Command_Queue capacity must be a power of 2.");
+
+    struct Cell_t
+    {
+        // Slot position + 1 once its value is written, slot position + Capacity once it's consumed.
+        std::atomic<size_t> Sequence;
+        T Value;
+    };
+
+    Cell_t _Cells[Capacity];
+    // Producers side, next slot to reserve.
+    std::atomic<size_t> _Tail;
+    // Consumer side, next slot to read.
+    size_t _Head;
+
+    Command_Queue(const Command_Queue&) = delete;
+    Command_Queue(Command_Queue&&) = delete;
+    Command_Queue& operator =(const Command_Queue&) = delete;
+    Command_Queue& operator =(Command_Queue&&) = delete;
+
+public:
+    Command_Queue():
+        _Tail(0),
+        _Head(0)
+    {
+        for (size_t i = 0; i < Capacity; ++i)
+            _Cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool TryPush(T value)
+    {
+        size_t position = _Tail.load(std::memory_order_relaxed);
+        Cell_t* cell;
+        for (;;)
+        {
+            cell = &_Cells[position & (Capacity - 1)];
+            const size_t sequence = cell->Sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0)
+            {
+                if (_Tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (difference < 0)
+            {// The consumer didn't read this slot yet, the queue is full.
+                return false;
+            }
+            else
+            {// Another producer took this slot.
+                position = _Tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->Value = std::move(value);
+        cell->Sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& value)
+    {
+        Cell_t& cell = _Cells[_Head & (Capacity - 1)];
+        // A producer that reserved this slot but didn't write it yet hides the commands behind it until the next call.
+        if (cell.Sequence.load(std::memory_order_acquire) != _Head + 1)
+            return false;
+
+        value = std::move(cell.Value);
+        cell.Value = T();
+        cell.Sequence.store(_Head + Capacity, std::memory_order_release);
+        ++_Head;
+        return true;
+    }
+
+    /// <summary>
+    ///   Calls consumer with every command ready, at most Capacity of them so a flood of producers can't hold the frame.
+    /// </summary>
+    /// <returns>The consumed commands count.</returns>
+    template<typename F>
+    size_t Consume(F&& consumer)
+    {
+        T value;
+        size_t count = 0;
+        while (count < Capacity && TryPop(value))
+        {
+            consumer(value);
+            ++count;
+        }
+
+        return count;
+    }
+};
+
+/// <summary>
+///   Latest published value of a state shared with Renderer_Hook::OverlayProc, triple buffered.
+///   Writers never wait for the reader, they only wait for each other. Read is wait-free and must always be called by the same reader, usually OverlayProc.
+///   The reference returned by Read stays valid until the next Read.
+/// </summary>
+template<typename T>
+class State_Snapshot
+{
+    static constexpr uint32_t IndexMask = 3;
+    static constexpr uint32_t DirtyBit = 4;
+
+    T _Buffers[3];
+    // Buffer handed between the writers and the reader, with DirtyBit when it holds a value the reader didn't take yet.
+    std::atomic<uint32_t> _Middle;
+    // Writers side.
+    std::mutex _WriterMutex;
+    T _Latest;
+    uint32_t _Back;
+    // Reader side.
+    uint32_t _Front;
+
+    State_Snapshot(const State_Snapshot&) = delete;
+    State_Snapshot(State_Snapshot&&) = delete;
+    State_Snapshot& operator =(const State_Snapshot&) = delete;
+    State_Snapshot& operator =(State_Snapshot&&) = delete;
+
+public:
+    State_Snapshot():
+        _Middle(1),
+        _Back(2),
+        _Front(0)
+    {}
+
+    /// <summary>
+    ///   Changes the latest state with update(T&) and publishes it to the reader.
+    /// </summary>
+    template<typename F>
+    void Update(F&& update)
+    {
+        std::lock_guard<std::mutex> lock(_WriterMutex);
+        update(_Latest);
+        _Buffers[_Back] = _Latest;
+        _Back = _Middle.exchange(_Back | DirtyBit, std::memory_order_acq_rel) & IndexMask;
+    }
+
+    void Publish(T value)
+    {
+        Update([&value](T& state) { state = std::move(value); });
+    }
+
+    T const& Read()
+    {
+        if ((_Middle.load(std::memory_order_relaxed) & DirtyBit) != 0)
+            _Front = _Middle.exchange(_Front, std::memory_order_acq_rel) & IndexMask;
+
+        return _Buffers[_Front];
+    }
+};
+
+}
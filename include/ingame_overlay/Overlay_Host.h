@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Renderer_Hook.h"
+
+namespace ingame_overlay {
+
+class Job_Pool;
+
+// Plain 64 bits handle to an Overlay_Host client. 0 is never a valid handle.
+using OverlayClientHandle = uint64_t;
+
+struct OverlayClientOptions
+{
+    // Shown in the logs only.
+    std::string Name;
+    // Draw order of the clients with their own context, lower layers first. Negative layers are drawn under the host context windows.
+    int32_t Layer = 0;
+    // When false, Proc runs in the host ImGui frame, like a plain OverlayProc.
+    // When true, the client gets its own ImGuiContext sharing the host font atlas, its draw data is merged in the host frame.
+    bool OwnContext = false;
+    std::function<void()> Proc;
+};
+
+struct OverlayHostOptions
+{
+    // *Can be nullptr*. Builds the frames of the own context clients in parallel on this pool, the render thread waits for them.
+    // Only set it when ImGui is built with a thread local GImGui (see IMGUI_USER_CONFIG), their procs must then only build UI,
+    // the renderer functions like GetImageResourceTexture stay on the render thread.
+    Job_Pool* BuildPool = nullptr;
+};
+
+// Lets several overlay components share one Renderer_Hook and one frame. The host takes the renderer OverlayProc and runs the
+// clients procs from it. Clients with their own context are built in their ImGuiContext, then their draw lists are appended to
+// the host draw lists, so the renderer still submits a single ImDrawData with a single render state save and restore.
+// The mouse buttons go to the own context client hovered at the last frame, the keyboard to the last one clicked.
+//
+//   Overlay_Host host(renderer);
+//   host.AddClient({ "perf_hud", 10, true, []() { DrawPerfHud(); } });
+//   host.AddClient({ "chat", 0, true, []() { DrawChat(); } });
+class Overlay_Host
+{
+    struct Client_t;
+    struct Inputs_t;
+
+    Renderer_Hook* _Renderer;
+    Job_Pool* _BuildPool;
+    std::atomic<OverlayClientHandle> _NextHandle;
+
+    // AddClient and RemoveClient only queue their change, so a client proc can call them.
+    std::mutex _ChangesMutex;
+    std::vector<std::unique_ptr<Client_t>> _AddedClients;
+    std::vector<OverlayClientHandle> _RemovedClients;
+
+    // Render thread side, sorted by layer.
+    std::vector<std::unique_ptr<Client_t>> _Clients;
+    Client_t* _MouseOwner;
+    Client_t* _KeyboardOwner;
+    bool _MouseWasDown;
+
+    void _OverlayProc();
+    void _ApplyChanges();
+    void _PickInputOwners(bool host_wants_mouse, bool mouse_down);
+    void _BuildClientFrame(Client_t& client, Inputs_t const& inputs);
+
+    Overlay_Host(const Overlay_Host&) = delete;
+    Overlay_Host(Overlay_Host&&) = delete;
+    Overlay_Host& operator =(const Overlay_Host&) = delete;
+    Overlay_Host& operator =(Overlay_Host&&) = delete;
+
+public:
+    /// <summary>
+    ///   Creates a host and sets it as the renderer OverlayProc.
+    /// </summary>
+    Overlay_Host(Renderer_Hook* renderer, OverlayHostOptions const& options = OverlayHostOptions());
+
+    /// <summary>
+    ///   Clears the renderer OverlayProc and destroys the clients contexts. Destroy it when the renderer doesn't draw a frame.
+    /// </summary>
+    ~Overlay_Host();
+
+    /// <summary>
+    ///   Adds a client, its proc runs from the next frame. Can be called from any thread, including a client proc.
+    /// </summary>
+    /// <returns>The client handle, 0 if options.Proc is empty.</returns>
+    OverlayClientHandle AddClient(OverlayClientOptions options);
+
+    /// <summary>
+    ///   Removes a client, its proc doesn't run from the next frame. Can be called from any thread, including a client proc.
+    /// </summary>
+    /// <param name="client">
+    ///   The client handle. Its safe to call with a stale or invalid handle.
+    /// </param>
+    void RemoveClient(OverlayClientHandle client);
+};
+
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Renderer_Hook.h"
+
+class Shared_Memory;
+
+namespace ingame_overlay {
+
+enum class RemoteInputType : uint32_t
+{
+    // X, Y: the mouse position.
+    MousePos,
+    // Code: the ImGuiMouseButton, Value: 1 when pressed.
+    MouseButton,
+    // X, Y: the horizontal and vertical wheel steps.
+    MouseWheel,
+    // Code: the named ImGuiKey or ImGuiMod_* modifier, Value: 1 when pressed.
+    Key,
+    // Code: an UTF-16 code unit, for io.AddInputCharacterUTF16.
+    Character,
+    // X, Y: the game display size, frames larger than it are cropped.
+    DisplaySize,
+};
+
+// Input event sent by the game to the overlay process, the fields map to the ImGuiIO Add*Event functions.
+struct RemoteInputEvent
+{
+    RemoteInputType Type;
+    int32_t Code;
+    int32_t Value;
+    float X;
+    float Y;
+};
+
+// Shared memory channel between the game and an overlay process rendering the UI out of the game.
+// The game creates it, the overlay process opens it by name. Frames go from the overlay process to the game through 3 slots,
+// each guarded by a seqlock: the writer never waits and the game always reads the newest complete frame, a torn read is retried.
+// Inputs go from the game to the overlay process through a single producer, single consumer ring.
+// Names are shm_open names on Linux and MacOS ("/my_overlay"), file mapping names on Windows ("Local\\my_overlay").
+class Remote_Overlay_Channel
+{
+    struct Header_t;
+
+    std::unique_ptr<Shared_Memory> _Memory;
+    Header_t* _Header;
+    uint8_t* _Pixels;
+    // Game side, the last frame read.
+    uint64_t _LastFrame;
+
+    // The pixel buffers start on the page after the header.
+    static size_t _PixelsOffset();
+
+    Remote_Overlay_Channel(const Remote_Overlay_Channel&) = delete;
+    Remote_Overlay_Channel(Remote_Overlay_Channel&&) = delete;
+    Remote_Overlay_Channel& operator =(const Remote_Overlay_Channel&) = delete;
+    Remote_Overlay_Channel& operator =(Remote_Overlay_Channel&&) = delete;
+
+public:
+    // Input events waiting for the overlay process, PushInput fails when they are all used.
+    static constexpr uint32_t InputCapacity = 256;
+
+    Remote_Overlay_Channel();
+    ~Remote_Overlay_Channel();
+
+    /// <summary>
+    ///   Creates the channel, from the game process.
+    /// </summary>
+    /// <param name="max_width">The largest frame width the overlay process can publish.</param>
+    /// <param name="max_height">The largest frame height the overlay process can publish.</param>
+    bool Create(std::string const& name, uint32_t max_width, uint32_t max_height);
+
+    /// <summary>
+    ///   Opens a channel created by the game, from the overlay process.
+    /// </summary>
+    bool Open(std::string const& name);
+
+    void Close();
+
+    bool IsOpen() const;
+    uint32_t MaxWidth() const;
+    uint32_t MaxHeight() const;
+
+    /// <summary>
+    ///   Overlay process side, publishes a frame. Never blocks, only one thread may publish.
+    /// </summary>
+    /// <param name="premultiplied_rgba">RGBA pixels, color channels premultiplied by alpha.</param>
+    /// <param name="width">The frame width, 0 hides the overlay.</param>
+    /// <param name="height">The frame height.</param>
+    /// <param name="stride">The byte count between two rows. 0 means the rows are tightly packed.</param>
+    /// <returns>false if the frame is larger than the channel maximum size.</returns>
+    bool PublishFrame(const void* premultiplied_rgba, uint32_t width, uint32_t height, uint32_t stride = 0);
+
+    /// <summary>
+    ///   Overlay process side, pops the oldest input event. Only one thread may pop.
+    /// </summary>
+    bool PopInput(RemoteInputEvent& input_event);
+
+    /// <summary>
+    ///   Game side, copies the newest complete frame if it wasn't read yet.
+    /// </summary>
+    /// <returns>true if a new frame has been copied, width is 0 when the overlay is hidden.</returns>
+    bool ReadFrame(std::vector<uint8_t>& premultiplied_rgba, uint32_t& width, uint32_t& height);
+
+    /// <summary>
+    ///   Game side, sends an input event. Never blocks, only one thread may push.
+    /// </summary>
+    /// <returns>false if the ring is full, the overlay process is not reading.</returns>
+    bool PushInput(RemoteInputEvent const& input_event);
+};
+
+// Game side of a Remote_Overlay_Channel: draws the overlay process frames with a single textured quad under the ImGui
+// windows and forwards the overlay inputs. Call Update from OverlayProc, the inputs are the ones the platform hooks gave
+// to ImGui, so the input policy applies to the overlay process too.
+//
+//   compositor.Create("/my_overlay", 1920, 1080);
+//   renderer->OverlayProc = [&]() { compositor.Update(); };
+class Remote_Overlay_Compositor
+{
+    Renderer_Hook* _Renderer;
+    Remote_Overlay_Channel _Channel;
+    std::vector<uint8_t> _Frame;
+    std::vector<uint8_t> _StraightFrame;
+    ImageResourceHandle _Image;
+    uint32_t _ImageWidth;
+    uint32_t _ImageHeight;
+
+    // Inputs already sent, only the changes are forwarded.
+    float _DisplayWidth, _DisplayHeight;
+    float _MouseX, _MouseY;
+    uint32_t _MouseButtons;
+    std::vector<bool> _KeysDown;
+    // ImGuiMod_* flags.
+    uint32_t _KeyMods;
+
+    void _ForwardInputs();
+    void _Push(RemoteInputType type, int32_t code, int32_t value, float x, float y);
+
+    Remote_Overlay_Compositor(const Remote_Overlay_Compositor&) = delete;
+    Remote_Overlay_Compositor(Remote_Overlay_Compositor&&) = delete;
+    Remote_Overlay_Compositor& operator =(const Remote_Overlay_Compositor&) = delete;
+    Remote_Overlay_Compositor& operator =(Remote_Overlay_Compositor&&) = delete;
+
+public:
+    Remote_Overlay_Compositor(Renderer_Hook* renderer);
+    ~Remote_Overlay_Compositor();
+
+    /// <summary>
+    ///   Creates the channel the overlay process opens, see Remote_Overlay_Channel::Create.
+    /// </summary>
+    bool Create(std::string const& name, uint32_t max_width, uint32_t max_height);
+
+    /// <summary>
+    ///   Forwards the inputs, uploads the newest frame if it changed and draws it. Call it from OverlayProc.
+    /// </summary>
+    void Update();
+};
+
+}
@@ -21,14 +21,69 @@
 
 #include <future>
 #include <chrono>
+#include <functional>
 #include <memory>
 
+#if defined(__has_include)
+    #if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+        #include <coroutine>
+        #define INGAMEOVERLAY_HAS_COROUTINES
+    #endif
+#endif
+
 #include "Renderer_Hook.h"
 
 namespace ingame_overlay {
 
+// Receives the detected renderer, or nullptr when the timeout expired or the detection was stopped.
+// Called from the detection thread, it must not call StopRendererDetection or FreeDetector.
+using RendererDetectionCallback = std::function<void(Renderer_Hook*)>;
+
+/// <summary>
+///   Starts a renderer detection. Every detection runs on one detection thread, concurrent calls share the same probe.
+/// </summary>
+/// <param name="callback">
+///   Called once with the result.
+/// </param>
+/// <param name="timeout">
+///   How long to wait for the renderer, a negative timeout waits until it is found or the detection is stopped.
+/// </param>
+void DetectRenderer(RendererDetectionCallback callback, std::chrono::milliseconds timeout = std::chrono::milliseconds{ -1 });
 std::future<Renderer_Hook*> DetectRenderer(std::chrono::milliseconds timeout = std::chrono::milliseconds{ -1 });
 void StopRendererDetection();
 void FreeDetector();
 
+#if defined(INGAMEOVERLAY_HAS_COROUTINES)
+// co_await DetectRendererAsync(timeout) in a coroutine, it resumes on the detection thread.
+class RendererDetectionAwaitable
+{
+    std::chrono::milliseconds _Timeout;
+    Renderer_Hook* _Renderer;
+
+public:
+    explicit RendererDetectionAwaitable(std::chrono::milliseconds timeout):
+        _Timeout(timeout),
+        _Renderer(nullptr)
+    {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        DetectRenderer([this, handle](Renderer_Hook* renderer)
+        {
+            _Renderer = renderer;
+            handle.resume();
+        }, _Timeout);
+    }
+
+    Renderer_Hook* await_resume() const noexcept { return _Renderer; }
+};
+
+inline RendererDetectionAwaitable DetectRendererAsync(std::chrono::milliseconds timeout = std::chrono::milliseconds{ -1 })
+{
+    return RendererDetectionAwaitable(timeout);
+}
+#endif
+
 }
\ No newline at end of file
@@ -25,6 +25,8 @@
 #include <cstdint>
 #include <set>
 
+#include "Frame_Scheduler.h"
+
 namespace ingame_overlay {
 
 enum class ToggleKey
@@ -34,6 +36,63 @@ enum class ToggleKey
     F1, F2, F3, F4, F5, F6, F7, F8, F9, F10, F11, F12,
 };
 
+// Input policy flags, see Renderer_Hook::SetInputPolicy.
+enum InputPolicyFlags : uint32_t
+{
+    InputPolicy_None              = 0,
+    // Mouse and keyboard inputs are hidden from the hooked application.
+    InputPolicy_HideAppInputs     = 1 << 0,
+    // Mouse and keyboard inputs are hidden from the overlay.
+    InputPolicy_HideOverlayInputs = 1 << 1,
+};
+
+// Plain 64 bits handle to an image resource, see Slot_Map. 0 is never a valid handle.
+using ImageResourceHandle = uint64_t;
+
+// Byte order of the pixels given to CreateImageResource.
+enum class PixelFormat
+{
+    RGBA,
+    BGRA,
+    RGB,
+    BGR,
+};
+
+enum class AlphaMode
+{
+    // Color channels are not multiplied by alpha, what ImGui expects.
+    Straight,
+    // Color channels are already multiplied by alpha, they are divided back on upload.
+    Premultiplied,
+};
+
+struct ImageResourceOptions
+{
+    // Builds the mip chain and samples it with trilinear filtering, for images drawn smaller than their size.
+    bool Mipmaps = false;
+    // Images wider or taller than this are shrunk before upload, keeping their aspect ratio. 0 means no limit.
+    uint32_t MaxSize = 0;
+};
+
+// GPU block compressed formats accepted by CreateCompressedImageResource, all made of 4x4 pixels blocks.
+enum class CompressedFormat
+{
+    // DXT1, RGB with 1 bit alpha, 8 bytes blocks.
+    BC1,
+    // DXT3, RGBA with 4 bits explicit alpha, 16 bytes blocks.
+    BC2,
+    // DXT5, RGBA with interpolated alpha, 16 bytes blocks.
+    BC3,
+    // RGTC1, red only, 8 bytes blocks.
+    BC4,
+    // RGTC2, red and green, 16 bytes blocks.
+    BC5,
+    // ETC2 RGB, 8 bytes blocks.
+    ETC2_RGB,
+    // ETC2 RGB with EAC alpha, 16 bytes blocks.
+    ETC2_RGBA,
+};
+
 class Renderer_Hook
 {
 public:
@@ -41,6 +100,8 @@ public:
 
     std::function<void()> OverlayProc;
     std::function<void(bool)> OverlayHookReady;
+    // Tasks spread over several frames, their steps run after OverlayProc.
+    Frame_Scheduler FrameScheduler;
 
     /// <summary>
     ///   Starts the current renderer hook procedure, allowing a user to render things on the application window.
@@ -77,10 +138,33 @@ public:
     /// <returns></returns>
     virtual void HideOverlayInputs(bool hide) = 0;
 
+    /// <summary>
+    ///   Changes several input policy flags in one atomic step, the input thread never sees half of the change.
+    ///   Lock-free, it can be called from any thread. SetInputPolicy(0, 0) reads the current policy.
+    /// </summary>
+    /// <param name="mask">
+    ///   The InputPolicyFlags to change.
+    /// </param>
+    /// <param name="flags">
+    ///   The new value of the flags in mask, the other bits are ignored.
+    /// </param>
+    /// <returns>The InputPolicyFlags before the change.</returns>
+    virtual uint32_t SetInputPolicy(uint32_t mask, uint32_t flags) = 0;
+
+    /// <summary>
+    ///   Flips input policy flags in one atomic step, like SetInputPolicy.
+    ///   ToggleInputPolicy(InputPolicy_HideAppInputs | InputPolicy_HideOverlayInputs) shows or hides an overlay from any thread.
+    /// </summary>
+    /// <param name="flags">
+    ///   The InputPolicyFlags to flip.
+    /// </param>
+    /// <returns>The InputPolicyFlags before the change.</returns>
+    virtual uint32_t ToggleInputPolicy(uint32_t flags) = 0;
+
     virtual bool IsStarted() = 0;
 
     /// <summary>
-    ///   Load an RGBA ordered buffer into GPU and returns a handle to this ressource to be used by ImGui.
+    ///   Load an RGBA ordered buffer into GPU and returns a handle to this ressource, use GetImageResourceTexture to draw it with ImGui.
     /// </summary>
     /// <param name="image_data">
     ///   The RGBA buffer.
@@ -91,16 +175,133 @@ public:
     /// <param name="height">
     ///   Your RGBA image height.
     /// </param>
-    /// <returns></returns>
-    virtual std::weak_ptr<uint64_t> CreateImageResource(const void* image_data, uint32_t width, uint32_t height) = 0;
+    /// <returns>The resource handle, 0 on failure.</returns>
+    virtual ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height) = 0;
+
+    /// <summary>
+    ///   Load a buffer of any PixelFormat into GPU and returns a handle to this ressource, use GetImageResourceTexture to draw it with ImGui.
+    ///   The pixels are converted to straight RGBA on the way in, when the renderer can't take them as is.
+    /// </summary>
+    /// <param name="image_data">
+    ///   The pixels buffer.
+    /// </param>
+    /// <param name="width">
+    ///   Your image width.
+    /// </param>
+    /// <param name="height">
+    ///   Your image height.
+    /// </param>
+    /// <param name="format">
+    ///   The byte order of a pixel in image_data.
+    /// </param>
+    /// <param name="stride">
+    ///   The byte count between two rows of image_data. 0 means the rows are tightly packed.
+    /// </param>
+    /// <param name="alpha_mode">
+    ///   Whether the color channels of image_data are premultiplied by alpha. Ignored for formats without alpha.
+    /// </param>
+    /// <returns>The resource handle, 0 on failure.</returns>
+    virtual ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, PixelFormat format, uint32_t stride = 0, AlphaMode alpha_mode = AlphaMode::Straight) = 0;
+
+    /// <summary>
+    ///   Load an RGBA ordered buffer into GPU like CreateImageResource, with mip levels and a size clamp.
+    /// </summary>
+    /// <param name="image_data">
+    ///   The RGBA buffer.
+    /// </param>
+    /// <param name="width">
+    ///   Your RGBA image width.
+    /// </param>
+    /// <param name="height">
+    ///   Your RGBA image height.
+    /// </param>
+    /// <param name="options">
+    ///   How to build the resource. Renderers that can't sample mip levels ignore ImageResourceOptions::Mipmaps.
+    /// </param>
+    /// <returns>The resource handle, 0 on failure. UpdateImageResource only updates the first mip level.</returns>
+    virtual ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ImageResourceOptions const& options) = 0;
+
+    /// <summary>
+    ///   Load a block compressed buffer into GPU and returns a handle to this ressource, use GetImageResourceTexture to draw it with ImGui.
+    ///   The blocks are uploaded as is when the renderer supports the format, else they are decompressed to RGBA on the CPU.
+    /// </summary>
+    /// <param name="compressed_data">
+    ///   The blocks, row after row, without padding between rows.
+    /// </param>
+    /// <param name="compressed_size">
+    ///   The compressed_data size in bytes, at least ((width + 3) / 4) * ((height + 3) / 4) * block size.
+    /// </param>
+    /// <param name="width">
+    ///   Your image width.
+    /// </param>
+    /// <param name="height">
+    ///   Your image height.
+    /// </param>
+    /// <param name="format">
+    ///   The compression format of compressed_data.
+    /// </param>
+    /// <returns>The resource handle, 0 on failure. Block compressed resources can't be updated with UpdateImageResource.</returns>
+    virtual ImageResourceHandle CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, CompressedFormat format) = 0;
 
     /// <summary>
     ///   Frees a previously image resource created with CreateImageResource.
     /// </summary>
     /// <param name="resource">
-    ///   The weak_ptr to the resource. Its safe to call with an invalid weak_ptr.
+    ///   The resource handle. Its safe to call with a stale or invalid handle.
+    /// </param>
+    virtual void ReleaseImageResource(ImageResourceHandle resource) = 0;
+
+    /// <summary>
+    ///   Updates a rectangle of a previously created image resource without reallocating it.
+    /// </summary>
+    /// <param name="resource">
+    ///   The resource handle.
+    /// </param>
+    /// <param name="x">
+    ///   Left of the rectangle to update, in pixels.
+    /// </param>
+    /// <param name="y">
+    ///   Top of the rectangle to update, in pixels.
+    /// </param>
+    /// <param name="width">
+    ///   Width of the rectangle to update, in pixels.
+    /// </param>
+    /// <param name="height">
+    ///   Height of the rectangle to update, in pixels.
+    /// </param>
+    /// <param name="image_data">
+    ///   The RGBA buffer of the rectangle.
+    /// </param>
+    /// <param name="stride">
+    ///   The byte count between two rows of image_data. 0 means the rows are tightly packed (width * 4).
+    /// </param>
+    /// <returns>true if the rectangle has been uploaded.</returns>
+    virtual bool UpdateImageResource(ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride = 0) = 0;
+
+    /// <summary>
+    ///   Get the texture of an image resource, to be used as an ImTextureID.
+    ///   Call it from OverlayProc, some renderers only resolve textures on their render thread.
+    /// </summary>
+    /// <param name="resource">
+    ///   The resource handle.
     /// </param>
-    virtual void ReleaseImageResource(std::weak_ptr<uint64_t> resource) = 0;
+    /// <returns>The ImTextureID, nullptr if the handle is stale or invalid.</returns>
+    virtual /*ImTextureID*/ void* GetImageResourceTexture(ImageResourceHandle resource) = 0;
+
+    /// <summary>
+    ///   Makes the next draw commands of an ImDrawList read their texture alpha as a signed distance field,
+    ///   like the pages of a Glyph_Cache in GlyphRasterMode::SignedDistanceField. Call it from OverlayProc.
+    /// </summary>
+    /// <param name="imgui_draw_list">
+    ///   The ImDrawList.
+    /// </param>
+    /// <returns>false if the renderer has no distance field shader, nothing is added to the draw list.</returns>
+    virtual bool BeginSdfDraw(/*ImDrawList* */ void* imgui_draw_list) = 0;
+
+    /// <summary>
+    ///   Goes back to the ImGui shader after a successful BeginSdfDraw.
+    /// </summary>
+    virtual void EndSdfDraw(/*ImDrawList* */ void* imgui_draw_list) = 0;
 
     /// <summary>
     ///   Get the current renderer library name.
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <utility>
+
+namespace ingame_overlay {
+
+/// <summary>
+///   Stores values in reusable slots and addresses them with 64 bits handles.
+///   A handle is the slot index in its low 32 bits and the slot generation in its high 32 bits.
+///   The generation changes every time a slot is freed, so a stale handle never reaches the next value stored in the same slot.
+///   0 is never a valid handle.
+/// </summary>
+template<typename T>
+class Slot_Map
+{
+    static constexpr uint32_t InvalidIndex = 0xffffffff;
+
+    struct Slot_t
+    {
+        T Value;
+        // Odd when the slot is in use, even when it is free.
+        uint32_t Generation;
+        uint32_t NextFree;
+    };
+
+    std::vector<Slot_t> _Slots;
+    uint32_t _FreeHead;
+    size_t _Count;
+
+    static inline uint64_t _MakeHandle(uint32_t index, uint32_t generation)
+    {
+        return (static_cast<uint64_t>(generation) << 32) | index;
+    }
+
+    Slot_t* _GetSlot(uint64_t handle)
+    {
+        const uint32_t index = static_cast<uint32_t>(handle);
+        const uint32_t generation = static_cast<uint32_t>(handle >> 32);
+
+        if (index >= _Slots.size() || _Slots[index].Generation != generation || (generation & 1) == 0)
+            return nullptr;
+
+        return &_Slots[index];
+    }
+
+public:
+    Slot_Map():
+        _FreeHead(InvalidIndex),
+        _Count(0)
+    {}
+
+    uint64_t Insert(T value)
+    {
+        uint32_t index;
+        if (_FreeHead != InvalidIndex)
+        {
+            index = _FreeHead;
+            _FreeHead = _Slots[index].NextFree;
+        }
+        else
+        {
+            index = static_cast<uint32_t>(_Slots.size());
+            _Slots.emplace_back(Slot_t{ T(), 0, InvalidIndex });
+        }
+
+        Slot_t& slot = _Slots[index];
+        slot.Value = std::move(value);
+        ++slot.Generation;
+        slot.NextFree = InvalidIndex;
+        ++_Count;
+
+        return _MakeHandle(index, slot.Generation);
+    }
+
+    T* Get(uint64_t handle)
+    {
+        Slot_t* slot = _GetSlot(handle);
+        return slot == nullptr ? nullptr : &slot->Value;
+    }
+
+    const T* Get(uint64_t handle) const
+    {
+        return const_cast<Slot_Map*>(this)->Get(handle);
+    }
+
+    /// <summary>
+    ///   Frees the slot addressed by handle and moves its value into value.
+    /// </summary>
+    /// <returns>false if handle is stale or invalid.</returns>
+    bool Remove(uint64_t handle, T& value)
+    {
+        Slot_t* slot = _GetSlot(handle);
+        if (slot == nullptr)
+            return false;
+
+        value = std::move(slot->Value);
+        slot->Value = T();
+        // Skip 0 on wrap around, so a reused slot never gives back handle 0.
+        if (++slot->Generation == 0)
+            slot->Generation = 2;
+
+        slot->NextFree = _FreeHead;
+        _FreeHead = static_cast<uint32_t>(slot - _Slots.data());
+        --_Count;
+
+        return true;
+    }
+
+    template<typename F>
+    void ForEach(F&& func)
+    {
+        for (uint32_t i = 0; i < _Slots.size(); ++i)
+        {
+            if ((_Slots[i].Generation & 1) != 0)
+                func(_MakeHandle(i, _Slots[i].Generation), _Slots[i].Value);
+        }
+    }
+
+    /// <summary>
+    ///   Frees all the slots. The slots are kept so handles given before stay stale.
+    /// </summary>
+    void Clear()
+    {
+        _FreeHead = InvalidIndex;
+        for (uint32_t i = static_cast<uint32_t>(_Slots.size()); i-- > 0;)
+        {
+            Slot_t& slot = _Slots[i];
+            if ((slot.Generation & 1) != 0)
+            {
+                slot.Value = T();
+                if (++slot.Generation == 0)
+                    slot.Generation = 2;
+            }
+            slot.NextFree = _FreeHead;
+            _FreeHead = i;
+        }
+        _Count = 0;
+    }
+
+    size_t Size() const
+    {
+        return _Count;
+    }
+};
+
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Asset_Pack.h>
+
+#include "internal_includes.h"
+#include "Texture_Decompress.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if !defined(_WIN32)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace ingame_overlay {
+
+Asset_Pack::Asset_Pack():
+    _File(nullptr),
+    _Mapping(nullptr),
+    _Data(nullptr),
+    _Size(0),
+    _Entries(nullptr),
+    _AssetCount(0)
+{}
+
+Asset_Pack::~Asset_Pack()
+{
+    Close();
+}
+
+bool Asset_Pack::_Validate() const
+{
+    if (_Size < sizeof(AssetPackHeader_t))
+        return false;
+
+    const AssetPackHeader_t* header = reinterpret_cast<const AssetPackHeader_t*>(_Data);
+    if (memcmp(header->Magic, AssetPackMagic, sizeof(AssetPackMagic)) != 0 || header->Version != AssetPackVersion)
+        return false;
+
+    if (header->AssetCount > (_Size - sizeof(AssetPackHeader_t)) / sizeof(AssetPackEntry_t))
+        return false;
+
+    const AssetPackEntry_t* entries = reinterpret_cast<const AssetPackEntry_t*>(_Data + sizeof(AssetPackHeader_t));
+    for (uint32_t i = 0; i < header->AssetCount; ++i)
+    {
+        AssetPackEntry_t const& entry = entries[i];
+        if (entry.NameOffset > _Size || entry.NameSize > _Size - entry.NameOffset ||
+            entry.DataOffset > _Size || entry.DataSize > _Size - entry.DataOffset)
+            return false;
+
+        switch (static_cast<AssetType>(entry.Type))
+        {
+            case AssetType::Image:
+                if (entry.DataSize < static_cast<uint64_t>(entry.Width) * entry.Height * 4)
+                    return false;
+                break;
+
+            case AssetType::CompressedImage:
+                if (Texture_Decompress::BlockSize(static_cast<CompressedFormat>(entry.Format)) == 0 ||
+                    entry.DataSize < Texture_Decompress::CompressedSize(static_cast<CompressedFormat>(entry.Format), entry.Width, entry.Height))
+                    return false;
+                break;
+
+            case AssetType::Blob:
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool Asset_Pack::Open(std::string const& path)
+{
+    Close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SPDLOG_WARN("Failed to open asset pack {}.", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    HANDLE mapping = nullptr;
+    const void* data = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+
+    if (data == nullptr)
+    {
+        SPDLOG_WARN("Failed to map asset pack {}.", path);
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+
+        CloseHandle(file);
+        return false;
+    }
+
+    _File = file;
+    _Mapping = mapping;
+    _Data = reinterpret_cast<const uint8_t*>(data);
+    _Size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+        SPDLOG_WARN("Failed to open asset pack {}.", path);
+        return false;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // The mapping keeps the file alive.
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SPDLOG_WARN("Failed to map asset pack {}.", path);
+        return false;
+    }
+
+    _Data = reinterpret_cast<const uint8_t*>(data);
+    _Size = static_cast<size_t>(st.st_size);
+#endif
+
+    if (!_Validate())
+    {
+        SPDLOG_WARN("Failed to load asset pack {}: invalid or unsupported pack.", path);
+        Close();
+        return false;
+    }
+
+    _Entries = reinterpret_cast<const AssetPackEntry_t*>(_Data + sizeof(AssetPackHeader_t));
+    _AssetCount = reinterpret_cast<const AssetPackHeader_t*>(_Data)->AssetCount;
+    return true;
+}
+
+void Asset_Pack::Close()
+{
+    if (_Data != nullptr)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(_Data);
+        CloseHandle(reinterpret_cast<HANDLE>(_Mapping));
+        CloseHandle(reinterpret_cast<HANDLE>(_File));
+#else
+        munmap(const_cast<uint8_t*>(_Data), _Size);
+#endif
+    }
+
+    _File = nullptr;
+    _Mapping = nullptr;
+    _Data = nullptr;
+    _Size = 0;
+    _Entries = nullptr;
+    _AssetCount = 0;
+}
+
+bool Asset_Pack::IsOpen() const
+{
+    return _Data != nullptr;
+}
+
+uint32_t Asset_Pack::AssetCount() const
+{
+    return _AssetCount;
+}
+
+const AssetPackEntry_t* Asset_Pack::GetAsset(uint32_t index) const
+{
+    return index < _AssetCount ? &_Entries[index] : nullptr;
+}
+
+const AssetPackEntry_t* Asset_Pack::FindAsset(std::string const& name) const
+{
+    // The packer sorts the index by name.
+    const AssetPackEntry_t* end = _Entries + _AssetCount;
+    const AssetPackEntry_t* it = std::lower_bound(_Entries, end, name, [this](AssetPackEntry_t const& entry, std::string const& value)
+    {
+        const int result = memcmp(_Data + entry.NameOffset, value.data(), std::min<size_t>(entry.NameSize, value.size()));
+        return result < 0 || (result == 0 && entry.NameSize < value.size());
+    });
+
+    if (it == end || it->NameSize != name.size() || memcmp(_Data + it->NameOffset, name.data(), name.size()) != 0)
+        return nullptr;
+
+    return it;
+}
+
+std::string Asset_Pack::GetAssetName(AssetPackEntry_t const& asset) const
+{
+    return std::string(reinterpret_cast<const char*>(_Data + asset.NameOffset), asset.NameSize);
+}
+
+const void* Asset_Pack::GetAssetData(AssetPackEntry_t const& asset) const
+{
+    return _Data + asset.DataOffset;
+}
+
+ImageResourceHandle Asset_Pack::CreateImageResource(Renderer_Hook* renderer, AssetPackEntry_t const& asset) const
+{
+    switch (static_cast<AssetType>(asset.Type))
+    {
+        case AssetType::Image:
+        {
+            ImageResourceOptions options;
+            options.Mipmaps = (asset.Flags & AssetFlag_Mipmaps) != 0;
+            return renderer->CreateImageResource(GetAssetData(asset), asset.Width, asset.Height, options);
+        }
+
+        case AssetType::CompressedImage:
+            return renderer->CreateCompressedImageResource(GetAssetData(asset), static_cast<size_t>(asset.DataSize), asset.Width, asset.Height, static_cast<CompressedFormat>(asset.Format));
+
+        default:
+            return 0;
+    }
+}
+
+}
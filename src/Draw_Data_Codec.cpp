@@ -0,0 +1,926 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Draw_Data_Codec.h>
+
+#include "internal_includes.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+    #define DRAW_DATA_CODEC_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace ingame_overlay {
+
+static constexpr uint32_t DrawDataMagic = 0x44444749; // 'IGDD'
+static constexpr float PositionScale = 64.0f;
+// UVs in [0, 1] are stored as 16 bits unsigned normalized values.
+static constexpr float UvScale = 65535.0f;
+// Escapes of the fixed width fields, the full value follows.
+static constexpr int16_t PositionEscape = INT16_MIN;
+static constexpr int8_t IndexEscape = INT8_MIN;
+static constexpr uint8_t ColorEscape = 0xFF;
+
+enum class ListTag : uint8_t
+{
+    Encoded,
+    // Same as the list at the same position in the reference frame.
+    Repeat,
+};
+
+enum class CmdKind : uint8_t
+{
+    Draw,
+    ResetRenderState,
+};
+
+enum class UvFormat : uint8_t
+{
+    // Every UV of the list is in [0, 1].
+    Unorm16,
+    Float,
+};
+
+// Rounds like cvtps2dq, to the nearest even integer and INT32_MIN when out of range.
+static inline uint32_t Quantize(float value, float scale)
+{
+    const float scaled = value * scale;
+    if (!(std::fabs(scaled) < 2147483648.0f))
+        return 0x80000000u;
+
+    // Adding 1.5 * 2^52 leaves the rounded value in the low bits of the double mantissa.
+    const double rounded = static_cast<double>(scaled) + 6755399441055744.0;
+    uint64_t bits;
+    memcpy(&bits, &rounded, sizeof(bits));
+    return static_cast<uint32_t>(bits);
+}
+
+static inline uint8_t* WriteVarint(uint8_t* output, uint32_t value)
+{
+    // Most values fit in 1 or 2 bytes, UV deltas between glyphs in 3.
+    if (value < (1u << 7))
+    {
+        output[0] = static_cast<uint8_t>(value);
+        return output + 1;
+    }
+
+    if (value < (1u << 14))
+    {
+        output[0] = static_cast<uint8_t>(value | 0x80);
+        output[1] = static_cast<uint8_t>(value >> 7);
+        return output + 2;
+    }
+
+    if (value < (1u << 21))
+    {
+        output[0] = static_cast<uint8_t>(value | 0x80);
+        output[1] = static_cast<uint8_t>((value >> 7) | 0x80);
+        output[2] = static_cast<uint8_t>(value >> 14);
+        return output + 3;
+    }
+
+    while (value >= 0x80)
+    {
+        *output++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *output++ = static_cast<uint8_t>(value);
+    return output;
+}
+
+static inline uint8_t* WriteVarint64(uint8_t* output, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *output++ = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    *output++ = static_cast<uint8_t>(value);
+    return output;
+}
+
+template<typename T>
+static inline uint8_t* WriteRaw(uint8_t* output, T value)
+{
+    memcpy(output, &value, sizeof(value));
+    return output + sizeof(value);
+}
+
+// Fixed width fields with a rare escape, the branch is almost always predicted unlike the varint lengths.
+static inline uint8_t* WritePositionDelta(uint8_t* output, int32_t delta)
+{
+    if (delta > PositionEscape && delta <= INT16_MAX)
+        return WriteRaw(output, static_cast<int16_t>(delta));
+
+    output = WriteRaw(output, PositionEscape);
+    return WriteRaw(output, delta);
+}
+
+static inline uint8_t* WriteIndexDelta(uint8_t* output, int32_t delta)
+{
+    if (delta > IndexEscape && delta <= INT8_MAX)
+        return WriteRaw(output, static_cast<int8_t>(delta));
+
+    output = WriteRaw(output, IndexEscape);
+    return WriteRaw(output, delta);
+}
+
+static inline uint8_t* WriteColorIndex(uint8_t* output, uint32_t color_index)
+{
+    if (color_index < ColorEscape)
+    {
+        *output = static_cast<uint8_t>(color_index);
+        return output + 1;
+    }
+
+    *output++ = ColorEscape;
+    return WriteVarint(output, color_index);
+}
+
+struct Reader_t
+{
+    const uint8_t* Current;
+    const uint8_t* End;
+    bool Valid;
+
+    uint32_t Varint()
+    {
+        if (End - Current >= 5)
+        {// Far enough from the end to skip the bound checks.
+            const uint8_t* bytes = Current;
+            uint32_t value = bytes[0] & 0x7F;
+            if (bytes[0] < 0x80) { Current += 1; return value; }
+            value |= static_cast<uint32_t>(bytes[1] & 0x7F) << 7;
+            if (bytes[1] < 0x80) { Current += 2; return value; }
+            value |= static_cast<uint32_t>(bytes[2] & 0x7F) << 14;
+            if (bytes[2] < 0x80) { Current += 3; return value; }
+            value |= static_cast<uint32_t>(bytes[3] & 0x7F) << 21;
+            if (bytes[3] < 0x80) { Current += 4; return value; }
+            value |= static_cast<uint32_t>(bytes[4]) << 28;
+            if (bytes[4] < 0x80) { Current += 5; return value; }
+
+            Valid = false;
+            return 0;
+        }
+
+        uint32_t value = 0;
+        for (uint32_t shift = 0; shift < 35; shift += 7)
+        {
+            if (Current == End)
+                break;
+
+            const uint8_t byte = *Current++;
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+
+        Valid = false;
+        return 0;
+    }
+
+    uint64_t Varint64()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 70; shift += 7)
+        {
+            if (Current == End)
+                break;
+
+            const uint8_t byte = *Current++;
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0)
+                return value;
+        }
+
+        Valid = false;
+        return 0;
+    }
+
+    template<typename T>
+    T Raw()
+    {
+        T value{};
+        if (static_cast<size_t>(End - Current) < sizeof(T))
+        {
+            Valid = false;
+            return value;
+        }
+
+        memcpy(&value, Current, sizeof(T));
+        Current += sizeof(T);
+        return value;
+    }
+
+    int32_t PositionDelta()
+    {
+        const int16_t delta = Raw<int16_t>();
+        return delta != PositionEscape ? delta : Raw<int32_t>();
+    }
+
+    int32_t IndexDelta()
+    {
+        const int8_t delta = Raw<int8_t>();
+        return delta != IndexEscape ? delta : Raw<int32_t>();
+    }
+
+    uint32_t ColorIndex()
+    {
+        const uint8_t color_index = Raw<uint8_t>();
+        return color_index != ColorEscape ? color_index : Varint();
+    }
+
+    // Guards the counts read from the data, so a corrupted count can't allocate gigabytes.
+    bool HasAtLeast(size_t count) const
+    {
+        return Valid && static_cast<size_t>(End - Current) >= count;
+    }
+};
+
+// Hash of the draw list content, only used to spot the lists that didn't change.
+// 4 independent lanes, so the multiplications of a lane don't wait for the previous word.
+static inline uint64_t MixWord(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+    return hash ^ (hash >> 29);
+}
+
+static inline uint64_t HashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    uint64_t lanes[4] = { hash ^ (size * 0x9E3779B97F4A7C15ull), hash + 1, hash + 2, hash + 3 };
+    while (size >= 32)
+    {
+        uint64_t words[4];
+        memcpy(words, bytes, 32);
+        lanes[0] = MixWord(lanes[0], words[0]);
+        lanes[1] = MixWord(lanes[1], words[1]);
+        lanes[2] = MixWord(lanes[2], words[2]);
+        lanes[3] = MixWord(lanes[3], words[3]);
+        bytes += 32;
+        size -= 32;
+    }
+
+    while (size >= 8)
+    {
+        uint64_t word;
+        memcpy(&word, bytes, 8);
+        lanes[0] = MixWord(lanes[0], word);
+        bytes += 8;
+        size -= 8;
+    }
+
+    uint64_t tail = 0;
+    memcpy(&tail, bytes, size);
+    hash = MixWord(lanes[0], tail);
+    hash = MixWord(hash, lanes[1]);
+    hash = MixWord(hash, lanes[2]);
+    hash = MixWord(hash, lanes[3]);
+    return hash * 0xC4CEB9FE1A85EC53ull;
+}
+
+static uint64_t HashDrawList(ImDrawList const* list)
+{
+    // The command fields are mixed in directly, a HashBytes call per field costs more than the fields.
+    uint64_t hash = static_cast<uint64_t>(list->CmdBuffer.Size);
+    for (ImDrawCmd const& cmd : list->CmdBuffer)
+    {
+        uint64_t clip_rect[2];
+        memcpy(clip_rect, &cmd.ClipRect, sizeof(clip_rect));
+        hash = MixWord(hash, clip_rect[0]);
+        hash = MixWord(hash, clip_rect[1]);
+        hash = MixWord(hash, reinterpret_cast<uint64_t>(cmd.GetTexID()));
+        hash = MixWord(hash, reinterpret_cast<uint64_t>(cmd.UserCallback));
+        hash = MixWord(hash, cmd.VtxOffset | (static_cast<uint64_t>(cmd.IdxOffset) << 32));
+        hash = MixWord(hash, cmd.ElemCount);
+    }
+
+    hash = HashBytes(hash, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+    return HashBytes(hash, list->IdxBuffer.Data, list->IdxBuffer.Size * sizeof(ImDrawIdx));
+}
+
+// Writes the positions and the UVs of the list.
+// Returns nullptr for Unorm16 when a UV isn't in [0, 1], the list is then written with float UVs.
+template<UvFormat Format>
+static uint8_t* WriteVertices(uint8_t* output, ImDrawList const* list)
+{
+    uint32_t x = 0, y = 0;
+    for (ImDrawVert const& vertex : list->VtxBuffer)
+    {
+        const uint32_t qx = Quantize(vertex.pos.x, PositionScale);
+        const uint32_t qy = Quantize(vertex.pos.y, PositionScale);
+        const int32_t dx = static_cast<int32_t>(qx - x);
+        const int32_t dy = static_cast<int32_t>(qy - y);
+        x = qx; y = qy;
+        if (dx > PositionEscape && dx <= INT16_MAX && dy > PositionEscape && dy <= INT16_MAX)
+        {// Both deltas in one store.
+            output = WriteRaw(output, static_cast<uint32_t>(static_cast<uint16_t>(dx)) | (static_cast<uint32_t>(static_cast<uint16_t>(dy)) << 16));
+        }
+        else
+        {
+            output = WritePositionDelta(output, dx);
+            output = WritePositionDelta(output, dy);
+        }
+
+        if (Format == UvFormat::Unorm16)
+        {
+            if (!((vertex.uv.x >= 0.0f) & (vertex.uv.x <= 1.0f) & (vertex.uv.y >= 0.0f) & (vertex.uv.y <= 1.0f)))
+                return nullptr;
+
+            output = WriteRaw(output, (Quantize(vertex.uv.x, UvScale) & 0xFFFF) | (Quantize(vertex.uv.y, UvScale) << 16));
+        }
+        else
+        {
+            output = WriteRaw(output, vertex.uv.x);
+            output = WriteRaw(output, vertex.uv.y);
+        }
+    }
+
+    return output;
+}
+
+static uint8_t* WriteIndices(uint8_t* output, const ImDrawIdx* indices, size_t count, int32_t previous_index)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        output = WriteIndexDelta(output, static_cast<int32_t>(indices[i]) - previous_index);
+        previous_index = static_cast<int32_t>(indices[i]);
+    }
+
+    return output;
+}
+
+#if defined(DRAW_DATA_CODEC_SSE2)
+// Same output as WriteVertices<UvFormat::Unorm16>, the position and the UV of a vertex are quantized as one vector.
+static uint8_t* Sse2WriteUnorm16Vertices(uint8_t* output, ImDrawList const* list)
+{
+    const __m128 scale = _mm_setr_ps(PositionScale, PositionScale, UvScale, UvScale);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i escape = _mm_set1_epi32(PositionEscape);
+    const __m128i limit = _mm_set1_epi32(INT16_MAX + 1);
+    // The UVs go through the signed saturating pack biased by -32768, the xor removes the bias of the 16 bits values.
+    const __m128i uv_bias = _mm_setr_epi32(0, 0, 32768, 32768);
+    const __m128i uv_unbias = _mm_setr_epi16(0, 0, static_cast<int16_t>(0x8000), static_cast<int16_t>(0x8000), 0, 0, 0, 0);
+    __m128i previous = _mm_setzero_si128();
+    for (ImDrawVert const& vertex : list->VtxBuffer)
+    {
+        const __m128 value = _mm_loadu_ps(&vertex.pos.x);
+        if ((_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(value, zero), _mm_cmple_ps(value, one))) & 0xC) != 0xC)
+            return nullptr;
+
+        const __m128i quantized = _mm_cvtps_epi32(_mm_mul_ps(value, scale));
+        const __m128i delta = _mm_sub_epi32(quantized, previous);
+        previous = _mm_move_epi64(quantized);
+
+        const __m128i packed = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(delta, uv_bias), delta), uv_unbias);
+        const __m128i fits = _mm_and_si128(_mm_cmpgt_epi32(delta, escape), _mm_cmplt_epi32(delta, limit));
+        if ((_mm_movemask_ps(_mm_castsi128_ps(fits)) & 0x3) == 0x3)
+        {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output), packed);
+            output += 8;
+        }
+        else
+        {
+            output = WritePositionDelta(output, _mm_cvtsi128_si32(delta));
+            output = WritePositionDelta(output, _mm_cvtsi128_si32(_mm_srli_si128(delta, 4)));
+            output = WriteRaw(output, _mm_cvtsi128_si32(_mm_srli_si128(packed, 4)));
+        }
+    }
+
+    return output;
+}
+
+// Same output as WriteIndices, 8 indices at a time when all their deltas fit in 8 bits.
+static uint8_t* Sse2WriteIndices(uint8_t* output, const ImDrawIdx* indices, size_t count)
+{
+    if (sizeof(ImDrawIdx) != sizeof(uint16_t))
+        return WriteIndices(output, indices, count, 0);
+
+    const __m128i max_delta = _mm_set1_epi16(INT8_MAX);
+    uint16_t previous_index = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+        const __m128i previous = _mm_or_si128(_mm_slli_si128(current, 2), _mm_cvtsi32_si128(previous_index));
+        // Saturated differences both ways, a delta fits when neither is above 127.
+        const __m128i up = _mm_subs_epu16(current, previous);
+        const __m128i down = _mm_subs_epu16(previous, current);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_subs_epu16(_mm_or_si128(up, down), max_delta), _mm_setzero_si128())) == 0xFFFF)
+        {
+            const __m128i delta = _mm_sub_epi16(current, previous);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packs_epi16(delta, delta));
+            output += 8;
+        }
+        else
+        {
+            output = WriteIndices(output, indices + i, 8, previous_index);
+        }
+
+        previous_index = static_cast<uint16_t>(indices[i + 7]);
+    }
+
+    return WriteIndices(output, indices + i, count - i, previous_index);
+}
+#endif
+
+static inline bool KeepCmd(ImDrawCmd const& cmd)
+{
+    return cmd.UserCallback == nullptr || cmd.UserCallback == ImDrawCallback_ResetRenderState;
+}
+
+Draw_Data_Encoder::Draw_Data_Encoder():
+    _FrameNumber(0),
+    _ForceKeyframe(true)
+{}
+
+void Draw_Data_Encoder::Reset()
+{
+    _ForceKeyframe = true;
+}
+
+uint32_t Draw_Data_Encoder::_PaletteIndex(uint32_t color)
+{
+    // Open addressing, slots hold index + 1, the table is kept at most half full.
+    size_t mask = _PaletteTable.size() - 1;
+    size_t slot = (color * 0x9E3779B1u) & mask;
+    while (_PaletteTable[slot] != 0)
+    {
+        if (_Palette[_PaletteTable[slot] - 1] == color)
+            return _PaletteTable[slot] - 1;
+
+        slot = (slot + 1) & mask;
+    }
+
+    const uint32_t index = static_cast<uint32_t>(_Palette.size());
+    _Palette.emplace_back(color);
+    _PaletteTable[slot] = index + 1;
+
+    if (_Palette.size() * 2 > _PaletteTable.size())
+    {
+        _PaletteTable.assign(_PaletteTable.size() * 2, 0);
+        mask = _PaletteTable.size() - 1;
+        for (uint32_t i = 0; i < _Palette.size(); ++i)
+        {
+            slot = (_Palette[i] * 0x9E3779B1u) & mask;
+            while (_PaletteTable[slot] != 0)
+                slot = (slot + 1) & mask;
+
+            _PaletteTable[slot] = i + 1;
+        }
+    }
+
+    return index;
+}
+
+uint32_t Draw_Data_Encoder::_TextureIndex(uint64_t texture)
+{
+    // Frames use a handful of textures.
+    for (uint32_t i = 0; i < _Textures.size(); ++i)
+    {
+        if (_Textures[i] == texture)
+            return i;
+    }
+
+    _Textures.emplace_back(texture);
+    return static_cast<uint32_t>(_Textures.size() - 1);
+}
+
+void Draw_Data_Encoder::Encode(const void* imgui_draw_data, std::vector<uint8_t>& output, bool keyframe)
+{
+    const ImDrawData* draw_data = reinterpret_cast<const ImDrawData*>(imgui_draw_data);
+    const int list_count = (draw_data != nullptr && draw_data->Valid) ? draw_data->CmdListsCount : 0;
+
+    keyframe = keyframe || _ForceKeyframe;
+    _ForceKeyframe = false;
+    ++_FrameNumber;
+
+    _Palette.clear();
+    _PaletteTable.assign(std::max<size_t>(_PaletteTable.size(), 1024), 0);
+    _Textures.clear();
+    _Hashes.resize(list_count);
+
+    // Worst case size first, then the body is written without bound checks.
+    size_t body_bound = 0;
+    for (int i = 0; i < list_count; ++i)
+    {
+        const ImDrawList* list = draw_data->CmdLists[i];
+        body_bound += 1 + 5 + static_cast<size_t>(list->CmdBuffer.Size) * (1 + 16 + 5 * 4) + 5 + 1 + static_cast<size_t>(list->VtxBuffer.Size) * (6 * 2 + 4 * 2 + 1 + 5) + 5 + static_cast<size_t>(list->IdxBuffer.Size) * 5;
+    }
+
+    if (_Body.size() < body_bound)
+        _Body.resize(body_bound);
+
+    uint8_t* body = _Body.data();
+    for (int i = 0; i < list_count; ++i)
+    {
+        const ImDrawList* list = draw_data->CmdLists[i];
+        _Hashes[i] = HashDrawList(list);
+
+        if (!keyframe && static_cast<size_t>(i) < _PreviousHashes.size() && _PreviousHashes[i] == _Hashes[i])
+        {
+            *body++ = static_cast<uint8_t>(ListTag::Repeat);
+            continue;
+        }
+
+        *body++ = static_cast<uint8_t>(ListTag::Encoded);
+
+        uint32_t cmd_count = 0;
+        for (ImDrawCmd const& cmd : list->CmdBuffer)
+            cmd_count += KeepCmd(cmd) ? 1 : 0;
+
+        body = WriteVarint(body, cmd_count);
+        for (ImDrawCmd const& cmd : list->CmdBuffer)
+        {
+            if (!KeepCmd(cmd))
+                continue;
+
+            if (cmd.UserCallback == ImDrawCallback_ResetRenderState)
+            {
+                *body++ = static_cast<uint8_t>(CmdKind::ResetRenderState);
+                continue;
+            }
+
+            *body++ = static_cast<uint8_t>(CmdKind::Draw);
+            body = WriteRaw(body, cmd.ClipRect.x);
+            body = WriteRaw(body, cmd.ClipRect.y);
+            body = WriteRaw(body, cmd.ClipRect.z);
+            body = WriteRaw(body, cmd.ClipRect.w);
+            body = WriteVarint(body, _TextureIndex(reinterpret_cast<uint64_t>(cmd.GetTexID())));
+            body = WriteVarint(body, cmd.VtxOffset);
+            body = WriteVarint(body, cmd.IdxOffset);
+            body = WriteVarint(body, cmd.ElemCount);
+        }
+
+        body = WriteVarint(body, static_cast<uint32_t>(list->VtxBuffer.Size));
+        uint8_t* const uv_format = body++;
+        uint8_t* const vertices = body;
+#if defined(DRAW_DATA_CODEC_SSE2)
+        body = Sse2WriteUnorm16Vertices(vertices, list);
+#else
+        body = WriteVertices<UvFormat::Unorm16>(vertices, list);
+#endif
+        *uv_format = static_cast<uint8_t>(UvFormat::Unorm16);
+        if (body == nullptr)
+        {// Rare, the list has tiled or procedural UVs.
+            body = WriteVertices<UvFormat::Float>(vertices, list);
+            *uv_format = static_cast<uint8_t>(UvFormat::Float);
+        }
+
+        // The anti-aliased shapes alternate 2 colors, they are looked up once.
+        uint32_t cached_colors[2] = { 0, 0 };
+        uint32_t cached_indices[2] = { _PaletteIndex(0), _PaletteIndex(0) };
+        for (ImDrawVert const& vertex : list->VtxBuffer)
+        {
+            uint32_t color_index;
+            if (vertex.col == cached_colors[0])
+            {
+                color_index = cached_indices[0];
+            }
+            else if (vertex.col == cached_colors[1])
+            {
+                color_index = cached_indices[1];
+                std::swap(cached_colors[0], cached_colors[1]);
+                std::swap(cached_indices[0], cached_indices[1]);
+            }
+            else
+            {
+                color_index = _PaletteIndex(vertex.col);
+                cached_colors[1] = cached_colors[0];
+                cached_indices[1] = cached_indices[0];
+                cached_colors[0] = vertex.col;
+                cached_indices[0] = color_index;
+            }
+            body = WriteColorIndex(body, color_index);
+        }
+
+        body = WriteVarint(body, static_cast<uint32_t>(list->IdxBuffer.Size));
+#if defined(DRAW_DATA_CODEC_SSE2)
+        body = Sse2WriteIndices(body, list->IdxBuffer.Data, static_cast<size_t>(list->IdxBuffer.Size));
+#else
+        body = WriteIndices(body, list->IdxBuffer.Data, static_cast<size_t>(list->IdxBuffer.Size), 0);
+#endif
+    }
+
+    _PreviousHashes.assign(_Hashes.begin(), _Hashes.end());
+
+    const size_t body_size = static_cast<size_t>(body - _Body.data());
+    // The header goes through its own buffer, output is only resized to the exact frame size, growing a vector zero fills it.
+    const size_t header_bound = 4 + 1 + 10 * 2 + 6 * 4 + 5 + _Textures.size() * 8 + 5 + _Palette.size() * 4 + 5;
+    if (_Header.size() < header_bound)
+        _Header.resize(header_bound);
+
+    uint8_t* out = _Header.data();
+    out = WriteRaw(out, DrawDataMagic);
+    *out++ = static_cast<uint8_t>(Version);
+    out = WriteVarint64(out, _FrameNumber);
+    out = WriteVarint64(out, keyframe ? 0 : _FrameNumber - 1);
+
+    const ImVec2 display_pos = draw_data != nullptr ? draw_data->DisplayPos : ImVec2(0.0f, 0.0f);
+    const ImVec2 display_size = draw_data != nullptr ? draw_data->DisplaySize : ImVec2(0.0f, 0.0f);
+    const ImVec2 framebuffer_scale = draw_data != nullptr ? draw_data->FramebufferScale : ImVec2(1.0f, 1.0f);
+    out = WriteRaw(out, display_pos.x);
+    out = WriteRaw(out, display_pos.y);
+    out = WriteRaw(out, display_size.x);
+    out = WriteRaw(out, display_size.y);
+    out = WriteRaw(out, framebuffer_scale.x);
+    out = WriteRaw(out, framebuffer_scale.y);
+
+    out = WriteVarint(out, static_cast<uint32_t>(_Textures.size()));
+    for (uint64_t texture : _Textures)
+        out = WriteRaw(out, texture);
+
+    out = WriteVarint(out, static_cast<uint32_t>(_Palette.size()));
+    for (uint32_t color : _Palette)
+        out = WriteRaw(out, color);
+
+    out = WriteVarint(out, static_cast<uint32_t>(list_count));
+
+    const size_t header_size = static_cast<size_t>(out - _Header.data());
+    output.resize(header_size + body_size);
+    memcpy(output.data(), _Header.data(), header_size);
+    memcpy(output.data() + header_size, _Body.data(), body_size);
+}
+
+Draw_Data_Decoder::Draw_Data_Decoder():
+    _DrawData(new ImDrawData()),
+    _FrameNumber(0)
+{}
+
+Draw_Data_Decoder::~Draw_Data_Decoder()
+{
+    for (ImDrawList* list : _Lists)
+        IM_DELETE(list);
+    for (ImDrawList* list : _PreviousLists)
+        IM_DELETE(list);
+    for (ImDrawList* list : _FreeLists)
+        IM_DELETE(list);
+}
+
+void Draw_Data_Decoder::SetTextureRemap(std::function<void*(uint64_t)> remap)
+{
+    _TextureRemap = std::move(remap);
+}
+
+ImDrawList* Draw_Data_Decoder::_AcquireList()
+{
+    if (_FreeLists.empty())
+        return IM_NEW(ImDrawList)(nullptr);
+
+    ImDrawList* list = _FreeLists.back();
+    _FreeLists.pop_back();
+    return list;
+}
+
+void* Draw_Data_Decoder::GetDrawData()
+{
+    return _DrawData->Valid ? _DrawData.get() : nullptr;
+}
+
+bool Draw_Data_Decoder::Decode(const void* data, size_t size)
+{
+    // The lists of the last frame become the ones the new frame can repeat.
+    for (ImDrawList* list : _PreviousLists)
+    {// The repeated ones moved to _Lists.
+        if (list != nullptr)
+            _FreeLists.emplace_back(list);
+    }
+
+    _PreviousLists.swap(_Lists);
+    _Lists.clear();
+
+    const uint64_t previous_frame = _FrameNumber;
+    _FrameNumber = 0;
+    _DrawData->Valid = false;
+    _DrawData->CmdListsCount = 0;
+    _DrawData->CmdLists = nullptr;
+
+    Reader_t reader{ reinterpret_cast<const uint8_t*>(data), reinterpret_cast<const uint8_t*>(data) + size, data != nullptr };
+    if (reader.Raw<uint32_t>() != DrawDataMagic || reader.Raw<uint8_t>() != Draw_Data_Encoder::Version || !reader.Valid)
+    {
+        SPDLOG_DEBUG("Failed to decode draw data: not draw data or another version.");
+        return false;
+    }
+
+    const uint64_t frame = reader.Varint64();
+    const uint64_t reference = reader.Varint64();
+    ImVec2 display_pos, display_size, framebuffer_scale;
+    display_pos.x = reader.Raw<float>();
+    display_pos.y = reader.Raw<float>();
+    display_size.x = reader.Raw<float>();
+    display_size.y = reader.Raw<float>();
+    framebuffer_scale.x = reader.Raw<float>();
+    framebuffer_scale.y = reader.Raw<float>();
+
+    const uint32_t texture_count = reader.Varint();
+    if (!reader.HasAtLeast(static_cast<size_t>(texture_count) * 8))
+        return false;
+
+    _Textures.resize(texture_count);
+    for (uint32_t i = 0; i < texture_count; ++i)
+    {
+        const uint64_t texture = reader.Raw<uint64_t>();
+        _Textures[i] = _TextureRemap ? _TextureRemap(texture) : reinterpret_cast<void*>(static_cast<uintptr_t>(texture));
+    }
+
+    const uint32_t palette_count = reader.Varint();
+    if (!reader.HasAtLeast(static_cast<size_t>(palette_count) * 4))
+        return false;
+
+    _Palette.resize(palette_count);
+    for (uint32_t i = 0; i < palette_count; ++i)
+        _Palette[i] = reader.Raw<uint32_t>();
+
+    const uint32_t list_count = reader.Varint();
+    if (!reader.HasAtLeast(list_count))
+        return false;
+
+    int total_vertices = 0;
+    int total_indices = 0;
+    for (uint32_t i = 0; i < list_count && reader.Valid; ++i)
+    {
+        const ListTag tag = static_cast<ListTag>(reader.Raw<uint8_t>());
+        if (tag == ListTag::Repeat)
+        {
+            if (reference == 0 || reference != previous_frame || i >= _PreviousLists.size() || _PreviousLists[i] == nullptr)
+            {
+                SPDLOG_DEBUG("Failed to decode draw data: frame {} repeats lists of frame {}, the last decoded frame is {}.", frame, reference, previous_frame);
+                reader.Valid = false;
+                break;
+            }
+
+            _Lists.emplace_back(_PreviousLists[i]);
+            _PreviousLists[i] = nullptr;
+        }
+        else if (tag == ListTag::Encoded)
+        {
+            ImDrawList* list = _AcquireList();
+            _Lists.emplace_back(list);
+
+            const uint32_t cmd_count = reader.Varint();
+            if (!reader.HasAtLeast(cmd_count))
+                break;
+
+            list->CmdBuffer.resize(static_cast<int>(cmd_count));
+            for (ImDrawCmd& cmd : list->CmdBuffer)
+            {
+                memset(&cmd, 0, sizeof(cmd));
+                const CmdKind kind = static_cast<CmdKind>(reader.Raw<uint8_t>());
+                if (kind == CmdKind::ResetRenderState)
+                {
+                    cmd.UserCallback = ImDrawCallback_ResetRenderState;
+                    continue;
+                }
+
+                cmd.ClipRect.x = reader.Raw<float>();
+                cmd.ClipRect.y = reader.Raw<float>();
+                cmd.ClipRect.z = reader.Raw<float>();
+                cmd.ClipRect.w = reader.Raw<float>();
+                const uint32_t texture = reader.Varint();
+                cmd.TextureId = texture < _Textures.size() ? static_cast<ImTextureID>(_Textures[texture]) : ImTextureID();
+                cmd.VtxOffset = reader.Varint();
+                cmd.IdxOffset = reader.Varint();
+                cmd.ElemCount = reader.Varint();
+                if (kind != CmdKind::Draw || texture >= _Textures.size())
+                    reader.Valid = false;
+            }
+
+            const uint32_t vertex_count = reader.Varint();
+            const UvFormat uv_format = static_cast<UvFormat>(reader.Raw<uint8_t>());
+            // At least 9 bytes per vertex.
+            if (!reader.HasAtLeast(static_cast<size_t>(vertex_count) * 9))
+                break;
+
+            if (uv_format != UvFormat::Unorm16 && uv_format != UvFormat::Float)
+            {
+                reader.Valid = false;
+                break;
+            }
+
+            list->VtxBuffer.resize(static_cast<int>(vertex_count));
+            // Wraps like the encoder.
+            uint32_t x = 0, y = 0;
+            for (ImDrawVert& vertex : list->VtxBuffer)
+            {
+                x += static_cast<uint32_t>(reader.PositionDelta());
+                y += static_cast<uint32_t>(reader.PositionDelta());
+                vertex.pos = ImVec2(static_cast<int32_t>(x) / PositionScale, static_cast<int32_t>(y) / PositionScale);
+                if (uv_format == UvFormat::Unorm16)
+                {
+                    const uint16_t u = reader.Raw<uint16_t>();
+                    const uint16_t v = reader.Raw<uint16_t>();
+                    vertex.uv = ImVec2(u / UvScale, v / UvScale);
+                }
+                else
+                {
+                    vertex.uv.x = reader.Raw<float>();
+                    vertex.uv.y = reader.Raw<float>();
+                }
+            }
+
+            for (ImDrawVert& vertex : list->VtxBuffer)
+            {
+                const uint32_t color = reader.ColorIndex();
+                vertex.col = color < _Palette.size() ? _Palette[color] : 0;
+                if (color >= _Palette.size())
+                    reader.Valid = false;
+            }
+
+            const uint32_t index_count = reader.Varint();
+            if (!reader.HasAtLeast(index_count))
+                break;
+
+            list->IdxBuffer.resize(static_cast<int>(index_count));
+            int64_t index = 0;
+            for (ImDrawIdx& out_index : list->IdxBuffer)
+            {
+                index += reader.IndexDelta();
+                if (index < 0 || index >= static_cast<int64_t>(vertex_count))
+                    reader.Valid = false;
+
+                out_index = static_cast<ImDrawIdx>(index);
+            }
+
+            // The renderer reads what the commands point at, a corrupted offset must not reach it.
+            for (ImDrawCmd const& cmd : list->CmdBuffer)
+            {
+                if (cmd.UserCallback != nullptr)
+                    continue;
+
+                if (static_cast<uint64_t>(cmd.IdxOffset) + cmd.ElemCount > index_count || (cmd.ElemCount != 0 && cmd.VtxOffset >= vertex_count))
+                {
+                    reader.Valid = false;
+                    break;
+                }
+
+                if (cmd.VtxOffset != 0)
+                {
+                    for (uint32_t j = 0; j < cmd.ElemCount; ++j)
+                    {
+                        if (static_cast<uint64_t>(cmd.VtxOffset) + list->IdxBuffer[cmd.IdxOffset + j] >= vertex_count)
+                        {
+                            reader.Valid = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        else
+        {
+            reader.Valid = false;
+        }
+    }
+
+    if (!reader.Valid || _Lists.size() != list_count)
+    {
+        for (ImDrawList* list : _Lists)
+            _FreeLists.emplace_back(list);
+
+        _Lists.clear();
+        return false;
+    }
+
+    for (ImDrawList* list : _Lists)
+    {
+        total_vertices += list->VtxBuffer.Size;
+        total_indices += list->IdxBuffer.Size;
+    }
+
+    _DrawData->Valid = true;
+    _DrawData->CmdListsCount = static_cast<int>(_Lists.size());
+    _DrawData->CmdLists = _Lists.data();
+    _DrawData->TotalVtxCount = total_vertices;
+    _DrawData->TotalIdxCount = total_indices;
+    _DrawData->DisplayPos = display_pos;
+    _DrawData->DisplaySize = display_size;
+    _DrawData->FramebufferScale = framebuffer_scale;
+
+    _FrameNumber = frame;
+    return true;
+}
+
+}
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Font_Atlas_Builder.h>
+
+#include "internal_includes.h"
+
+#include <imgui.h>
+#include <imgui_internal.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Same stb configuration as imgui_draw.cpp, so the rasterization matches the ImGui builder bit for bit.
+// Only the allocations differ: IM_ALLOC updates the ImGui context metrics, which is not thread safe.
+#define STBRP_STATIC
+#define STBRP_ASSERT(x)     do { IM_ASSERT(x); } while (0)
+#define STBRP_SORT          ImQsort
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+#define STBTT_malloc(x,u)   ((void)(u), malloc(x))
+#define STBTT_free(x,u)     ((void)(u), free(x))
+#define STBTT_assert(x)     do { IM_ASSERT(x); } while(0)
+#define STBTT_fmod(x,y)     ImFmod(x,y)
+#define STBTT_sqrt(x)       ImSqrt(x)
+#define STBTT_pow(x,y)      ImPow(x,y)
+#define STBTT_fabs(x)       ImFabs(x)
+#define STBTT_ifloor(x)     ((int)ImFloorSigned(x))
+#define STBTT_iceil(x)      ((int)ImCeil(x))
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imstb_truetype.h>
+
+namespace ingame_overlay {
+namespace Font_Atlas_Builder {
+
+// Glyphs rendered by a single task, small enough to balance large CJK ranges across the workers.
+static constexpr int GlyphsPerTask = 128;
+
+struct BuildSource_t
+{
+    stbtt_fontinfo FontInfo;
+    stbtt_pack_range PackRange;
+    stbrp_rect* Rects;
+    stbtt_packedchar* PackedChars;
+    const ImWchar* SrcRanges;
+    int DstIndex;
+    int GlyphsHighest;
+    int GlyphsCount;
+    ImBitVector GlyphsSet;
+    ImVector<int> GlyphsList;
+};
+
+struct BuildDestination_t
+{
+    int SrcCount;
+    int GlyphsHighest;
+    int GlyphsCount;
+    ImBitVector GlyphsSet;
+};
+
+struct RenderTask_t
+{
+    int Source;
+    int FirstGlyph;
+    int GlyphsCount;
+};
+
+static void UnpackBitVectorToFlatIndexList(const ImBitVector* in, ImVector<int>* out)
+{
+    const ImU32* it_begin = in->Storage.begin();
+    const ImU32* it_end = in->Storage.end();
+    for (const ImU32* it = it_begin; it < it_end; it++)
+        if (ImU32 entries_32 = *it)
+            for (ImU32 bit_n = 0; bit_n < 32; bit_n++)
+                if (entries_32 & ((ImU32)1 << bit_n))
+                    out->push_back((int)(((it - it_begin) << 5) + bit_n));
+}
+
+static void RenderGlyphs(ImFontAtlas* atlas, stbtt_pack_context const& spc, BuildSource_t& source, ImFontConfig const& cfg, RenderTask_t const& task)
+{
+    // stbtt_PackFontRangesRenderIntoRects writes the oversampling into the context, each task needs its own.
+    stbtt_pack_context task_spc = spc;
+    stbtt_pack_range range = source.PackRange;
+    range.array_of_unicode_codepoints += task.FirstGlyph;
+    range.num_chars = task.GlyphsCount;
+    range.chardata_for_range += task.FirstGlyph;
+
+    stbrp_rect* rects = source.Rects + task.FirstGlyph;
+    stbtt_PackFontRangesRenderIntoRects(&task_spc, &source.FontInfo, &range, 1, rects);
+
+    if (cfg.RasterizerMultiply != 1.0f)
+    {
+        unsigned char multiply_table[256];
+        ImFontAtlasBuildMultiplyCalcLookupTable(multiply_table, cfg.RasterizerMultiply);
+        for (int i = 0; i < task.GlyphsCount; ++i)
+        {
+            stbrp_rect const& r = rects[i];
+            if (r.was_packed)
+                ImFontAtlasBuildMultiplyRectAlpha8(multiply_table, atlas->TexPixelsAlpha8, r.x, r.y, r.w, r.h, atlas->TexWidth * 1);
+        }
+    }
+}
+
+static bool BuildAtlas(ImFontAtlas* atlas, uint32_t thread_count)
+{
+    IM_ASSERT(atlas->ConfigData.Size > 0);
+
+    ImFontAtlasBuildInit(atlas);
+
+    atlas->TexID = (ImTextureID)NULL;
+    atlas->TexWidth = atlas->TexHeight = 0;
+    atlas->TexUvScale = ImVec2(0.0f, 0.0f);
+    atlas->TexUvWhitePixel = ImVec2(0.0f, 0.0f);
+    atlas->ClearTexData();
+
+    // Everything but the rendering follows ImFontAtlasBuildWithStbTruetype, the packing must give the same layout.
+    std::vector<BuildSource_t> sources(atlas->ConfigData.Size);
+    std::vector<BuildDestination_t> destinations(atlas->Fonts.Size);
+    for (auto& source : sources)
+    {
+        source.Rects = nullptr;
+        source.PackedChars = nullptr;
+        source.SrcRanges = nullptr;
+        source.DstIndex = -1;
+        source.GlyphsHighest = 0;
+        source.GlyphsCount = 0;
+        memset(&source.FontInfo, 0, sizeof(source.FontInfo));
+        memset(&source.PackRange, 0, sizeof(source.PackRange));
+    }
+    for (auto& destination : destinations)
+    {
+        destination.SrcCount = 0;
+        destination.GlyphsHighest = 0;
+        destination.GlyphsCount = 0;
+    }
+
+    // 1. Load the fonts.
+    for (int src_i = 0; src_i < atlas->ConfigData.Size; ++src_i)
+    {
+        BuildSource_t& source = sources[src_i];
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        IM_ASSERT(cfg.DstFont && (!cfg.DstFont->IsLoaded() || cfg.DstFont->ContainerAtlas == atlas));
+
+        for (int output_i = 0; output_i < atlas->Fonts.Size && source.DstIndex == -1; ++output_i)
+            if (cfg.DstFont == atlas->Fonts[output_i])
+                source.DstIndex = output_i;
+
+        if (source.DstIndex == -1)
+        {
+            SPDLOG_WARN("Font {} doesn't target a font of its atlas.", cfg.Name);
+            return false;
+        }
+
+        const int font_offset = stbtt_GetFontOffsetForIndex((unsigned char*)cfg.FontData, cfg.FontNo);
+        if (font_offset < 0 || !stbtt_InitFont(&source.FontInfo, (unsigned char*)cfg.FontData, font_offset))
+        {
+            SPDLOG_WARN("Failed to load font {}.", cfg.Name);
+            return false;
+        }
+
+        BuildDestination_t& destination = destinations[source.DstIndex];
+        source.SrcRanges = cfg.GlyphRanges ? cfg.GlyphRanges : atlas->GetGlyphRangesDefault();
+        for (const ImWchar* src_range = source.SrcRanges; src_range[0] && src_range[1]; src_range += 2)
+            source.GlyphsHighest = ImMax(source.GlyphsHighest, (int)src_range[1]);
+
+        destination.SrcCount++;
+        destination.GlyphsHighest = ImMax(destination.GlyphsHighest, source.GlyphsHighest);
+    }
+
+    // 2. Keep the codepoints the fonts have, the first merged font providing a glyph wins.
+    int total_glyphs_count = 0;
+    for (auto& source : sources)
+    {
+        BuildDestination_t& destination = destinations[source.DstIndex];
+        source.GlyphsSet.Create(source.GlyphsHighest + 1);
+        if (destination.GlyphsSet.Storage.empty())
+            destination.GlyphsSet.Create(destination.GlyphsHighest + 1);
+
+        for (const ImWchar* src_range = source.SrcRanges; src_range[0] && src_range[1]; src_range += 2)
+        {
+            for (unsigned int codepoint = src_range[0]; codepoint <= src_range[1]; ++codepoint)
+            {
+                if (destination.GlyphsSet.TestBit(codepoint))
+                    continue;
+
+                if (!stbtt_FindGlyphIndex(&source.FontInfo, codepoint))
+                    continue;
+
+                source.GlyphsCount++;
+                destination.GlyphsCount++;
+                source.GlyphsSet.SetBit(codepoint);
+                destination.GlyphsSet.SetBit(codepoint);
+                total_glyphs_count++;
+            }
+        }
+    }
+
+    // 3. Flatten the sets into sorted codepoint lists.
+    for (auto& source : sources)
+    {
+        source.GlyphsList.reserve(source.GlyphsCount);
+        UnpackBitVectorToFlatIndexList(&source.GlyphsSet, &source.GlyphsList);
+        source.GlyphsSet.Clear();
+        IM_ASSERT(source.GlyphsList.Size == source.GlyphsCount);
+    }
+    destinations.clear();
+
+    std::vector<stbrp_rect> buf_rects(total_glyphs_count);
+    std::vector<stbtt_packedchar> buf_packedchars(total_glyphs_count);
+    if (total_glyphs_count > 0)
+    {
+        memset(buf_rects.data(), 0, sizeof(stbrp_rect) * buf_rects.size());
+        memset(buf_packedchars.data(), 0, sizeof(stbtt_packedchar) * buf_packedchars.size());
+    }
+
+    // 4. Gather the glyphs sizes.
+    int total_surface = 0;
+    int buf_out_n = 0;
+    for (int src_i = 0; src_i < (int)sources.size(); ++src_i)
+    {
+        BuildSource_t& source = sources[src_i];
+        if (source.GlyphsCount == 0)
+            continue;
+
+        source.Rects = &buf_rects[buf_out_n];
+        source.PackedChars = &buf_packedchars[buf_out_n];
+        buf_out_n += source.GlyphsCount;
+
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        source.PackRange.font_size = cfg.SizePixels;
+        source.PackRange.first_unicode_codepoint_in_range = 0;
+        source.PackRange.array_of_unicode_codepoints = source.GlyphsList.Data;
+        source.PackRange.num_chars = source.GlyphsList.Size;
+        source.PackRange.chardata_for_range = source.PackedChars;
+        source.PackRange.h_oversample = (unsigned char)cfg.OversampleH;
+        source.PackRange.v_oversample = (unsigned char)cfg.OversampleV;
+
+        const float scale = (cfg.SizePixels > 0) ? stbtt_ScaleForPixelHeight(&source.FontInfo, cfg.SizePixels) : stbtt_ScaleForMappingEmToPixels(&source.FontInfo, -cfg.SizePixels);
+        const int padding = atlas->TexGlyphPadding;
+        for (int glyph_i = 0; glyph_i < source.GlyphsList.Size; ++glyph_i)
+        {
+            int x0, y0, x1, y1;
+            const int glyph_index_in_font = stbtt_FindGlyphIndex(&source.FontInfo, source.GlyphsList[glyph_i]);
+            IM_ASSERT(glyph_index_in_font != 0);
+            stbtt_GetGlyphBitmapBoxSubpixel(&source.FontInfo, glyph_index_in_font, scale * cfg.OversampleH, scale * cfg.OversampleV, 0, 0, &x0, &y0, &x1, &y1);
+            source.Rects[glyph_i].w = (stbrp_coord)(x1 - x0 + padding + cfg.OversampleH - 1);
+            source.Rects[glyph_i].h = (stbrp_coord)(y1 - y0 + padding + cfg.OversampleV - 1);
+            total_surface += source.Rects[glyph_i].w * source.Rects[glyph_i].h;
+        }
+    }
+
+    const int surface_sqrt = (int)ImSqrt((float)total_surface) + 1;
+    atlas->TexHeight = 0;
+    if (atlas->TexDesiredWidth > 0)
+        atlas->TexWidth = atlas->TexDesiredWidth;
+    else
+        atlas->TexWidth = (surface_sqrt >= 4096 * 0.7f) ? 4096 : (surface_sqrt >= 2048 * 0.7f) ? 2048 : (surface_sqrt >= 1024 * 0.7f) ? 1024 : 512;
+
+    // 5. Pack the custom rects first, then every font, in an infinitely tall texture.
+    const int TEX_HEIGHT_MAX = 1024 * 32;
+    stbtt_pack_context spc = {};
+    stbtt_PackBegin(&spc, NULL, atlas->TexWidth, TEX_HEIGHT_MAX, 0, atlas->TexGlyphPadding, NULL);
+    ImFontAtlasBuildPackCustomRects(atlas, spc.pack_info);
+
+    for (auto& source : sources)
+    {
+        if (source.GlyphsCount == 0)
+            continue;
+
+        stbrp_pack_rects((stbrp_context*)spc.pack_info, source.Rects, source.GlyphsCount);
+        for (int glyph_i = 0; glyph_i < source.GlyphsCount; ++glyph_i)
+            if (source.Rects[glyph_i].was_packed)
+                atlas->TexHeight = ImMax(atlas->TexHeight, source.Rects[glyph_i].y + source.Rects[glyph_i].h);
+    }
+
+    // 6. Allocate the texture.
+    atlas->TexHeight = (atlas->Flags & ImFontAtlasFlags_NoPowerOfTwoHeight) ? (atlas->TexHeight + 1) : ImUpperPowerOfTwo(atlas->TexHeight);
+    atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+    atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(atlas->TexWidth * atlas->TexHeight);
+    memset(atlas->TexPixelsAlpha8, 0, atlas->TexWidth * atlas->TexHeight);
+    spc.pixels = atlas->TexPixelsAlpha8;
+    spc.height = atlas->TexHeight;
+
+    // 7. Rasterize. Every glyph only writes its own packed rectangle, so the tasks can run in any order.
+    std::vector<RenderTask_t> tasks;
+    for (int src_i = 0; src_i < (int)sources.size(); ++src_i)
+    {
+        for (int first = 0; first < sources[src_i].GlyphsCount; first += GlyphsPerTask)
+            tasks.emplace_back(RenderTask_t{ src_i, first, std::min(GlyphsPerTask, sources[src_i].GlyphsCount - first) });
+    }
+
+    std::atomic<size_t> next_task(0);
+    auto render_proc = [&]()
+    {
+        for (size_t task_i = next_task++; task_i < tasks.size(); task_i = next_task++)
+        {
+            RenderTask_t const& task = tasks[task_i];
+            RenderGlyphs(atlas, spc, sources[task.Source], atlas->ConfigData[task.Source], task);
+        }
+    };
+
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    thread_count = static_cast<uint32_t>(std::min<size_t>(thread_count, tasks.size()));
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < thread_count; ++i)
+        workers.emplace_back(render_proc);
+
+    render_proc();
+
+    for (auto& worker : workers)
+        worker.join();
+
+    stbtt_PackEnd(&spc);
+    for (auto& source : sources)
+        source.Rects = nullptr;
+
+    buf_rects.clear();
+
+    // 8. Register the glyphs, in source order like the serial build.
+    for (int src_i = 0; src_i < (int)sources.size(); ++src_i)
+    {
+        BuildSource_t& source = sources[src_i];
+        // Like the stb_truetype builder, a source without glyphs doesn't set up its font.
+        if (source.GlyphsCount == 0)
+            continue;
+
+        ImFontConfig& cfg = atlas->ConfigData[src_i];
+        ImFont* dst_font = cfg.DstFont;
+
+        const float font_scale = stbtt_ScaleForPixelHeight(&source.FontInfo, cfg.SizePixels);
+        int unscaled_ascent, unscaled_descent, unscaled_line_gap;
+        stbtt_GetFontVMetrics(&source.FontInfo, &unscaled_ascent, &unscaled_descent, &unscaled_line_gap);
+
+        const float ascent = ImFloor(unscaled_ascent * font_scale + ((unscaled_ascent > 0.0f) ? +1 : -1));
+        const float descent = ImFloor(unscaled_descent * font_scale + ((unscaled_descent > 0.0f) ? +1 : -1));
+        ImFontAtlasBuildSetupFont(atlas, dst_font, &cfg, ascent, descent);
+        const float font_off_x = cfg.GlyphOffset.x;
+        const float font_off_y = cfg.GlyphOffset.y + IM_ROUND(dst_font->Ascent);
+
+        for (int glyph_i = 0; glyph_i < source.GlyphsCount; ++glyph_i)
+        {
+            const int codepoint = source.GlyphsList[glyph_i];
+            stbtt_packedchar const& pc = source.PackedChars[glyph_i];
+            stbtt_aligned_quad q;
+            float unused_x = 0.0f, unused_y = 0.0f;
+            stbtt_GetPackedQuad(source.PackedChars, atlas->TexWidth, atlas->TexHeight, glyph_i, &unused_x, &unused_y, &q, 0);
+            dst_font->AddGlyph(&cfg, (ImWchar)codepoint, q.x0 + font_off_x, q.y0 + font_off_y, q.x1 + font_off_x, q.y1 + font_off_y, q.s0, q.t0, q.s1, q.t1, pc.xadvance);
+        }
+    }
+
+    ImFontAtlasBuildFinish(atlas);
+    return true;
+}
+
+static bool FontBuilderBuild(ImFontAtlas* atlas)
+{
+    return BuildAtlas(atlas, 0);
+}
+
+bool Build(void* imgui_font_atlas, uint32_t thread_count)
+{
+    ImFontAtlas* atlas = reinterpret_cast<ImFontAtlas*>(imgui_font_atlas);
+    if (atlas == nullptr)
+        return false;
+
+    if (atlas->Locked)
+    {
+        SPDLOG_WARN("Cannot build a locked font atlas.");
+        return false;
+    }
+
+    if (atlas->ConfigData.Size == 0)
+        atlas->AddFontDefault();
+
+    return BuildAtlas(atlas, thread_count);
+}
+
+void SetAsFontBuilder(void* imgui_font_atlas)
+{
+    static const ImFontBuilderIO font_builder = { &FontBuilderBuild };
+
+    ImFontAtlas* atlas = reinterpret_cast<ImFontAtlas*>(imgui_font_atlas);
+    if (atlas != nullptr)
+        atlas->FontBuilderIO = &font_builder;
+}
+
+}
+}
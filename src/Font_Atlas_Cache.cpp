@@ -0,0 +1,519 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Font_Atlas_Cache.h>
+
+#include "internal_includes.h"
+#include "Image_Codec.h"
+
+#include <imgui.h>
+
+#include <cstring>
+#include <fstream>
+
+namespace ingame_overlay {
+namespace Font_Atlas_Cache {
+
+static constexpr char CacheMagic[8] = { 'I', 'G', 'O', 'F', 'O', 'N', 'T', '\0' };
+static constexpr uint32_t CacheVersion = 1;
+
+// The cache is a raw dump of ImGui structures, only valid for the ImGui build that wrote it.
+static constexpr uint32_t ImGuiVersion = IMGUI_VERSION_NUM;
+
+class Writer_t
+{
+    std::vector<uint8_t>& _Data;
+
+public:
+    explicit Writer_t(std::vector<uint8_t>& data):
+        _Data(data)
+    {}
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        _Data.insert(_Data.end(), bytes, bytes + size);
+    }
+
+    template<typename T>
+    void Write(T value)
+    {
+        WriteBytes(&value, sizeof(value));
+    }
+};
+
+class Reader_t
+{
+    const uint8_t* _Data;
+    size_t _Size;
+    size_t _Offset;
+
+public:
+    Reader_t(const void* data, size_t size):
+        _Data(reinterpret_cast<const uint8_t*>(data)),
+        _Size(size),
+        _Offset(0)
+    {}
+
+    // Returns the next size bytes, nullptr if the data is too short.
+    const uint8_t* ReadBytes(size_t size)
+    {
+        if (size > _Size - _Offset)
+            return nullptr;
+
+        const uint8_t* data = _Data + _Offset;
+        _Offset += size;
+        return data;
+    }
+
+    template<typename T>
+    bool Read(T& value)
+    {
+        const uint8_t* data = ReadBytes(sizeof(value));
+        if (data == nullptr)
+            return false;
+
+        memcpy(&value, data, sizeof(value));
+        return true;
+    }
+};
+
+struct CachedGlyph_t
+{
+    uint32_t Codepoint;
+    uint8_t Visible;
+    uint8_t Colored;
+    float AdvanceX;
+    float X0, Y0, X1, Y1;
+    float U0, V0, U1, V1;
+};
+
+struct CachedFont_t
+{
+    char Name[40];
+    float SizePixels;
+    float FontSize;
+    float Scale;
+    float Ascent, Descent;
+    uint32_t FallbackChar;
+    uint32_t EllipsisChar;
+    int32_t MetricsTotalSurface;
+    std::vector<CachedGlyph_t> Glyphs;
+};
+
+struct CachedRect_t
+{
+    uint16_t Width, Height;
+    uint16_t X, Y;
+    uint32_t GlyphID;
+    float GlyphAdvanceX;
+    float GlyphOffsetX, GlyphOffsetY;
+    // Index in the atlas fonts, -1 for no font.
+    int32_t Font;
+};
+
+static void WriteVec2(Writer_t& writer, ImVec2 const& value)
+{
+    writer.Write(value.x);
+    writer.Write(value.y);
+}
+
+static bool ReadVec2(Reader_t& reader, ImVec2& value)
+{
+    return reader.Read(value.x) && reader.Read(value.y);
+}
+
+uint64_t ComputeKey(const void* imgui_font_atlas)
+{
+    const ImFontAtlas* atlas = reinterpret_cast<const ImFontAtlas*>(imgui_font_atlas);
+    if (atlas == nullptr)
+        return 0;
+
+    std::vector<uint8_t> key_data;
+    Writer_t writer(key_data);
+
+    writer.Write(ImGuiVersion);
+    writer.Write<int32_t>(atlas->Flags);
+    writer.Write<int32_t>(atlas->TexDesiredWidth);
+    writer.Write<int32_t>(atlas->TexGlyphPadding);
+    writer.Write<uint32_t>(atlas->FontBuilderFlags);
+
+    for (ImFontConfig const& config : atlas->ConfigData)
+    {
+        // The font file content, the cache must not survive a font update.
+        writer.Write(Image_Codec::Hash(config.FontData, static_cast<size_t>(config.FontDataSize)));
+        writer.Write<int32_t>(config.FontNo);
+        writer.Write(config.SizePixels);
+        writer.Write<int32_t>(config.OversampleH);
+        writer.Write<int32_t>(config.OversampleV);
+        writer.Write<uint8_t>(config.PixelSnapH);
+        WriteVec2(writer, config.GlyphExtraSpacing);
+        WriteVec2(writer, config.GlyphOffset);
+        writer.Write(config.GlyphMinAdvanceX);
+        writer.Write(config.GlyphMaxAdvanceX);
+        writer.Write<uint8_t>(config.MergeMode);
+        writer.Write<uint32_t>(config.FontBuilderFlags);
+        writer.Write(config.RasterizerMultiply);
+        writer.Write<uint32_t>(config.EllipsisChar);
+
+        // Pairs of first/last codepoints, 0 terminated. Null means the default ranges.
+        if (config.GlyphRanges != nullptr)
+        {
+            for (const ImWchar* range = config.GlyphRanges; range[0] != 0 && range[1] != 0; range += 2)
+            {
+                writer.Write<uint32_t>(range[0]);
+                writer.Write<uint32_t>(range[1]);
+            }
+        }
+        writer.Write<uint32_t>(0);
+    }
+
+    return Image_Codec::Hash(key_data.data(), key_data.size());
+}
+
+bool Save(void* imgui_font_atlas, uint64_t key, std::vector<uint8_t>& cache)
+{
+    ImFontAtlas* atlas = reinterpret_cast<ImFontAtlas*>(imgui_font_atlas);
+    if (atlas == nullptr || !atlas->IsBuilt() || (atlas->TexPixelsAlpha8 == nullptr && atlas->TexPixelsRGBA32 == nullptr))
+        return false;
+
+    cache.clear();
+    Writer_t writer(cache);
+
+    writer.WriteBytes(CacheMagic, sizeof(CacheMagic));
+    writer.Write(CacheVersion);
+    writer.Write(ImGuiVersion);
+    writer.Write(key);
+
+    writer.Write<int32_t>(atlas->Flags);
+    writer.Write<int32_t>(atlas->TexWidth);
+    writer.Write<int32_t>(atlas->TexHeight);
+    WriteVec2(writer, atlas->TexUvScale);
+    WriteVec2(writer, atlas->TexUvWhitePixel);
+    writer.Write<uint32_t>(IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1);
+    for (ImVec4 const& line : atlas->TexUvLines)
+    {
+        writer.Write(line.x);
+        writer.Write(line.y);
+        writer.Write(line.z);
+        writer.Write(line.w);
+    }
+    writer.Write<int32_t>(atlas->PackIdMouseCursors);
+    writer.Write<int32_t>(atlas->PackIdLines);
+    writer.Write<uint8_t>(atlas->TexPixelsUseColors);
+
+    // Keep the alpha texture when there is one, GetTexDataAsRGBA32 expands it on demand.
+    const size_t pixel_count = static_cast<size_t>(atlas->TexWidth) * atlas->TexHeight;
+    if (atlas->TexPixelsAlpha8 != nullptr)
+    {
+        writer.Write<uint8_t>(1);
+        writer.WriteBytes(atlas->TexPixelsAlpha8, pixel_count);
+    }
+    else
+    {
+        writer.Write<uint8_t>(4);
+        writer.WriteBytes(atlas->TexPixelsRGBA32, pixel_count * 4);
+    }
+
+    writer.Write<uint32_t>(atlas->Fonts.Size);
+    for (ImFont* font : atlas->Fonts)
+    {
+        char name[40] = {};
+        float size_pixels = font->FontSize;
+        if (font->ConfigData != nullptr)
+        {
+            strncpy(name, font->ConfigData->Name, sizeof(name) - 1);
+            size_pixels = font->ConfigData->SizePixels;
+        }
+
+        writer.WriteBytes(name, sizeof(name));
+        writer.Write(size_pixels);
+        writer.Write(font->FontSize);
+        writer.Write(font->Scale);
+        writer.Write(font->Ascent);
+        writer.Write(font->Descent);
+        writer.Write<uint32_t>(font->FallbackChar);
+        writer.Write<uint32_t>(font->EllipsisChar);
+        writer.Write<int32_t>(font->MetricsTotalSurface);
+
+        writer.Write<uint32_t>(font->Glyphs.Size);
+        for (ImFontGlyph const& glyph : font->Glyphs)
+        {
+            writer.Write<uint32_t>(glyph.Codepoint);
+            writer.Write<uint8_t>(glyph.Visible);
+            writer.Write<uint8_t>(glyph.Colored);
+            writer.Write(glyph.AdvanceX);
+            writer.Write(glyph.X0);
+            writer.Write(glyph.Y0);
+            writer.Write(glyph.X1);
+            writer.Write(glyph.Y1);
+            writer.Write(glyph.U0);
+            writer.Write(glyph.V0);
+            writer.Write(glyph.U1);
+            writer.Write(glyph.V1);
+        }
+    }
+
+    writer.Write<uint32_t>(atlas->CustomRects.Size);
+    for (ImFontAtlasCustomRect const& rect : atlas->CustomRects)
+    {
+        int32_t font_index = -1;
+        for (int i = 0; i < atlas->Fonts.Size; ++i)
+        {
+            if (atlas->Fonts[i] == rect.Font)
+                font_index = i;
+        }
+
+        writer.Write<uint16_t>(rect.Width);
+        writer.Write<uint16_t>(rect.Height);
+        writer.Write<uint16_t>(rect.X);
+        writer.Write<uint16_t>(rect.Y);
+        writer.Write<uint32_t>(rect.GlyphID);
+        writer.Write(rect.GlyphAdvanceX);
+        WriteVec2(writer, rect.GlyphOffset);
+        writer.Write(font_index);
+    }
+
+    return true;
+}
+
+bool Save(void* imgui_font_atlas, std::string const& path, uint64_t key)
+{
+    std::vector<uint8_t> cache;
+    if (!Save(imgui_font_atlas, key, cache))
+        return false;
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        SPDLOG_WARN("Failed to create font atlas cache {}.", path);
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(cache.data()), cache.size());
+    return static_cast<bool>(file);
+}
+
+bool Load(void* imgui_font_atlas, const void* cache, size_t cache_size, uint64_t key)
+{
+    ImFontAtlas* atlas = reinterpret_cast<ImFontAtlas*>(imgui_font_atlas);
+    if (atlas == nullptr || cache == nullptr)
+        return false;
+
+    Reader_t reader(cache, cache_size);
+
+    const uint8_t* magic = reader.ReadBytes(sizeof(CacheMagic));
+    uint32_t version, imgui_version;
+    uint64_t cache_key;
+    if (magic == nullptr || memcmp(magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+        !reader.Read(version) || version != CacheVersion ||
+        !reader.Read(imgui_version) || imgui_version != ImGuiVersion ||
+        !reader.Read(cache_key) || cache_key != key)
+    {
+        return false;
+    }
+
+    // Read everything before touching the atlas, a truncated cache must leave it untouched.
+    int32_t flags, tex_width, tex_height;
+    ImVec2 uv_scale, uv_white_pixel;
+    uint32_t line_count;
+    if (!reader.Read(flags) || !reader.Read(tex_width) || !reader.Read(tex_height) || tex_width <= 0 || tex_height <= 0 ||
+        !ReadVec2(reader, uv_scale) || !ReadVec2(reader, uv_white_pixel) ||
+        !reader.Read(line_count) || line_count != IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1)
+    {
+        return false;
+    }
+
+    ImVec4 uv_lines[IM_DRAWLIST_TEX_LINES_WIDTH_MAX + 1];
+    for (ImVec4& line : uv_lines)
+    {
+        if (!reader.Read(line.x) || !reader.Read(line.y) || !reader.Read(line.z) || !reader.Read(line.w))
+            return false;
+    }
+
+    int32_t pack_id_mouse_cursors, pack_id_lines;
+    uint8_t use_colors, bytes_per_pixel;
+    if (!reader.Read(pack_id_mouse_cursors) || !reader.Read(pack_id_lines) || !reader.Read(use_colors) ||
+        !reader.Read(bytes_per_pixel) || (bytes_per_pixel != 1 && bytes_per_pixel != 4))
+    {
+        return false;
+    }
+
+    const size_t pixels_size = static_cast<size_t>(tex_width) * tex_height * bytes_per_pixel;
+    const uint8_t* pixels = reader.ReadBytes(pixels_size);
+    uint32_t font_count;
+    if (pixels == nullptr || !reader.Read(font_count) || font_count == 0)
+        return false;
+
+    std::vector<CachedFont_t> fonts;
+    for (uint32_t i = 0; i < font_count; ++i)
+    {
+        CachedFont_t font;
+        const uint8_t* name = reader.ReadBytes(sizeof(font.Name));
+        uint32_t glyph_count;
+        if (name == nullptr ||
+            !reader.Read(font.SizePixels) || !reader.Read(font.FontSize) || !reader.Read(font.Scale) ||
+            !reader.Read(font.Ascent) || !reader.Read(font.Descent) ||
+            !reader.Read(font.FallbackChar) || !reader.Read(font.EllipsisChar) || !reader.Read(font.MetricsTotalSurface) ||
+            !reader.Read(glyph_count))
+        {
+            return false;
+        }
+
+        memcpy(font.Name, name, sizeof(font.Name));
+        font.Name[sizeof(font.Name) - 1] = '\0';
+
+        for (uint32_t j = 0; j < glyph_count; ++j)
+        {
+            CachedGlyph_t glyph;
+            if (!reader.Read(glyph.Codepoint) || !reader.Read(glyph.Visible) || !reader.Read(glyph.Colored) ||
+                !reader.Read(glyph.AdvanceX) ||
+                !reader.Read(glyph.X0) || !reader.Read(glyph.Y0) || !reader.Read(glyph.X1) || !reader.Read(glyph.Y1) ||
+                !reader.Read(glyph.U0) || !reader.Read(glyph.V0) || !reader.Read(glyph.U1) || !reader.Read(glyph.V1))
+            {
+                return false;
+            }
+
+            font.Glyphs.emplace_back(glyph);
+        }
+
+        fonts.emplace_back(std::move(font));
+    }
+
+    uint32_t rect_count;
+    if (!reader.Read(rect_count))
+        return false;
+
+    std::vector<CachedRect_t> rects;
+    for (uint32_t i = 0; i < rect_count; ++i)
+    {
+        CachedRect_t rect;
+        if (!reader.Read(rect.Width) || !reader.Read(rect.Height) || !reader.Read(rect.X) || !reader.Read(rect.Y) ||
+            !reader.Read(rect.GlyphID) || !reader.Read(rect.GlyphAdvanceX) ||
+            !reader.Read(rect.GlyphOffsetX) || !reader.Read(rect.GlyphOffsetY) ||
+            !reader.Read(rect.Font) || rect.Font < -1 || rect.Font >= static_cast<int32_t>(font_count))
+        {
+            return false;
+        }
+
+        rects.emplace_back(rect);
+    }
+
+    // Rebuild the atlas, like ImFontAtlasBuildFinish would.
+    atlas->Clear();
+
+    atlas->Flags = flags;
+    atlas->TexWidth = tex_width;
+    atlas->TexHeight = tex_height;
+    atlas->TexUvScale = uv_scale;
+    atlas->TexUvWhitePixel = uv_white_pixel;
+    memcpy(atlas->TexUvLines, uv_lines, sizeof(uv_lines));
+    atlas->PackIdMouseCursors = pack_id_mouse_cursors;
+    atlas->PackIdLines = pack_id_lines;
+    atlas->TexPixelsUseColors = use_colors != 0;
+
+    if (bytes_per_pixel == 1)
+    {
+        atlas->TexPixelsAlpha8 = reinterpret_cast<unsigned char*>(IM_ALLOC(pixels_size));
+        memcpy(atlas->TexPixelsAlpha8, pixels, pixels_size);
+    }
+    else
+    {
+        atlas->TexPixelsRGBA32 = reinterpret_cast<unsigned int*>(IM_ALLOC(pixels_size));
+        memcpy(atlas->TexPixelsRGBA32, pixels, pixels_size);
+    }
+
+    // Configs without font data, for the font names. The atlas can't be built again.
+    atlas->ConfigData.resize(static_cast<int>(font_count));
+    for (uint32_t i = 0; i < font_count; ++i)
+    {
+        ImFontConfig& config = atlas->ConfigData[static_cast<int>(i)];
+        config = ImFontConfig();
+        config.FontDataOwnedByAtlas = false;
+        config.SizePixels = fonts[i].SizePixels;
+        memcpy(config.Name, fonts[i].Name, sizeof(config.Name));
+    }
+
+    for (uint32_t i = 0; i < font_count; ++i)
+    {
+        CachedFont_t const& cached_font = fonts[i];
+        ImFont* font = IM_NEW(ImFont);
+        atlas->Fonts.push_back(font);
+
+        ImFontConfig& config = atlas->ConfigData[static_cast<int>(i)];
+        config.DstFont = font;
+
+        font->ContainerAtlas = atlas;
+        font->ConfigData = &config;
+        font->ConfigDataCount = 1;
+        font->FontSize = cached_font.FontSize;
+        font->Scale = cached_font.Scale;
+        font->Ascent = cached_font.Ascent;
+        font->Descent = cached_font.Descent;
+        font->FallbackChar = static_cast<ImWchar>(cached_font.FallbackChar);
+        font->EllipsisChar = static_cast<ImWchar>(cached_font.EllipsisChar);
+
+        // The glyphs were already adjusted by their config, don't let AddGlyph do it twice.
+        for (CachedGlyph_t const& glyph : cached_font.Glyphs)
+        {
+            font->AddGlyph(nullptr, static_cast<ImWchar>(glyph.Codepoint), glyph.X0, glyph.Y0, glyph.X1, glyph.Y1, glyph.U0, glyph.V0, glyph.U1, glyph.V1, glyph.AdvanceX);
+            font->Glyphs.back().Visible = glyph.Visible;
+            font->Glyphs.back().Colored = glyph.Colored;
+        }
+
+        font->BuildLookupTable();
+        font->MetricsTotalSurface = cached_font.MetricsTotalSurface;
+    }
+
+    for (CachedRect_t const& cached_rect : rects)
+    {
+        ImFontAtlasCustomRect rect;
+        rect.Width = cached_rect.Width;
+        rect.Height = cached_rect.Height;
+        rect.X = cached_rect.X;
+        rect.Y = cached_rect.Y;
+        rect.GlyphID = cached_rect.GlyphID;
+        rect.GlyphAdvanceX = cached_rect.GlyphAdvanceX;
+        rect.GlyphOffset = ImVec2(cached_rect.GlyphOffsetX, cached_rect.GlyphOffsetY);
+        rect.Font = cached_rect.Font == -1 ? nullptr : atlas->Fonts[cached_rect.Font];
+        atlas->CustomRects.push_back(rect);
+    }
+
+    atlas->TexReady = true;
+    return true;
+}
+
+bool Load(void* imgui_font_atlas, std::string const& path, uint64_t key)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    file.seekg(0, std::ios::end);
+    std::vector<uint8_t> cache(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(cache.data()), cache.size());
+    if (!file)
+        return false;
+
+    return Load(imgui_font_atlas, cache.data(), cache.size(), key);
+}
+
+}
+}
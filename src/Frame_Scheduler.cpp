@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Frame_Scheduler.h>
+
+#include "internal_includes.h"
+
+namespace ingame_overlay {
+
+constexpr std::chrono::microseconds Frame_Scheduler::DefaultFrameBudget;
+
+Frame_Scheduler::Frame_Scheduler():
+    _PendingCount(0),
+    _BudgetMicroseconds(DefaultFrameBudget.count())
+{}
+
+void Frame_Scheduler::Post(Task task)
+{
+    if (!task)
+        return;
+
+    std::lock_guard<std::mutex> lock(_PostedMutex);
+    _Posted.emplace_back(std::move(task));
+    ++_PendingCount;
+}
+
+void Frame_Scheduler::SetFrameBudget(std::chrono::microseconds budget)
+{
+    _BudgetMicroseconds = budget.count() < 0 ? 0 : budget.count();
+}
+
+std::chrono::microseconds Frame_Scheduler::GetFrameBudget() const
+{
+    return std::chrono::microseconds{ _BudgetMicroseconds.load() };
+}
+
+bool Frame_Scheduler::TimeLeft() const
+{
+    return std::chrono::steady_clock::now() < _FrameDeadline;
+}
+
+size_t Frame_Scheduler::PendingTasks() const
+{
+    return _PendingCount;
+}
+
+void Frame_Scheduler::Clear()
+{
+    std::vector<Task> posted;
+    {
+        std::lock_guard<std::mutex> lock(_PostedMutex);
+        posted.swap(_Posted);
+        _PendingCount -= posted.size() + _Ready.size() + _Parked.size();
+    }
+
+    _Ready.clear();
+    _Parked.clear();
+}
+
+void Frame_Scheduler::RunFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(_PostedMutex);
+        for (auto& task : _Posted)
+            _Parked.emplace_back(std::move(task));
+
+        _Posted.clear();
+    }
+
+    // Tasks left over by the previous frame keep their place, the parked ones go after them.
+    for (auto& task : _Parked)
+        _Ready.emplace_back(std::move(task));
+
+    _Parked.clear();
+
+    if (_Ready.empty())
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+    _FrameDeadline = start + std::chrono::microseconds{ _BudgetMicroseconds.load() };
+
+    size_t steps = 0;
+    do
+    {
+        Task task = std::move(_Ready.front());
+        _Ready.pop_front();
+        ++steps;
+
+        switch (task())
+        {
+            case FrameTaskStatus::Yield    : _Ready.emplace_back(std::move(task)); break;
+            case FrameTaskStatus::NextFrame: _Parked.emplace_back(std::move(task)); break;
+            case FrameTaskStatus::Done     : --_PendingCount; break;
+        }
+    } while (!_Ready.empty() && TimeLeft());
+
+    SPDLOG_TRACE("Frame scheduler ran {} steps in {}us, {} tasks pending.", steps, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count(), _PendingCount.load());
+}
+
+}
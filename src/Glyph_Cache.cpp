@@ -0,0 +1,534 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Glyph_Cache.h>
+
+#include "internal_includes.h"
+
+#include <imgui.h>
+#include <imgui_internal.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+// ImGui keeps its stb implementations static, build our own copies.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imstb_truetype.h>
+
+namespace ingame_overlay {
+
+// Transparent border around each glyph, so bilinear filtering never samples a neighbour.
+static constexpr uint32_t GlyphPadding = 1;
+
+// Distance fields are stored in alpha, 128 on the glyph edge, falling to 0 SdfSpread rasterized pixels away from it.
+static constexpr int SdfSpread = 4;
+static constexpr unsigned char SdfOnEdgeValue = 128;
+
+struct Glyph_Cache::Font_t
+{
+    std::vector<uint8_t> Data;
+    stbtt_fontinfo Info;
+    float Size;
+    float Scale;
+    float Ascent;
+};
+
+struct Glyph_Cache::Page_t
+{
+    ImageResourceHandle Texture;
+    // Resolved by GetGlyph once the renderer gives it, some only do on their render thread after the page is uploaded.
+    void* TextureId;
+    stbrp_context PackContext;
+    std::vector<stbrp_node> PackNodes;
+    // The glyphs to drop when this page is evicted.
+    std::vector<uint32_t> Codepoints;
+    int LastUsedFrame;
+};
+
+Glyph_Cache::Glyph_Cache(Renderer_Hook* renderer, uint32_t page_size, uint32_t max_pages, GlyphRasterMode mode):
+    _Renderer(renderer),
+    _PageSize(page_size),
+    _MaxPages(std::max(max_pages, 1u)),
+    _Mode(mode),
+    _Frame(0)
+{
+}
+
+Glyph_Cache::~Glyph_Cache()
+{
+    Clear();
+}
+
+void Glyph_Cache::_BeginFrame()
+{
+    if (ImGui::GetCurrentContext() == nullptr)
+        return;
+
+    const int frame = ImGui::GetFrameCount();
+    if (frame == _Frame)
+        return;
+
+    _Frame = frame;
+
+    // Give back the pages a busy frame had to add over the budget.
+    while (_Pages.size() > _MaxPages)
+    {
+        auto it = std::min_element(_Pages.begin(), _Pages.end(), [](std::unique_ptr<Page_t> const& a, std::unique_ptr<Page_t> const& b)
+        {
+            return a->LastUsedFrame < b->LastUsedFrame;
+        });
+
+        _EvictPage(it->get());
+        _Renderer->ReleaseImageResource((*it)->Texture);
+        _Pages.erase(it);
+    }
+}
+
+Glyph_Cache::Page_t* Glyph_Cache::_CreatePage()
+{
+    // Start from a transparent page so every glyph border stays transparent.
+    std::vector<uint8_t> blank_page(static_cast<size_t>(_PageSize) * _PageSize * 4, 0);
+
+    ImageResourceHandle texture = _Renderer->CreateImageResource(blank_page.data(), _PageSize, _PageSize);
+    if (texture == 0)
+    {
+        SPDLOG_WARN("Failed to create a {}x{} glyph cache page.", _PageSize, _PageSize);
+        return nullptr;
+    }
+
+    std::unique_ptr<Page_t> page(new Page_t);
+    page->Texture = texture;
+    page->TextureId = nullptr;
+    page->PackNodes.resize(_PageSize);
+    page->LastUsedFrame = -1;
+    stbrp_init_target(&page->PackContext, static_cast<int>(_PageSize), static_cast<int>(_PageSize), page->PackNodes.data(), static_cast<int>(page->PackNodes.size()));
+
+    _Pages.emplace_back(std::move(page));
+    return _Pages.back().get();
+}
+
+void Glyph_Cache::_EvictPage(Page_t* page)
+{
+    for (uint32_t codepoint : page->Codepoints)
+        _Glyphs.erase(codepoint);
+
+    page->Codepoints.clear();
+    stbrp_init_target(&page->PackContext, static_cast<int>(_PageSize), static_cast<int>(_PageSize), page->PackNodes.data(), static_cast<int>(page->PackNodes.size()));
+}
+
+bool Glyph_Cache::_AllocateSlot(uint32_t width, uint32_t height, bool allow_eviction, Page_t*& target_page, uint32_t& x, uint32_t& y)
+{
+    stbrp_rect rect = {};
+    rect.w = static_cast<stbrp_coord>(width);
+    rect.h = static_cast<stbrp_coord>(height);
+
+    target_page = nullptr;
+    for (auto& page : _Pages)
+    {
+        if (stbrp_pack_rects(&page->PackContext, &rect, 1) && rect.was_packed)
+        {
+            target_page = page.get();
+            break;
+        }
+    }
+
+    if (target_page == nullptr && _Pages.size() < _MaxPages)
+        target_page = _CreatePage();
+
+    if (target_page == nullptr && allow_eviction)
+    {
+        // The glyphs of a page drawn this frame are already in the draw lists, evict an older one.
+        Page_t* lru_page = nullptr;
+        for (auto& page : _Pages)
+        {
+            if (page->LastUsedFrame != _Frame && (lru_page == nullptr || page->LastUsedFrame < lru_page->LastUsedFrame))
+                lru_page = page.get();
+        }
+
+        if (lru_page != nullptr)
+        {
+            _EvictPage(lru_page);
+            target_page = lru_page;
+        }
+        else
+        {
+            target_page = _CreatePage();
+        }
+    }
+
+    if (target_page == nullptr)
+        return false;
+
+    if (!rect.was_packed && (!stbrp_pack_rects(&target_page->PackContext, &rect, 1) || !rect.was_packed))
+        return false;
+
+    x = rect.x;
+    y = rect.y;
+    return true;
+}
+
+Glyph_Cache::Entry_t* Glyph_Cache::_RasterizeGlyph(uint32_t codepoint, bool allow_eviction)
+{
+    int glyph_index = stbtt_FindGlyphIndex(&_Font->Info, static_cast<int>(codepoint));
+    if (glyph_index == 0)
+        glyph_index = stbtt_FindGlyphIndex(&_Font->Info, '?');
+
+    int advance, left_side_bearing;
+    stbtt_GetGlyphHMetrics(&_Font->Info, glyph_index, &advance, &left_side_bearing);
+
+    int x0 = 0, y0 = 0;
+    int width = 0, height = 0;
+    if (_Mode == GlyphRasterMode::SignedDistanceField)
+    {
+        unsigned char* sdf = stbtt_GetGlyphSDF(&_Font->Info, _Font->Scale, glyph_index, SdfSpread, SdfOnEdgeValue, static_cast<float>(SdfOnEdgeValue) / SdfSpread, &width, &height, &x0, &y0);
+        if (sdf != nullptr)
+        {
+            _Bitmap.assign(sdf, sdf + static_cast<size_t>(width) * height);
+            stbtt_FreeSDF(sdf, _Font->Info.userdata);
+        }
+        else
+        {
+            width = height = 0;
+        }
+    }
+    else
+    {
+        int x1, y1;
+        stbtt_GetGlyphBitmapBox(&_Font->Info, glyph_index, _Font->Scale, _Font->Scale, &x0, &y0, &x1, &y1);
+        width = std::max(x1 - x0, 0);
+        height = std::max(y1 - y0, 0);
+        if (width > 0 && height > 0)
+        {
+            _Bitmap.assign(static_cast<size_t>(width) * height, 0);
+            stbtt_MakeGlyphBitmap(&_Font->Info, _Bitmap.data(), width, height, width, _Font->Scale, _Font->Scale, glyph_index);
+        }
+    }
+
+    Entry_t entry;
+    entry.Glyph.Texture = nullptr;
+    entry.Glyph.X0 = static_cast<float>(x0);
+    entry.Glyph.Y0 = static_cast<float>(y0) + _Font->Ascent;
+    entry.Glyph.X1 = static_cast<float>(x0 + width);
+    entry.Glyph.Y1 = static_cast<float>(y0 + height) + _Font->Ascent;
+    entry.Glyph.U0 = entry.Glyph.V0 = entry.Glyph.U1 = entry.Glyph.V1 = 0.0f;
+    entry.Glyph.AdvanceX = advance * _Font->Scale;
+    entry.Page = nullptr;
+    entry.LastUsedFrame = -1;
+
+    const uint32_t padded_width = static_cast<uint32_t>(width) + GlyphPadding * 2;
+    const uint32_t padded_height = static_cast<uint32_t>(height) + GlyphPadding * 2;
+
+    if (width == 0 || height == 0 || padded_width > _PageSize || padded_height > _PageSize)
+    {// Blank glyph, it only advances the pen.
+        return &(_Glyphs[codepoint] = entry);
+    }
+
+    Page_t* page;
+    uint32_t slot_x, slot_y;
+    if (!_AllocateSlot(padded_width, padded_height, allow_eviction, page, slot_x, slot_y))
+        return nullptr;
+
+    // Upload the whole slot: it clears the border and whatever an evicted glyph left there.
+    const uint32_t slot_stride = padded_width * 4;
+    _StagingBuffer.assign(static_cast<size_t>(slot_stride) * padded_height, 0);
+    for (int row = 0; row < height; ++row)
+    {
+        uint8_t* dst = &_StagingBuffer[(row + GlyphPadding) * slot_stride + GlyphPadding * 4];
+        const uint8_t* src = &_Bitmap[static_cast<size_t>(row) * width];
+        for (int column = 0; column < width; ++column, dst += 4)
+        {
+            dst[0] = dst[1] = dst[2] = 255;
+            dst[3] = src[column];
+        }
+    }
+
+    if (!_Renderer->UpdateImageResource(page->Texture, slot_x, slot_y, padded_width, padded_height, _StagingBuffer.data(), slot_stride))
+        return nullptr;
+
+    const float texel_size = 1.0f / static_cast<float>(_PageSize);
+    entry.Glyph.Texture = page->TextureId;
+    entry.Glyph.U0 = (slot_x + GlyphPadding) * texel_size;
+    entry.Glyph.V0 = (slot_y + GlyphPadding) * texel_size;
+    entry.Glyph.U1 = (slot_x + GlyphPadding + width) * texel_size;
+    entry.Glyph.V1 = (slot_y + GlyphPadding + height) * texel_size;
+    entry.Page = page;
+
+    page->Codepoints.emplace_back(codepoint);
+    return &(_Glyphs[codepoint] = entry);
+}
+
+bool Glyph_Cache::LoadFont(const void* font_data, size_t font_data_size, float size_pixels, int font_index)
+{
+    Clear();
+
+    if (_Renderer == nullptr || font_data == nullptr || font_data_size == 0 || size_pixels <= 0.0f)
+        return false;
+
+    std::unique_ptr<Font_t> font(new Font_t);
+    font->Data.assign(reinterpret_cast<const uint8_t*>(font_data), reinterpret_cast<const uint8_t*>(font_data) + font_data_size);
+
+    const int font_offset = stbtt_GetFontOffsetForIndex(font->Data.data(), font_index);
+    if (font_offset < 0 || !stbtt_InitFont(&font->Info, font->Data.data(), font_offset))
+    {
+        SPDLOG_WARN("Failed to load the glyph cache font.");
+        return false;
+    }
+
+    int ascent, descent, line_gap;
+    stbtt_GetFontVMetrics(&font->Info, &ascent, &descent, &line_gap);
+
+    // Same metrics as the ImGui stb_truetype builder, so the text lines up with ImGui text of the same size.
+    font->Size = size_pixels;
+    font->Scale = stbtt_ScaleForPixelHeight(&font->Info, size_pixels);
+    font->Ascent = std::floor(ascent * font->Scale + 1.0f);
+    _Font = std::move(font);
+
+    std::vector<uint32_t> ascii;
+    for (uint32_t codepoint = 0x20; codepoint < 0x7F; ++codepoint)
+        ascii.emplace_back(codepoint);
+
+    Preload(ascii.data(), ascii.size());
+    return true;
+}
+
+bool Glyph_Cache::LoadFontFromFile(std::string const& path, float size_pixels, int font_index)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        SPDLOG_WARN("Failed to open font {}.", path);
+        return false;
+    }
+
+    std::vector<uint8_t> font_data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return LoadFont(font_data.data(), font_data.size(), size_pixels, font_index);
+}
+
+void Glyph_Cache::Preload(const uint32_t* codepoints, size_t count)
+{
+    if (!_Font)
+        return;
+
+    _BeginFrame();
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Stop once the pages are full, preloading must not evict what is already drawn.
+        if (_Glyphs.find(codepoints[i]) == _Glyphs.end() && _RasterizeGlyph(codepoints[i], false) == nullptr)
+            break;
+    }
+}
+
+std::vector<uint32_t> Glyph_Cache::GetRecentCodepoints() const
+{
+    std::vector<std::pair<int, uint32_t>> glyphs;
+    glyphs.reserve(_Glyphs.size());
+    for (auto const& item : _Glyphs)
+        glyphs.emplace_back(item.second.LastUsedFrame, item.first);
+
+    std::sort(glyphs.begin(), glyphs.end(), [](std::pair<int, uint32_t> const& a, std::pair<int, uint32_t> const& b)
+    {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    });
+
+    std::vector<uint32_t> codepoints;
+    codepoints.reserve(glyphs.size());
+    for (auto const& glyph : glyphs)
+        codepoints.emplace_back(glyph.second);
+
+    return codepoints;
+}
+
+const Cached_Glyph* Glyph_Cache::GetGlyph(uint32_t codepoint)
+{
+    if (!_Font)
+        return nullptr;
+
+    _BeginFrame();
+
+    Entry_t* entry;
+    auto it = _Glyphs.find(codepoint);
+    if (it != _Glyphs.end())
+        entry = &it->second;
+    else
+        entry = _RasterizeGlyph(codepoint, true);
+
+    if (entry == nullptr)
+        return nullptr;
+
+    entry->LastUsedFrame = _Frame;
+    if (entry->Page != nullptr)
+    {
+        Page_t* page = entry->Page;
+        page->LastUsedFrame = _Frame;
+        if (page->TextureId == nullptr)
+            page->TextureId = _Renderer->GetImageResourceTexture(page->Texture);
+
+        entry->Glyph.Texture = page->TextureId;
+    }
+
+    return &entry->Glyph;
+}
+
+float Glyph_Cache::GetFontSize() const
+{
+    return _Font ? _Font->Size : 0.0f;
+}
+
+void Glyph_Cache::CalcTextSize(const char* text_begin, const char* text_end, float& width, float& height)
+{
+    CalcTextSize(GetFontSize(), text_begin, text_end, width, height);
+}
+
+void Glyph_Cache::CalcTextSize(float size_pixels, const char* text_begin, const char* text_end, float& width, float& height)
+{
+    width = 0.0f;
+    height = 0.0f;
+    if (!_Font || text_begin == nullptr)
+        return;
+
+    const float scale = size_pixels / _Font->Size;
+
+    if (text_end == nullptr)
+        text_end = text_begin + strlen(text_begin);
+
+    float line_width = 0.0f;
+    height = size_pixels;
+    for (const char* s = text_begin; s < text_end;)
+    {
+        unsigned int c = static_cast<unsigned char>(*s);
+        if (c < 0x80)
+            ++s;
+        else
+            s += ImTextCharFromUtf8(&c, s, text_end);
+
+        if (c == '\n')
+        {
+            width = std::max(width, line_width);
+            line_width = 0.0f;
+            height += size_pixels;
+            continue;
+        }
+
+        if (c == '\r')
+            continue;
+
+        const Cached_Glyph* glyph = GetGlyph(c);
+        if (glyph != nullptr)
+            line_width += glyph->AdvanceX * scale;
+    }
+
+    width = std::max(width, line_width);
+}
+
+void Glyph_Cache::AddText(void* imgui_draw_list, float x, float y, uint32_t color, const char* text_begin, const char* text_end)
+{
+    AddText(imgui_draw_list, GetFontSize(), x, y, color, text_begin, text_end);
+}
+
+void Glyph_Cache::AddText(void* imgui_draw_list, float size_pixels, float x, float y, uint32_t color, const char* text_begin, const char* text_end)
+{
+    ImDrawList* draw_list = reinterpret_cast<ImDrawList*>(imgui_draw_list);
+    if (!_Font || draw_list == nullptr || text_begin == nullptr)
+        return;
+
+    if (text_end == nullptr)
+        text_end = text_begin + strlen(text_begin);
+
+    // Snap to pixels like ImFont::RenderText, the glyphs are rasterized without oversampling.
+    x = std::floor(x);
+    y = std::floor(y);
+
+    const float scale = size_pixels / _Font->Size;
+    const bool sdf_draw = _Mode == GlyphRasterMode::SignedDistanceField && _Renderer->BeginSdfDraw(draw_list);
+
+    float pen_x = x;
+    float pen_y = y;
+    void* current_texture = nullptr;
+    for (const char* s = text_begin; s < text_end;)
+    {
+        unsigned int c = static_cast<unsigned char>(*s);
+        if (c < 0x80)
+            ++s;
+        else
+            s += ImTextCharFromUtf8(&c, s, text_end);
+
+        if (c == '\n')
+        {
+            pen_x = x;
+            pen_y += size_pixels;
+            continue;
+        }
+
+        if (c == '\r')
+            continue;
+
+        const Cached_Glyph* glyph = GetGlyph(c);
+        if (glyph == nullptr)
+            continue;
+
+        if (glyph->Texture != nullptr)
+        {
+            // Glyphs of a same page share a draw command.
+            if (glyph->Texture != current_texture)
+            {
+                if (current_texture != nullptr)
+                    draw_list->PopTextureID();
+
+                draw_list->PushTextureID(glyph->Texture);
+                current_texture = glyph->Texture;
+            }
+
+            draw_list->PrimReserve(6, 4);
+            draw_list->PrimRectUV(
+                ImVec2(pen_x + glyph->X0 * scale, pen_y + glyph->Y0 * scale), ImVec2(pen_x + glyph->X1 * scale, pen_y + glyph->Y1 * scale),
+                ImVec2(glyph->U0, glyph->V0), ImVec2(glyph->U1, glyph->V1),
+                color);
+        }
+
+        pen_x += glyph->AdvanceX * scale;
+    }
+
+    if (current_texture != nullptr)
+        draw_list->PopTextureID();
+
+    if (sdf_draw)
+        _Renderer->EndSdfDraw(draw_list);
+}
+
+void Glyph_Cache::Clear()
+{
+    _Glyphs.clear();
+
+    for (auto& page : _Pages)
+        _Renderer->ReleaseImageResource(page->Texture);
+
+    _Pages.clear();
+    _Font.reset();
+    _Bitmap.clear();
+    _StagingBuffer.clear();
+}
+
+}
@@ -0,0 +1,253 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Image_Atlas.h>
+
+#include "internal_includes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+// ImGui keeps its stb_rect_pack implementation static, build our own copy.
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+namespace ingame_overlay {
+
+// Transparent border around each image, so bilinear filtering never samples a neighbour.
+static constexpr uint32_t AtlasImagePadding = 1;
+
+struct Image_Atlas::Page_t
+{
+    ImageResourceHandle Texture;
+    // Resolved on the first GetImage that gets one, the renderer may only give it on its render thread once the page is uploaded.
+    void* TextureId;
+    stbrp_context PackContext;
+    std::vector<stbrp_node> PackNodes;
+    // Slots given back by ReleaseImage, they are reused before packing new ones.
+    std::vector<stbrp_rect> FreeSlots;
+    uint32_t ImageCount;
+};
+
+Image_Atlas::Image_Atlas(Renderer_Hook* renderer, uint32_t page_size):
+    _Renderer(renderer),
+    _PageSize(page_size)
+{
+}
+
+Image_Atlas::~Image_Atlas()
+{
+    Clear();
+}
+
+Image_Atlas::Page_t* Image_Atlas::_CreatePage()
+{
+    // Start from a transparent page so every image border stays transparent.
+    std::vector<uint8_t> blank_page(static_cast<size_t>(_PageSize) * _PageSize * 4, 0);
+
+    ImageResourceHandle texture = _Renderer->CreateImageResource(blank_page.data(), _PageSize, _PageSize);
+    if (texture == 0)
+    {
+        SPDLOG_WARN("Failed to create a {}x{} atlas page.", _PageSize, _PageSize);
+        return nullptr;
+    }
+
+    std::unique_ptr<Page_t> page(new Page_t);
+    page->Texture = texture;
+    page->TextureId = nullptr;
+    page->PackNodes.resize(_PageSize);
+    page->ImageCount = 0;
+    stbrp_init_target(&page->PackContext, static_cast<int>(_PageSize), static_cast<int>(_PageSize), page->PackNodes.data(), static_cast<int>(page->PackNodes.size()));
+
+    _Pages.emplace_back(std::move(page));
+    return _Pages.back().get();
+}
+
+bool Image_Atlas::_AllocateSlot(uint32_t width, uint32_t height, Entry_t& entry)
+{
+    Page_t* best_page = nullptr;
+    size_t best_slot = 0;
+    uint64_t best_area = std::numeric_limits<uint64_t>::max();
+
+    // Reuse the smallest released slot that fits, avatars and icons usually share the same size.
+    for (auto& page : _Pages)
+    {
+        for (size_t i = 0; i < page->FreeSlots.size(); ++i)
+        {
+            stbrp_rect const& slot = page->FreeSlots[i];
+            if (static_cast<uint32_t>(slot.w) < width || static_cast<uint32_t>(slot.h) < height)
+                continue;
+
+            uint64_t area = static_cast<uint64_t>(slot.w) * slot.h;
+            if (area < best_area)
+            {
+                best_page = page.get();
+                best_slot = i;
+                best_area = area;
+            }
+        }
+    }
+
+    if (best_page != nullptr)
+    {
+        stbrp_rect const& slot = best_page->FreeSlots[best_slot];
+        entry.Page = best_page;
+        entry.SlotX = slot.x;
+        entry.SlotY = slot.y;
+        entry.SlotWidth = slot.w;
+        entry.SlotHeight = slot.h;
+        best_page->FreeSlots[best_slot] = best_page->FreeSlots.back();
+        best_page->FreeSlots.pop_back();
+        return true;
+    }
+
+    stbrp_rect rect = {};
+    rect.w = static_cast<stbrp_coord>(width);
+    rect.h = static_cast<stbrp_coord>(height);
+
+    Page_t* target_page = nullptr;
+    for (auto& page : _Pages)
+    {
+        if (stbrp_pack_rects(&page->PackContext, &rect, 1) && rect.was_packed)
+        {
+            target_page = page.get();
+            break;
+        }
+    }
+
+    if (target_page == nullptr)
+    {
+        target_page = _CreatePage();
+        if (target_page == nullptr || !stbrp_pack_rects(&target_page->PackContext, &rect, 1) || !rect.was_packed)
+            return false;
+    }
+
+    entry.Page = target_page;
+    entry.SlotX = rect.x;
+    entry.SlotY = rect.y;
+    entry.SlotWidth = rect.w;
+    entry.SlotHeight = rect.h;
+    return true;
+}
+
+ImageResourceHandle Image_Atlas::CreateImage(const void* image_data, uint32_t width, uint32_t height)
+{
+    const uint32_t padded_width = width + AtlasImagePadding * 2;
+    const uint32_t padded_height = height + AtlasImagePadding * 2;
+
+    if (_Renderer == nullptr || image_data == nullptr || width == 0 || height == 0 || padded_width > _PageSize || padded_height > _PageSize)
+        return 0;
+
+    Entry_t entry;
+    if (!_AllocateSlot(padded_width, padded_height, entry))
+        return 0;
+
+    // Upload the whole slot: it clears the border and whatever a bigger released image left in a reused slot.
+    const uint32_t slot_stride = entry.SlotWidth * 4;
+    _StagingBuffer.assign(static_cast<size_t>(slot_stride) * entry.SlotHeight, 0);
+
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(image_data);
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        memcpy(&_StagingBuffer[(row + AtlasImagePadding) * slot_stride + AtlasImagePadding * 4], pixels, width * 4);
+        pixels += width * 4;
+    }
+
+    if (!_Renderer->UpdateImageResource(entry.Page->Texture, entry.SlotX, entry.SlotY, entry.SlotWidth, entry.SlotHeight, _StagingBuffer.data(), slot_stride))
+    {
+        _ReleaseSlot(entry);
+        // A page made for this image would stay empty.
+        if (entry.Page->ImageCount == 0)
+            _ReleasePage(entry.Page);
+
+        return 0;
+    }
+
+    ++entry.Page->ImageCount;
+
+    const float texel_size = 1.0f / static_cast<float>(_PageSize);
+    entry.Image.Texture = nullptr;
+    entry.Image.U0 = (entry.SlotX + AtlasImagePadding) * texel_size;
+    entry.Image.V0 = (entry.SlotY + AtlasImagePadding) * texel_size;
+    entry.Image.U1 = (entry.SlotX + AtlasImagePadding + width) * texel_size;
+    entry.Image.V1 = (entry.SlotY + AtlasImagePadding + height) * texel_size;
+
+    return _Images.Insert(entry);
+}
+
+void Image_Atlas::_ReleaseSlot(Entry_t const& entry)
+{
+    stbrp_rect slot = {};
+    slot.x = static_cast<stbrp_coord>(entry.SlotX);
+    slot.y = static_cast<stbrp_coord>(entry.SlotY);
+    slot.w = static_cast<stbrp_coord>(entry.SlotWidth);
+    slot.h = static_cast<stbrp_coord>(entry.SlotHeight);
+    entry.Page->FreeSlots.emplace_back(slot);
+}
+
+void Image_Atlas::_ReleasePage(Page_t* page)
+{
+    _Renderer->ReleaseImageResource(page->Texture);
+    _Pages.erase(std::find_if(_Pages.begin(), _Pages.end(), [page](std::unique_ptr<Page_t> const& item) { return item.get() == page; }));
+}
+
+void Image_Atlas::ReleaseImage(ImageResourceHandle image)
+{
+    Entry_t entry;
+    if (!_Images.Remove(image, entry))
+        return;
+
+    Page_t* page = entry.Page;
+    _ReleaseSlot(entry);
+
+    if (--page->ImageCount == 0)
+    {// Nothing lives in this page anymore, give its texture back.
+        _ReleasePage(page);
+    }
+}
+
+bool Image_Atlas::GetImage(ImageResourceHandle image, Atlas_Image& infos) const
+{
+    const Entry_t* entry = _Images.Get(image);
+    if (entry == nullptr)
+        return false;
+
+    Page_t* page = entry->Page;
+    if (page->TextureId == nullptr)
+        page->TextureId = _Renderer->GetImageResourceTexture(page->Texture);
+
+    infos = entry->Image;
+    infos.Texture = page->TextureId;
+    return true;
+}
+
+void Image_Atlas::Clear()
+{
+    _Images.Clear();
+
+    for (auto& page : _Pages)
+        _Renderer->ReleaseImageResource(page->Texture);
+
+    _Pages.clear();
+    _StagingBuffer.clear();
+}
+
+}
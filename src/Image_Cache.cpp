@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Image_Cache.h>
+
+#include "internal_includes.h"
+#include "Image_Codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ingame_overlay {
+
+Image_Cache::Image_Cache(Renderer_Hook* renderer, uint64_t budget):
+    _Renderer(renderer),
+    _Budget(budget),
+    _UsedBytes(0),
+    _FrameCount(0)
+{
+}
+
+Image_Cache::~Image_Cache()
+{
+    Clear();
+}
+
+uint64_t Image_Cache::_TextureSize(Entry_t const& entry)
+{
+    return static_cast<uint64_t>(entry.Width) * entry.Height * 4;
+}
+
+bool Image_Cache::_Upload(Entry_t& entry, const void* image_data)
+{
+    entry.Resource = _Renderer->CreateImageResource(image_data, entry.Width, entry.Height);
+    if (entry.Resource == 0)
+        return false;
+
+    entry.TextureId = _Renderer->GetImageResourceTexture(entry.Resource);
+    // Count it as drawn, so the next Update doesn't evict it before it had a chance to be drawn.
+    entry.LastDrawnFrame = _FrameCount;
+    _UsedBytes += _TextureSize(entry);
+    return true;
+}
+
+void Image_Cache::_Evict(Entry_t& entry)
+{
+    if (entry.Resource == 0)
+        return;
+
+    _Renderer->ReleaseImageResource(entry.Resource);
+    _UsedBytes -= _TextureSize(entry);
+    entry.Resource = 0;
+    entry.TextureId = nullptr;
+}
+
+void Image_Cache::_EnforceBudget()
+{
+    if (_Budget == 0 || _UsedBytes <= _Budget)
+        return;
+
+    std::vector<Entry_t*> candidates;
+    _Images.ForEach([this, &candidates](ImageResourceHandle, Entry_t& entry)
+    {
+        // Never evict what has been drawn in the last frame, it would be uploaded again right away.
+        if (entry.Resource != 0 && entry.LastDrawnFrame + 1 < _FrameCount)
+            candidates.emplace_back(&entry);
+    });
+
+    std::sort(candidates.begin(), candidates.end(), [](Entry_t const* l, Entry_t const* r)
+    {
+        return l->LastDrawnFrame < r->LastDrawnFrame;
+    });
+
+    for (auto entry : candidates)
+    {
+        if (_UsedBytes <= _Budget)
+            break;
+
+        _Evict(*entry);
+    }
+}
+
+void Image_Cache::SetBudget(uint64_t budget)
+{
+    _Budget = budget;
+}
+
+uint64_t Image_Cache::GetBudget() const
+{
+    return _Budget;
+}
+
+uint64_t Image_Cache::GetUsedBytes() const
+{
+    return _UsedBytes;
+}
+
+ImageResourceHandle Image_Cache::CreateImage(const void* image_data, uint32_t width, uint32_t height)
+{
+    if (_Renderer == nullptr || image_data == nullptr || width == 0 || height == 0)
+        return 0;
+
+    const size_t pixel_count = static_cast<size_t>(width) * height;
+    const uint64_t hash = Image_Codec::Hash(image_data, pixel_count * 4);
+
+    auto range = _ImagesByHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        Entry_t* entry = _Images.Get(it->second);
+        if (entry == nullptr || entry->Width != width || entry->Height != height)
+            continue;
+
+        // Same hash, make sure it really is the same image before sharing it.
+        _DecompressBuffer.resize(pixel_count * 4);
+        if (!Image_Codec::Decompress(entry->CompressedPixels.data(), entry->CompressedPixels.size(), _DecompressBuffer.data(), pixel_count) ||
+            memcmp(_DecompressBuffer.data(), image_data, pixel_count * 4) != 0)
+            continue;
+
+        ++entry->References;
+        return it->second;
+    }
+
+    Entry_t entry;
+    entry.Hash = hash;
+    entry.Width = width;
+    entry.Height = height;
+    entry.References = 1;
+    entry.CompressedPixels = Image_Codec::Compress(image_data, pixel_count);
+    entry.Resource = 0;
+    entry.TextureId = nullptr;
+    entry.LastDrawnFrame = _FrameCount;
+
+    ImageResourceHandle handle = _Images.Insert(std::move(entry));
+    if (!_Upload(*_Images.Get(handle), image_data))
+    {
+        SPDLOG_WARN("Failed to upload a {}x{} cached image.", width, height);
+        Entry_t failed;
+        _Images.Remove(handle, failed);
+        return 0;
+    }
+
+    _ImagesByHash.emplace(hash, handle);
+    return handle;
+}
+
+void Image_Cache::ReleaseImage(ImageResourceHandle image)
+{
+    Entry_t* entry = _Images.Get(image);
+    if (entry == nullptr || --entry->References != 0)
+        return;
+
+    _Evict(*entry);
+
+    auto range = _ImagesByHash.equal_range(entry->Hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == image)
+        {
+            _ImagesByHash.erase(it);
+            break;
+        }
+    }
+
+    Entry_t released;
+    _Images.Remove(image, released);
+}
+
+void* Image_Cache::GetTexture(ImageResourceHandle image)
+{
+    Entry_t* entry = _Images.Get(image);
+    if (entry == nullptr)
+        return nullptr;
+
+    if (entry->Resource == 0)
+    {
+        const size_t pixel_count = static_cast<size_t>(entry->Width) * entry->Height;
+        _DecompressBuffer.resize(pixel_count * 4);
+        if (!Image_Codec::Decompress(entry->CompressedPixels.data(), entry->CompressedPixels.size(), _DecompressBuffer.data(), pixel_count) ||
+            !_Upload(*entry, _DecompressBuffer.data()))
+        {
+            SPDLOG_WARN("Failed to upload back a {}x{} cached image.", entry->Width, entry->Height);
+            return nullptr;
+        }
+    }
+    else if (entry->TextureId == nullptr)
+    {// Some renderers only resolve the texture once they processed the creation.
+        entry->TextureId = _Renderer->GetImageResourceTexture(entry->Resource);
+    }
+
+    // Asking for the texture is what draws the image, so this is where it gets marked as used.
+    entry->LastDrawnFrame = _FrameCount;
+    return entry->TextureId;
+}
+
+void Image_Cache::Update()
+{
+    ++_FrameCount;
+    _EnforceBudget();
+}
+
+void Image_Cache::Clear()
+{
+    _Images.ForEach([this](ImageResourceHandle, Entry_t& entry)
+    {
+        _Evict(entry);
+    });
+
+    _Images.Clear();
+    _ImagesByHash.clear();
+    _DecompressBuffer.clear();
+    _DecompressBuffer.shrink_to_fit();
+}
+
+}
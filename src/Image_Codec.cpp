@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Image_Codec.h"
+
+#include <cstring>
+
+namespace ingame_overlay {
+namespace Image_Codec {
+
+enum OpCode : uint8_t
+{
+    OpIndex = 0x00, // 00iiiiii: color cache entry
+    OpDiff  = 0x40, // 01rrggbb: r, g, b deltas in [-2, 1]
+    OpLuma  = 0x80, // 10gggggg rrrrbbbb: g delta in [-32, 31], r and b deltas relative to g in [-8, 7]
+    OpRun   = 0xc0, // 11llllll: repeat the previous pixel 1 to 62 times
+    OpRgb   = 0xfe,
+    OpRgba  = 0xff,
+};
+
+static constexpr uint8_t OpMask = 0xc0;
+static constexpr uint32_t MaxRun = 62;
+
+struct Pixel_t
+{
+    uint8_t R, G, B, A;
+};
+
+static inline bool operator==(Pixel_t const& l, Pixel_t const& r)
+{
+    return l.R == r.R && l.G == r.G && l.B == r.B && l.A == r.A;
+}
+
+static inline uint32_t CacheIndex(Pixel_t const& pixel)
+{
+    return (pixel.R * 3 + pixel.G * 5 + pixel.B * 7 + pixel.A * 11) % 64;
+}
+
+std::vector<uint8_t> Compress(const void* image_data, size_t pixel_count)
+{
+    const Pixel_t* pixels = reinterpret_cast<const Pixel_t*>(image_data);
+    Pixel_t cache[64] = {};
+    Pixel_t previous = { 0, 0, 0, 255 };
+    uint32_t run = 0;
+
+    std::vector<uint8_t> result;
+    // Worst case is 5 bytes per pixel, photos usually land around half the raw size.
+    result.reserve(pixel_count * 2);
+
+    for (size_t i = 0; i < pixel_count; ++i)
+    {
+        const Pixel_t pixel = pixels[i];
+
+        if (pixel == previous)
+        {
+            if (++run == MaxRun)
+            {
+                result.emplace_back(OpRun | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+
+        if (run > 0)
+        {
+            result.emplace_back(OpRun | (run - 1));
+            run = 0;
+        }
+
+        const uint32_t index = CacheIndex(pixel);
+        if (cache[index] == pixel)
+        {
+            result.emplace_back(OpIndex | index);
+        }
+        else
+        {
+            cache[index] = pixel;
+
+            if (pixel.A == previous.A)
+            {
+                const int8_t dr = static_cast<int8_t>(pixel.R - previous.R);
+                const int8_t dg = static_cast<int8_t>(pixel.G - previous.G);
+                const int8_t db = static_cast<int8_t>(pixel.B - previous.B);
+                const int8_t dr_dg = static_cast<int8_t>(dr - dg);
+                const int8_t db_dg = static_cast<int8_t>(db - dg);
+
+                if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+                {
+                    result.emplace_back(OpDiff | ((dr + 2) << 4) | ((dg + 2) << 2) | (db + 2));
+                }
+                else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+                {
+                    result.emplace_back(OpLuma | (dg + 32));
+                    result.emplace_back(((dr_dg + 8) << 4) | (db_dg + 8));
+                }
+                else
+                {
+                    result.emplace_back(OpRgb);
+                    result.emplace_back(pixel.R);
+                    result.emplace_back(pixel.G);
+                    result.emplace_back(pixel.B);
+                }
+            }
+            else
+            {
+                result.emplace_back(OpRgba);
+                result.emplace_back(pixel.R);
+                result.emplace_back(pixel.G);
+                result.emplace_back(pixel.B);
+                result.emplace_back(pixel.A);
+            }
+        }
+
+        previous = pixel;
+    }
+
+    if (run > 0)
+        result.emplace_back(OpRun | (run - 1));
+
+    result.shrink_to_fit();
+    return result;
+}
+
+bool Decompress(const uint8_t* compressed_data, size_t compressed_size, void* image_data, size_t pixel_count)
+{
+    Pixel_t* pixels = reinterpret_cast<Pixel_t*>(image_data);
+    Pixel_t cache[64] = {};
+    Pixel_t pixel = { 0, 0, 0, 255 };
+    size_t read = 0;
+    size_t written = 0;
+
+    while (written < pixel_count)
+    {
+        if (read >= compressed_size)
+            return false;
+
+        const uint8_t op = compressed_data[read++];
+
+        if (op == OpRgb)
+        {
+            if (compressed_size - read < 3)
+                return false;
+
+            pixel.R = compressed_data[read++];
+            pixel.G = compressed_data[read++];
+            pixel.B = compressed_data[read++];
+        }
+        else if (op == OpRgba)
+        {
+            if (compressed_size - read < 4)
+                return false;
+
+            pixel.R = compressed_data[read++];
+            pixel.G = compressed_data[read++];
+            pixel.B = compressed_data[read++];
+            pixel.A = compressed_data[read++];
+        }
+        else
+        {
+            switch (op & OpMask)
+            {
+                case OpIndex:
+                    pixel = cache[op & 0x3f];
+                    break;
+
+                case OpDiff:
+                    pixel.R += ((op >> 4) & 0x03) - 2;
+                    pixel.G += ((op >> 2) & 0x03) - 2;
+                    pixel.B += (op & 0x03) - 2;
+                    break;
+
+                case OpLuma:
+                {
+                    if (read >= compressed_size)
+                        return false;
+
+                    const uint8_t second = compressed_data[read++];
+                    const int dg = (op & 0x3f) - 32;
+                    pixel.R += dg - 8 + ((second >> 4) & 0x0f);
+                    pixel.G += dg;
+                    pixel.B += dg - 8 + (second & 0x0f);
+                }
+                break;
+
+                case OpRun:
+                {
+                    size_t run = (op & 0x3f) + 1;
+                    if (run > pixel_count - written)
+                        return false;
+
+                    while (run-- > 0)
+                        pixels[written++] = pixel;
+                }
+                continue;
+            }
+        }
+
+        cache[CacheIndex(pixel)] = pixel;
+        pixels[written++] = pixel;
+    }
+
+    return read == compressed_size;
+}
+
+uint64_t Hash(const void* data, size_t size)
+{
+    // FNV-1a over 64 bits words, then over the remaining bytes.
+    constexpr uint64_t Prime = 0x100000001b3ull;
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ word) * Prime;
+    }
+
+    for (; size > 0; --size, ++bytes)
+        hash = (hash ^ *bytes) * Prime;
+
+    return hash ^ (hash >> 32);
+}
+
+}
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ingame_overlay {
+
+// Lossless RGBA compression, QOI style: previous pixel runs, a 64 entries color cache and small channel deltas.
+// It is fast enough to keep CPU copies of images the GPU side doesn't need right now.
+namespace Image_Codec {
+
+std::vector<uint8_t> Compress(const void* image_data, size_t pixel_count);
+
+bool Decompress(const uint8_t* compressed_data, size_t compressed_size, void* image_data, size_t pixel_count);
+
+// 64 bits hash of a buffer, used to find identical images.
+uint64_t Hash(const void* data, size_t size);
+
+}
+
+}
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Image_Loader.h>
+
+#include "internal_includes.h"
+#include "Pixel_Convert.h"
+
+#include <algorithm>
+#include <fstream>
+
+#if defined(USE_STB_IMAGE)
+    // The application might already have its own stb_image, keep ours static.
+    #define STB_IMAGE_STATIC
+    #define STB_IMAGE_IMPLEMENTATION
+    #include <stb_image.h>
+#endif
+
+namespace ingame_overlay {
+
+struct Image_Loader::Request_t
+{
+    uint64_t Id;
+    std::string Path;
+    std::vector<uint8_t> EncodedData;
+    uint32_t MaxWidth, MaxHeight;
+    ImageLoadCallback Callback;
+    std::atomic<bool> Canceled;
+
+    // Filled by the worker before the Uploading event.
+    std::vector<uint8_t> Pixels;
+    uint32_t Width, Height;
+};
+
+#if defined(USE_STB_IMAGE)
+static bool StbImageDecoder(const void* encoded_data, size_t encoded_size, std::vector<uint8_t>& rgba, uint32_t& width, uint32_t& height)
+{
+    int w, h, channels;
+    stbi_uc* pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded_data), static_cast<int>(encoded_size), &w, &h, &channels, 4);
+    if (pixels == nullptr)
+        return false;
+
+    rgba.assign(pixels, pixels + static_cast<size_t>(w) * h * 4);
+    stbi_image_free(pixels);
+
+    width = static_cast<uint32_t>(w);
+    height = static_cast<uint32_t>(h);
+    return true;
+}
+#endif
+
+Image_Loader::Image_Loader(Renderer_Hook* renderer, uint32_t worker_count):
+    _Renderer(renderer),
+    _NextRequest(1),
+    _UploadBudget(4 * 1024 * 1024),
+    _StopWorkers(false)
+{
+#if defined(USE_STB_IMAGE)
+    _Decoder = &StbImageDecoder;
+#endif
+
+    worker_count = std::max<uint32_t>(worker_count, 1);
+    for (uint32_t i = 0; i < worker_count; ++i)
+        _Workers.emplace_back(&Image_Loader::_WorkerProc, this);
+}
+
+Image_Loader::~Image_Loader()
+{
+    {
+        std::lock_guard<std::mutex> lk(_JobsMutex);
+        _StopWorkers = true;
+    }
+    _JobsCV.notify_all();
+
+    for (auto& worker : _Workers)
+        worker.join();
+}
+
+void Image_Loader::_WorkerProc()
+{
+    while (true)
+    {
+        std::shared_ptr<Request_t> request;
+        ImageDecoder decoder;
+        {
+            std::unique_lock<std::mutex> lk(_JobsMutex);
+            _JobsCV.wait(lk, [this]() { return _StopWorkers || !_Jobs.empty(); });
+            if (_StopWorkers)
+                return;
+
+            request = std::move(_Jobs.front());
+            _Jobs.pop_front();
+            decoder = _Decoder;
+        }
+
+        _ProcessRequest(request, decoder);
+    }
+}
+
+void Image_Loader::_ProcessRequest(std::shared_ptr<Request_t> const& request, ImageDecoder const& decoder)
+{
+    if (request->Canceled)
+    {
+        _PushEvent(request, ImageLoadStatus::Canceled, 0.0f);
+        return;
+    }
+
+    _PushEvent(request, ImageLoadStatus::Decoding, 0.1f);
+
+    if (!request->Path.empty())
+    {
+        std::ifstream file(request->Path, std::ios::in | std::ios::binary);
+        if (!file)
+        {
+            SPDLOG_WARN("Failed to open image file {}.", request->Path);
+            _PushEvent(request, ImageLoadStatus::Failed, 0.0f);
+            return;
+        }
+
+        file.seekg(0, std::ios::end);
+        request->EncodedData.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, std::ios::beg);
+        file.read(reinterpret_cast<char*>(request->EncodedData.data()), request->EncodedData.size());
+        if (!file)
+        {
+            SPDLOG_WARN("Failed to read image file {}.", request->Path);
+            _PushEvent(request, ImageLoadStatus::Failed, 0.0f);
+            return;
+        }
+    }
+
+    if (!decoder)
+    {
+        SPDLOG_WARN("Failed to decode image: no image decoder, see Image_Loader::SetDecoder.");
+        _PushEvent(request, ImageLoadStatus::Failed, 0.0f);
+        return;
+    }
+
+    std::vector<uint8_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    if (!decoder(request->EncodedData.data(), request->EncodedData.size(), pixels, width, height) || width == 0 || height == 0 || pixels.size() < static_cast<size_t>(width) * height * 4)
+    {
+        _PushEvent(request, ImageLoadStatus::Failed, 0.0f);
+        return;
+    }
+
+    request->EncodedData.clear();
+    request->EncodedData.shrink_to_fit();
+
+    if (request->Canceled)
+    {
+        _PushEvent(request, ImageLoadStatus::Canceled, 0.0f);
+        return;
+    }
+
+    _PushEvent(request, ImageLoadStatus::Decoding, 0.5f);
+
+    // Fit in the requested size, keeping the aspect ratio.
+    if (!Pixel_Convert::Fit(pixels.data(), width, height, request->MaxWidth, request->MaxHeight, request->Pixels, width, height))
+        request->Pixels = std::move(pixels);
+
+    request->Width = width;
+    request->Height = height;
+
+    _PushEvent(request, ImageLoadStatus::Uploading, 0.75f);
+}
+
+void Image_Loader::_PushEvent(std::shared_ptr<Request_t> const& request, ImageLoadStatus status, float progress)
+{
+    std::lock_guard<std::mutex> lk(_EventsMutex);
+    _Events.emplace_back(Event_t{ request, status, progress });
+}
+
+uint64_t Image_Loader::_Enqueue(std::shared_ptr<Request_t> request)
+{
+    const uint64_t id = _NextRequest.fetch_add(1);
+    request->Id = id;
+    request->Canceled = false;
+    request->Width = 0;
+    request->Height = 0;
+
+    // Before the job is visible, so Queued is always the first status.
+    _PushEvent(request, ImageLoadStatus::Queued, 0.0f);
+
+    {
+        std::lock_guard<std::mutex> lk(_JobsMutex);
+        // Forget the requests that completed, every now and then.
+        if (_Requests.size() >= 64)
+        {
+            for (auto it = _Requests.begin(); it != _Requests.end();)
+            {
+                if (it->second.expired())
+                    it = _Requests.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        _Requests[id] = request;
+        _Jobs.emplace_back(request);
+    }
+    _JobsCV.notify_one();
+
+    return id;
+}
+
+void Image_Loader::SetDecoder(ImageDecoder decoder)
+{
+    std::lock_guard<std::mutex> lk(_JobsMutex);
+    _Decoder = std::move(decoder);
+}
+
+void Image_Loader::SetUploadBudget(uint64_t bytes_per_frame)
+{
+    _UploadBudget = bytes_per_frame;
+}
+
+uint64_t Image_Loader::CreateImageResourceFromMemory(const void* encoded_data, size_t encoded_size, uint32_t max_width, uint32_t max_height, ImageLoadCallback callback)
+{
+    std::shared_ptr<Request_t> request(new Request_t);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(encoded_data);
+    if (data != nullptr)
+        request->EncodedData.assign(data, data + encoded_size);
+
+    request->MaxWidth = max_width;
+    request->MaxHeight = max_height;
+    request->Callback = std::move(callback);
+
+    return _Enqueue(std::move(request));
+}
+
+uint64_t Image_Loader::CreateImageResourceFromFile(std::string const& path, uint32_t max_width, uint32_t max_height, ImageLoadCallback callback)
+{
+    std::shared_ptr<Request_t> request(new Request_t);
+    request->Path = path;
+    request->MaxWidth = max_width;
+    request->MaxHeight = max_height;
+    request->Callback = std::move(callback);
+
+    return _Enqueue(std::move(request));
+}
+
+void Image_Loader::Cancel(uint64_t request)
+{
+    std::lock_guard<std::mutex> lk(_JobsMutex);
+    auto it = _Requests.find(request);
+    if (it == _Requests.end())
+        return;
+
+    std::shared_ptr<Request_t> item = it->second.lock();
+    if (item != nullptr)
+        item->Canceled = true;
+
+    _Requests.erase(it);
+}
+
+void Image_Loader::Update()
+{
+    auto notify = [](Request_t& request, ImageLoadStatus status, float progress, ImageResourceHandle resource)
+    {
+        if (request.Callback)
+            request.Callback(request.Id, status, progress, resource);
+    };
+
+    if (_EventsMutex.try_lock())
+    {
+        std::swap(_Events, _EventsSwap);
+        _EventsMutex.unlock();
+    }
+
+    for (auto& event : _EventsSwap)
+    {
+        if (event.Status == ImageLoadStatus::Uploading)
+            _PendingUploads.emplace_back(event.Request);
+
+        notify(*event.Request, event.Status, event.Progress, 0);
+    }
+    _EventsSwap.clear();
+
+    uint64_t uploaded_bytes = 0;
+    while (!_PendingUploads.empty())
+    {
+        std::shared_ptr<Request_t> request = _PendingUploads.front();
+        if (request->Canceled)
+        {
+            _PendingUploads.pop_front();
+            notify(*request, ImageLoadStatus::Canceled, 0.0f, 0);
+            continue;
+        }
+
+        const uint64_t size = static_cast<uint64_t>(request->Width) * request->Height * 4;
+        // Always upload at least one image, or a big one would never fit.
+        if (_UploadBudget != 0 && uploaded_bytes != 0 && uploaded_bytes + size > _UploadBudget)
+            break;
+
+        _PendingUploads.pop_front();
+
+        ImageResourceHandle resource = _Renderer->CreateImageResource(request->Pixels.data(), request->Width, request->Height);
+        uploaded_bytes += size;
+        request->Pixels.clear();
+        request->Pixels.shrink_to_fit();
+
+        if (resource == 0)
+            notify(*request, ImageLoadStatus::Failed, 0.0f, 0);
+        else
+            notify(*request, ImageLoadStatus::Ready, 1.0f, resource);
+    }
+}
+
+}
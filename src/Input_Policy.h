@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ingame_overlay/Renderer_Hook.h>
+
+#include <atomic>
+#include <cstdint>
+
+// ingame_overlay::InputPolicyFlags of a platform hook, in a single atomic word.
+// Written from any thread, read by the game's input thread on every event, so a change of several flags is never seen half done.
+// Changes are released and loads acquire: what a thread did before changing the policy is visible to the input thread that sees the change.
+class Input_Policy
+{
+    std::atomic<uint32_t> _Flags;
+
+public:
+    explicit Input_Policy(uint32_t flags):
+        _Flags(flags)
+    {}
+
+    uint32_t Load() const
+    {
+        return _Flags.load(std::memory_order_acquire);
+    }
+
+    bool AppInputsHidden() const
+    {
+        return (Load() & ingame_overlay::InputPolicy_HideAppInputs) != 0;
+    }
+
+    bool OverlayInputsHidden() const
+    {
+        return (Load() & ingame_overlay::InputPolicy_HideOverlayInputs) != 0;
+    }
+
+    // Replaces the flags in mask by the ones of flags, returns the previous flags.
+    uint32_t Set(uint32_t mask, uint32_t flags)
+    {
+        uint32_t previous = _Flags.load(std::memory_order_relaxed);
+        while (!_Flags.compare_exchange_weak(previous, (previous & ~mask) | (flags & mask), std::memory_order_acq_rel, std::memory_order_relaxed))
+        {
+        }
+
+        return previous;
+    }
+
+    // Flips flags, returns the previous flags.
+    uint32_t Toggle(uint32_t flags)
+    {
+        return _Flags.fetch_xor(flags, std::memory_order_acq_rel);
+    }
+};
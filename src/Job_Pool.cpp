@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Job_Pool.h>
+
+#include "internal_includes.h"
+#include "Lockfree_Queue.h"
+
+#include <algorithm>
+#include <deque>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/resource.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#elif defined(__APPLE__)
+    #include <pthread.h>
+#endif
+
+namespace ingame_overlay {
+
+static constexpr size_t PriorityCount = 3;
+
+struct Job_Pool::Worker_t
+{
+    std::thread Thread;
+    std::mutex Mutex;
+    // One queue per JobPriority.
+    std::deque<Job> Jobs[PriorityCount];
+};
+
+struct Job_Pool::Completions_t
+{
+    Mpsc_Queue<Job> Queue;
+};
+
+// Lets a job submit to its own worker, its data is likely still in this core cache.
+static thread_local const Job_Pool* CurrentPool = nullptr;
+static thread_local uint32_t CurrentWorker = 0;
+
+static void SetupWorkerThread(JobPoolOptions const& options)
+{
+#if defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(WIN64)
+    if (options.CpuMask != 0 && SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(options.CpuMask)) == 0)
+    {
+        SPDLOG_WARN("Failed to set the job worker affinity: {}.", GetLastError());
+    }
+
+    if (options.BelowNormalPriority)
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    if (options.CpuMask != 0)
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int i = 0; i < 64 && i < CPU_SETSIZE; ++i)
+        {
+            if ((options.CpuMask >> i) & 1)
+                CPU_SET(i, &cpus);
+        }
+
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) != 0)
+        {
+            SPDLOG_WARN("Failed to set the job worker affinity.");
+        }
+    }
+
+    // On Linux, the nice value is per thread.
+    if (options.BelowNormalPriority)
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 5);
+#elif defined(__APPLE__)
+    // MacOS has no hard affinity, only the priority is applied.
+    if (options.BelowNormalPriority)
+        pthread_set_qos_class_self_np(QOS_CLASS_UTILITY, 0);
+#endif
+}
+
+uint32_t Job_Pool::DefaultWorkerCount()
+{
+    const uint32_t hardware_threads = std::thread::hardware_concurrency();
+    return std::min<uint32_t>(std::max<uint32_t>(hardware_threads / 4, 1), 4);
+}
+
+Job_Pool::Job_Pool(JobPoolOptions const& options):
+    _Completions(new Completions_t),
+    _NextWorker(0),
+    _QueuedJobs(0),
+    _Stop(false)
+{
+    const uint32_t worker_count = options.WorkerCount == 0 ? DefaultWorkerCount() : options.WorkerCount;
+
+    // Every worker exists before the first one starts stealing.
+    for (uint32_t i = 0; i < worker_count; ++i)
+        _Workers.emplace_back(new Worker_t);
+
+    for (uint32_t i = 0; i < worker_count; ++i)
+        _Workers[i]->Thread = std::thread(&Job_Pool::_WorkerProc, this, i, options);
+
+    SPDLOG_INFO("Job pool started with {} workers.", worker_count);
+}
+
+Job_Pool::~Job_Pool()
+{
+    {
+        std::lock_guard<std::mutex> lk(_SleepMutex);
+        _Stop = true;
+    }
+    _SleepCV.notify_all();
+
+    for (auto& worker : _Workers)
+        worker->Thread.join();
+}
+
+uint32_t Job_Pool::WorkerCount() const
+{
+    return static_cast<uint32_t>(_Workers.size());
+}
+
+void Job_Pool::_WorkerProc(uint32_t index, JobPoolOptions options)
+{
+    CurrentPool = this;
+    CurrentWorker = index;
+    SetupWorkerThread(options);
+
+    Job job;
+    while (true)
+    {
+        if (_PopJob(index, job))
+        {
+            job();
+            job = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lk(_SleepMutex);
+        _SleepCV.wait(lk, [this]() { return _Stop || _QueuedJobs != 0; });
+        if (_Stop)
+            return;
+    }
+}
+
+bool Job_Pool::_PopJob(uint32_t index, Job& job)
+{
+    const size_t worker_count = _Workers.size();
+    for (size_t priority = 0; priority < PriorityCount; ++priority)
+    {
+        {// Own jobs first, in submission order.
+            Worker_t& worker = *_Workers[index];
+            std::lock_guard<std::mutex> lk(worker.Mutex);
+            if (!worker.Jobs[priority].empty())
+            {
+                job = std::move(worker.Jobs[priority].front());
+                worker.Jobs[priority].pop_front();
+                --_QueuedJobs;
+                return true;
+            }
+        }
+
+        // Then steal the newest job of another worker, its owner keeps the older ones in order.
+        for (size_t i = 1; i < worker_count; ++i)
+        {
+            Worker_t& victim = *_Workers[(index + i) % worker_count];
+            std::lock_guard<std::mutex> lk(victim.Mutex);
+            if (!victim.Jobs[priority].empty())
+            {
+                job = std::move(victim.Jobs[priority].back());
+                victim.Jobs[priority].pop_back();
+                --_QueuedJobs;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void Job_Pool::_Push(Job job, JobOptions const& options)
+{
+    const uint32_t worker_count = static_cast<uint32_t>(_Workers.size());
+    uint32_t index;
+    if (options.Worker >= 0)
+        index = static_cast<uint32_t>(options.Worker) % worker_count;
+    else if (CurrentPool == this)
+        index = CurrentWorker;
+    else
+        index = _NextWorker.fetch_add(1, std::memory_order_relaxed) % worker_count;
+
+    // Counted before the push, a worker may find it right away.
+    ++_QueuedJobs;
+    {
+        Worker_t& worker = *_Workers[index];
+        std::lock_guard<std::mutex> lk(worker.Mutex);
+        worker.Jobs[static_cast<size_t>(options.Priority)].emplace_back(std::move(job));
+    }
+
+    {// Pairs with the wait predicate, so a worker going to sleep can't miss this job.
+        std::lock_guard<std::mutex> lk(_SleepMutex);
+    }
+    _SleepCV.notify_one();
+}
+
+void Job_Pool::Submit(Job job, JobOptions const& options)
+{
+    if (!job)
+        return;
+
+    _Push(std::move(job), options);
+}
+
+void Job_Pool::Submit(Job job, Job completion, JobOptions const& options)
+{
+    if (!job)
+        return;
+
+    if (!completion)
+    {
+        _Push(std::move(job), options);
+        return;
+    }
+
+    Completions_t* completions = _Completions.get();
+    // The job lambda is const, the completion is moved out of a shared state once the job is done.
+    auto shared_completion = std::make_shared<Job>(std::move(completion));
+    _Push([job = std::move(job), completions, shared_completion]()
+    {
+        job();
+        completions->Queue.Push(std::move(*shared_completion));
+    }, options);
+}
+
+void Job_Pool::PostCompletion(Job completion)
+{
+    if (!completion)
+        return;
+
+    _Completions->Queue.Push(std::move(completion));
+}
+
+size_t Job_Pool::DrainCompletions(size_t max_count)
+{
+    size_t count = 0;
+    Job completion;
+    while ((max_count == 0 || count < max_count) && _Completions->Queue.Pop(completion))
+    {
+        completion();
+        completion = nullptr;
+        ++count;
+    }
+
+    return count;
+}
+
+}
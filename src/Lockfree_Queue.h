@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Unbounded multiple producers, single consumer queue.
+// Push never blocks and can be called from any thread, Pop must always be called from the same thread.
+// A Pop racing with a Push may miss the pushed value, it will be there on the next Pop.
+template<typename T>
+class Mpsc_Queue
+{
+    struct Node_t
+    {
+        std::atomic<Node_t*> Next;
+        T Value;
+    };
+
+    // Producers side, last pushed node.
+    std::atomic<Node_t*> _Head;
+    // Consumer side, already consumed node whose Next is the next value to pop.
+    Node_t* _Tail;
+
+    Mpsc_Queue(const Mpsc_Queue&) = delete;
+    Mpsc_Queue(Mpsc_Queue&&) = delete;
+    Mpsc_Queue& operator =(const Mpsc_Queue&) = delete;
+    Mpsc_Queue& operator =(Mpsc_Queue&&) = delete;
+
+public:
+    Mpsc_Queue()
+    {
+        Node_t* stub = new Node_t();
+        stub->Next.store(nullptr, std::memory_order_relaxed);
+        _Head.store(stub, std::memory_order_relaxed);
+        _Tail = stub;
+    }
+
+    ~Mpsc_Queue()
+    {
+        T value;
+        while (Pop(value))
+        {
+        }
+
+        delete _Tail;
+    }
+
+    void Push(T value)
+    {
+        Node_t* node = new Node_t();
+        node->Next.store(nullptr, std::memory_order_relaxed);
+        node->Value = std::move(value);
+
+        Node_t* previous = _Head.exchange(node, std::memory_order_acq_rel);
+        previous->Next.store(node, std::memory_order_release);
+    }
+
+    bool Pop(T& value)
+    {
+        Node_t* tail = _Tail;
+        Node_t* next = tail->Next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+
+        // next becomes the new stub, its value is moved out.
+        value = std::move(next->Value);
+        next->Value = T();
+        _Tail = next;
+        delete tail;
+        return true;
+    }
+};
+
+// Bounded single producer, multiple consumers ring of trivially copyable values.
+// Push must always be called from the same thread, Pop can be called from any thread.
+template<typename T, size_t Capacity>
+class Spmc_Ring
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Spmc_Ring values must be trivially copyable.");
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "Spmc_Ring capacity must be a power of 2.");
+
+    std::atomic<T> _Values[Capacity];
+    std::atomic<size_t> _Head;
+    std::atomic<size_t> _Tail;
+
+    Spmc_Ring(const Spmc_Ring&) = delete;
+    Spmc_Ring(Spmc_Ring&&) = delete;
+    Spmc_Ring& operator =(const Spmc_Ring&) = delete;
+    Spmc_Ring& operator =(Spmc_Ring&&) = delete;
+
+public:
+    Spmc_Ring():
+        _Head(0),
+        _Tail(0)
+    {}
+
+    bool Full() const
+    {
+        return _Tail.load(std::memory_order_relaxed) - _Head.load(std::memory_order_acquire) >= Capacity;
+    }
+
+    bool Push(T value)
+    {
+        const size_t tail = _Tail.load(std::memory_order_relaxed);
+        if (tail - _Head.load(std::memory_order_acquire) >= Capacity)
+            return false;
+
+        _Values[tail & (Capacity - 1)].store(value, std::memory_order_relaxed);
+        _Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool Pop(T& value)
+    {
+        size_t head = _Head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            if (head == _Tail.load(std::memory_order_acquire))
+                return false;
+
+            // The slot can only be overwritten once head moved past it, in which case the exchange below fails.
+            value = _Values[head & (Capacity - 1)].load(std::memory_order_relaxed);
+            if (_Head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+                return true;
+        }
+    }
+};
@@ -0,0 +1,495 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <glad/gl.h>
+
+#include "OpenGL_Quad_Renderer.h"
+#include "internal_includes.h"
+
+#include <imgui.h>
+#include <backends/imgui_impl_opengl3.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Shorter runs stay on the ImGui path, a run costs a program switch and a render state reset.
+static constexpr uint32_t MinQuadRun = 4;
+
+static const char QuadVertexShader[] =
+    "#version 140\n"
+    "uniform mat4 ProjMtx;\n"
+    "in vec4 Rect;\n"
+    "in vec4 UvRect;\n"
+    "in vec4 Color;\n"
+    "out vec2 Frag_UV;\n"
+    "out vec4 Frag_Color;\n"
+    "void main()\n"
+    "{\n"
+    // Triangle strip corners: (0, 0) (1, 0) (0, 1) (1, 1).
+    "    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));\n"
+    "    Frag_UV = mix(UvRect.xy, UvRect.zw, corner);\n"
+    "    Frag_Color = Color;\n"
+    "    gl_Position = ProjMtx * vec4(mix(Rect.xy, Rect.zw, corner), 0, 1);\n"
+    "}\n";
+
+static const char QuadFragmentShader[] =
+    "#version 140\n"
+    "uniform sampler2D Texture;\n"
+    "in vec2 Frag_UV;\n"
+    "in vec4 Frag_Color;\n"
+    "out vec4 Out_Color;\n"
+    "void main()\n"
+    "{\n"
+    "    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);\n"
+    "}\n";
+
+enum QuadAttribute : GLuint
+{
+    QuadAttribute_Rect,
+    QuadAttribute_UvRect,
+    QuadAttribute_Color,
+};
+
+struct QuadInstance_t
+{
+    // x0, y0, x1, y1
+    float Rect[4];
+    float UvRect[4];
+    ImU32 Color;
+};
+
+struct QuadRun_t
+{
+    OpenGL_Quad_Renderer* Renderer;
+    uint32_t FirstQuad;
+    uint32_t QuadCount;
+};
+
+struct OpenGL_Quad_Renderer::Frame_t
+{
+    std::vector<QuadInstance_t> Quads;
+    // The draw commands point at them, the vector doesn't grow once the commands are built.
+    std::vector<QuadRun_t> Runs;
+    bool Uploaded;
+    ImVec2 ClipOffset;
+    ImVec2 ClipScale;
+    int FramebufferHeight;
+
+    // Scratch buffers, kept between frames.
+    ImVector<ImDrawCmd> Commands;
+    std::vector<uint32_t> VertexRemap;
+};
+
+static void QuadDrawCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+    const QuadRun_t* run = reinterpret_cast<const QuadRun_t*>(cmd->UserCallbackData);
+    run->Renderer->DrawQuads(run->FirstQuad, run->QuadCount, cmd);
+}
+
+// The quads of ImDrawList::PrimRectUV: 4 vertices with the same color, the first and third are opposite corners.
+static inline bool IsQuad(const ImDrawVert* vertices, uint32_t vertex_count, const ImDrawIdx* indices)
+{
+    const uint32_t a = indices[0];
+    if (indices[1] != a + 1 || indices[2] != a + 2 || indices[3] != a || indices[4] != a + 2 || indices[5] != a + 3 || a + 3 >= vertex_count)
+        return false;
+
+    const ImDrawVert* v = vertices + a;
+    return v[0].col == v[1].col && v[0].col == v[2].col && v[0].col == v[3].col &&
+        v[0].pos.y == v[1].pos.y && v[1].pos.x == v[2].pos.x && v[2].pos.y == v[3].pos.y && v[3].pos.x == v[0].pos.x &&
+        v[0].uv.y == v[1].uv.y && v[1].uv.x == v[2].uv.x && v[2].uv.y == v[3].uv.y && v[3].uv.x == v[0].uv.x;
+}
+
+static GLuint CompileShader(GLenum type, const char* source)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[512] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        SPDLOG_WARN("Failed to compile the quad {} shader: {}", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+OpenGL_Quad_Renderer::OpenGL_Quad_Renderer():
+    _Program(0),
+    _VertexArray(0),
+    _InstanceBuffer(0),
+    _ProjectionLocation(-1),
+    _BuildFailed(false),
+    _Enabled(true),
+    _Frame(new Frame_t)
+{
+    _Frame->Uploaded = false;
+    _Frame->FramebufferHeight = 0;
+}
+
+OpenGL_Quad_Renderer::~OpenGL_Quad_Renderer()
+{}
+
+bool OpenGL_Quad_Renderer::_Build()
+{
+    if (!GLAD_GL_VERSION_3_1 || !GLAD_GL_ARB_instanced_arrays)
+    {
+        SPDLOG_INFO("No instanced arrays, quads are drawn by the ImGui renderer.");
+        return false;
+    }
+
+    GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, QuadVertexShader);
+    GLuint fragment_shader = CompileShader(GL_FRAGMENT_SHADER, QuadFragmentShader);
+    if (vertex_shader == 0 || fragment_shader == 0)
+    {
+        if (vertex_shader != 0)
+            glDeleteShader(vertex_shader);
+        if (fragment_shader != 0)
+            glDeleteShader(fragment_shader);
+
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+    glBindAttribLocation(program, QuadAttribute_Rect, "Rect");
+    glBindAttribLocation(program, QuadAttribute_UvRect, "UvRect");
+    glBindAttribLocation(program, QuadAttribute_Color, "Color");
+    glLinkProgram(program);
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[512] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        SPDLOG_WARN("Failed to link the quad program: {}", log);
+        glDeleteProgram(program);
+        return false;
+    }
+
+    // Called before the ImGui backend backed the game render state up.
+    GLint last_program, last_vertex_array, last_array_buffer;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &last_program);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &last_vertex_array);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &last_array_buffer);
+
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "Texture"), 0);
+
+    GLuint vertex_array, instance_buffer;
+    glGenVertexArrays(1, &vertex_array);
+    glGenBuffers(1, &instance_buffer);
+    glBindVertexArray(vertex_array);
+    glBindBuffer(GL_ARRAY_BUFFER, instance_buffer);
+    for (GLuint attribute : { QuadAttribute_Rect, QuadAttribute_UvRect, QuadAttribute_Color })
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisorARB(attribute, 1);
+    }
+
+    glUseProgram(static_cast<GLuint>(last_program));
+    glBindVertexArray(static_cast<GLuint>(last_vertex_array));
+    glBindBuffer(GL_ARRAY_BUFFER, static_cast<GLuint>(last_array_buffer));
+
+    _Program = program;
+    _VertexArray = vertex_array;
+    _InstanceBuffer = instance_buffer;
+    _ProjectionLocation = glGetUniformLocation(program, "ProjMtx");
+    return true;
+}
+
+bool OpenGL_Quad_Renderer::_ExtractQuads(void* imgui_draw_list)
+{
+    ImDrawList* draw_list = reinterpret_cast<ImDrawList*>(imgui_draw_list);
+    Frame_t& frame = *_Frame;
+    const ImDrawVert* vertices = draw_list->VtxBuffer.Data;
+    const uint32_t vertex_count = static_cast<uint32_t>(draw_list->VtxBuffer.Size);
+    ImDrawIdx* indices = draw_list->IdxBuffer.Data;
+
+    for (ImDrawCmd const& cmd : draw_list->CmdBuffer)
+    {// Lists over 64K vertices, the quad indices would need the offset.
+        if (cmd.UserCallback == nullptr && cmd.VtxOffset != 0)
+            return false;
+    }
+
+    ImVector<ImDrawCmd>& commands = frame.Commands;
+    commands.resize(0);
+
+    // Kept indices are moved down over the quads ones.
+    uint32_t written = 0;
+    bool extracted = false;
+    // Callbacks may change the render state, like the SDF shader, quads are only taken from the ImGui state.
+    bool default_state = true;
+    for (ImDrawCmd const& cmd : draw_list->CmdBuffer)
+    {
+        if (cmd.UserCallback != nullptr)
+        {
+            default_state = cmd.UserCallback == ImDrawCallback_ResetRenderState;
+            commands.push_back(cmd);
+            continue;
+        }
+
+        const uint32_t end = cmd.IdxOffset + cmd.ElemCount;
+        uint32_t segment_start = written;
+        uint32_t i = cmd.IdxOffset;
+        while (i < end)
+        {
+            uint32_t quads = 0;
+            if (default_state)
+            {
+                while (i + 6 * (quads + 1) <= end && IsQuad(vertices, vertex_count, indices + i + 6 * quads))
+                    ++quads;
+            }
+
+            if (quads < MinQuadRun)
+            {
+                const uint32_t count = quads > 0 ? 6 * quads : std::min<uint32_t>(3, end - i);
+                if (written != i)
+                    memmove(indices + written, indices + i, count * sizeof(ImDrawIdx));
+
+                written += count;
+                i += count;
+                continue;
+            }
+
+            if (written != segment_start)
+            {
+                ImDrawCmd triangles = cmd;
+                triangles.IdxOffset = segment_start;
+                triangles.ElemCount = written - segment_start;
+                commands.push_back(triangles);
+            }
+
+            QuadRun_t run{ this, static_cast<uint32_t>(frame.Quads.size()), quads };
+            for (uint32_t q = 0; q < quads; ++q, i += 6)
+            {
+                const ImDrawVert* v = vertices + indices[i];
+                QuadInstance_t quad;
+                quad.Rect[0] = v[0].pos.x;
+                quad.Rect[1] = v[0].pos.y;
+                quad.Rect[2] = v[2].pos.x;
+                quad.Rect[3] = v[2].pos.y;
+                quad.UvRect[0] = v[0].uv.x;
+                quad.UvRect[1] = v[0].uv.y;
+                quad.UvRect[2] = v[2].uv.x;
+                quad.UvRect[3] = v[2].uv.y;
+                quad.Color = v[0].col;
+                frame.Quads.emplace_back(quad);
+            }
+            frame.Runs.emplace_back(run);
+
+            // UserCallbackData is set once every run is built.
+            ImDrawCmd quads_cmd = cmd;
+            quads_cmd.IdxOffset = written;
+            quads_cmd.ElemCount = 0;
+            quads_cmd.UserCallback = &QuadDrawCallback;
+            quads_cmd.UserCallbackData = nullptr;
+            commands.push_back(quads_cmd);
+
+            ImDrawCmd reset_cmd = cmd;
+            reset_cmd.ElemCount = 0;
+            reset_cmd.UserCallback = ImDrawCallback_ResetRenderState;
+            reset_cmd.UserCallbackData = nullptr;
+            commands.push_back(reset_cmd);
+
+            segment_start = written;
+            extracted = true;
+        }
+
+        if (written != segment_start)
+        {
+            ImDrawCmd triangles = cmd;
+            triangles.IdxOffset = segment_start;
+            triangles.ElemCount = written - segment_start;
+            commands.push_back(triangles);
+        }
+    }
+
+    // Nothing moved, the draw list is left as is.
+    if (!extracted)
+        return false;
+
+    // Drops the quads vertices, ImGui never shares the vertices of a quad with another primitive.
+    std::vector<uint32_t>& remap = frame.VertexRemap;
+    remap.assign(vertex_count, UINT32_MAX);
+    for (uint32_t i = 0; i < written; ++i)
+        remap[indices[i]] = 0;
+
+    uint32_t kept_vertices = 0;
+    ImDrawVert* out_vertices = draw_list->VtxBuffer.Data;
+    for (uint32_t v = 0; v < vertex_count; ++v)
+    {
+        if (remap[v] == UINT32_MAX)
+            continue;
+
+        remap[v] = kept_vertices;
+        out_vertices[kept_vertices++] = out_vertices[v];
+    }
+
+    for (uint32_t i = 0; i < written; ++i)
+        indices[i] = static_cast<ImDrawIdx>(remap[indices[i]]);
+
+    draw_list->VtxBuffer.resize(static_cast<int>(kept_vertices));
+    draw_list->IdxBuffer.resize(static_cast<int>(written));
+    // The old commands buffer is the scratch buffer of the next list.
+    draw_list->CmdBuffer.swap(commands);
+    return true;
+}
+
+void OpenGL_Quad_Renderer::RenderDrawData(void* imgui_draw_data)
+{
+    ImDrawData* draw_data = reinterpret_cast<ImDrawData*>(imgui_draw_data);
+    if (draw_data == nullptr)
+        return;
+
+    Frame_t& frame = *_Frame;
+    frame.Quads.clear();
+    frame.Runs.clear();
+    frame.Uploaded = false;
+
+    if (_Enabled && _Program == 0 && !_BuildFailed)
+        _BuildFailed = !_Build();
+
+    if (_Enabled && _Program != 0)
+    {
+        frame.ClipOffset = draw_data->DisplayPos;
+        frame.ClipScale = draw_data->FramebufferScale;
+        frame.FramebufferHeight = static_cast<int>(draw_data->DisplaySize.y * draw_data->FramebufferScale.y);
+
+        bool extracted = false;
+        for (int i = 0; i < draw_data->CmdListsCount; ++i)
+            extracted = _ExtractQuads(draw_data->CmdLists[i]) || extracted;
+
+        if (extracted)
+        {
+            size_t run = 0;
+            int total_vertices = 0;
+            int total_indices = 0;
+            for (int i = 0; i < draw_data->CmdListsCount; ++i)
+            {
+                ImDrawList* draw_list = draw_data->CmdLists[i];
+                for (ImDrawCmd& cmd : draw_list->CmdBuffer)
+                {
+                    if (cmd.UserCallback == &QuadDrawCallback)
+                        cmd.UserCallbackData = &frame.Runs[run++];
+                }
+
+                total_vertices += draw_list->VtxBuffer.Size;
+                total_indices += draw_list->IdxBuffer.Size;
+            }
+
+            draw_data->TotalVtxCount = total_vertices;
+            draw_data->TotalIdxCount = total_indices;
+        }
+    }
+
+    ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+}
+
+void OpenGL_Quad_Renderer::DrawQuads(uint32_t first_quad, uint32_t quad_count, const void* imgui_draw_cmd)
+{
+    const ImDrawCmd& cmd = *reinterpret_cast<const ImDrawCmd*>(imgui_draw_cmd);
+    Frame_t& frame = *_Frame;
+
+    // The ImGui backend backed the game render state up, it restores it after the last list.
+    if (!frame.Uploaded)
+    {// First run of the frame, the current program is the ImGui one, with the projection of this frame.
+        GLint imgui_program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &imgui_program);
+
+        GLfloat projection[16];
+        glGetUniformfv(static_cast<GLuint>(imgui_program), glGetUniformLocation(static_cast<GLuint>(imgui_program), "ProjMtx"), projection);
+
+        glUseProgram(_Program);
+        glUniformMatrix4fv(_ProjectionLocation, 1, GL_FALSE, projection);
+
+        // Orphans last frame buffer, the driver doesn't wait for the GPU to be done with it.
+        glBindBuffer(GL_ARRAY_BUFFER, _InstanceBuffer);
+        glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(frame.Quads.size() * sizeof(QuadInstance_t)), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(frame.Quads.size() * sizeof(QuadInstance_t)), frame.Quads.data());
+        frame.Uploaded = true;
+    }
+    else
+    {
+        glUseProgram(_Program);
+        glBindBuffer(GL_ARRAY_BUFFER, _InstanceBuffer);
+    }
+
+    // Same scissor as the ImGui backend, framebuffer origin at the bottom left.
+    const ImVec2 clip_min((cmd.ClipRect.x - frame.ClipOffset.x) * frame.ClipScale.x, (cmd.ClipRect.y - frame.ClipOffset.y) * frame.ClipScale.y);
+    const ImVec2 clip_max((cmd.ClipRect.z - frame.ClipOffset.x) * frame.ClipScale.x, (cmd.ClipRect.w - frame.ClipOffset.y) * frame.ClipScale.y);
+    if (clip_max.x <= clip_min.x || clip_max.y <= clip_min.y)
+        return;
+
+    glScissor(static_cast<GLint>(clip_min.x), static_cast<GLint>(frame.FramebufferHeight - clip_max.y), static_cast<GLsizei>(clip_max.x - clip_min.x), static_cast<GLsizei>(clip_max.y - clip_min.y));
+
+    // No base instance before GL 4.2, the attributes start at the run.
+    const size_t offset = first_quad * sizeof(QuadInstance_t);
+    glBindVertexArray(_VertexArray);
+    glVertexAttribPointer(QuadAttribute_Rect, 4, GL_FLOAT, GL_FALSE, sizeof(QuadInstance_t), reinterpret_cast<const void*>(offset + offsetof(QuadInstance_t, Rect)));
+    glVertexAttribPointer(QuadAttribute_UvRect, 4, GL_FLOAT, GL_FALSE, sizeof(QuadInstance_t), reinterpret_cast<const void*>(offset + offsetof(QuadInstance_t, UvRect)));
+    glVertexAttribPointer(QuadAttribute_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(QuadInstance_t), reinterpret_cast<const void*>(offset + offsetof(QuadInstance_t, Color)));
+
+    glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(reinterpret_cast<intptr_t>(cmd.GetTexID())));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(quad_count));
+}
+
+void OpenGL_Quad_Renderer::SetEnabled(bool enabled)
+{
+    _Enabled = enabled;
+}
+
+uint32_t OpenGL_Quad_Renderer::GetQuadCount() const
+{
+    return static_cast<uint32_t>(_Frame->Quads.size());
+}
+
+size_t OpenGL_Quad_Renderer::GetQuadBytes() const
+{
+    return _Frame->Quads.size() * sizeof(QuadInstance_t);
+}
+
+void OpenGL_Quad_Renderer::Destroy()
+{
+    if (_Program != 0)
+        glDeleteProgram(_Program);
+    if (_VertexArray != 0)
+        glDeleteVertexArrays(1, &_VertexArray);
+    if (_InstanceBuffer != 0)
+        glDeleteBuffers(1, &_InstanceBuffer);
+
+    _Program = 0;
+    _VertexArray = 0;
+    _InstanceBuffer = 0;
+    _ProjectionLocation = -1;
+    _BuildFailed = false;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Renders ImDrawData with the ImGui OpenGL3 backend, except the runs of axis aligned quads (glyphs, filled rectangles, images):
+// they are taken out of the draw lists and drawn as instances of one rectangle, one UV rectangle and one color,
+// 36 bytes instead of 4 ImDrawVert and 6 indices. The other triangles stay on the ImGui path, in the same order.
+// Needs OpenGL 3.1 and ARB_instanced_arrays, else the draw data goes to the ImGui backend unchanged.
+class OpenGL_Quad_Renderer
+{
+    struct Frame_t;
+
+    uint32_t _Program;
+    uint32_t _VertexArray;
+    uint32_t _InstanceBuffer;
+    int32_t _ProjectionLocation;
+    bool _BuildFailed;
+    bool _Enabled;
+    // Per frame instances, runs and scratch buffers.
+    std::unique_ptr<Frame_t> _Frame;
+
+    OpenGL_Quad_Renderer(const OpenGL_Quad_Renderer&) = delete;
+    OpenGL_Quad_Renderer(OpenGL_Quad_Renderer&&) = delete;
+    OpenGL_Quad_Renderer& operator =(const OpenGL_Quad_Renderer&) = delete;
+    OpenGL_Quad_Renderer& operator =(OpenGL_Quad_Renderer&&) = delete;
+
+    bool _Build();
+    bool _ExtractQuads(/*ImDrawList* */ void* imgui_draw_list);
+
+public:
+    OpenGL_Quad_Renderer();
+    ~OpenGL_Quad_Renderer();
+
+    /// <summary>
+    ///   Renders the draw data like ImGui_ImplOpenGL3_RenderDrawData. The draw lists are modified, render them only once.
+    /// </summary>
+    void RenderDrawData(/*ImDrawData* */ void* imgui_draw_data);
+
+    /// <summary>
+    ///   Sends every draw list to the ImGui backend unchanged when disabled. Enabled by default.
+    /// </summary>
+    void SetEnabled(bool enabled);
+
+    /// <summary>
+    ///   Quads drawn as instances by the last RenderDrawData.
+    /// </summary>
+    uint32_t GetQuadCount() const;
+
+    /// <summary>
+    ///   Size of the quad instances uploaded by the last RenderDrawData.
+    /// </summary>
+    size_t GetQuadBytes() const;
+
+    /// <summary>
+    ///   Draws a run of quads with the clip rectangle and texture of the callback command. Called from the draw list callback.
+    /// </summary>
+    void DrawQuads(uint32_t first_quad, uint32_t quad_count, /*ImDrawCmd* */ const void* imgui_draw_cmd);
+
+    /// <summary>
+    ///   Deletes the GL objects, the GL context must be current.
+    /// </summary>
+    void Destroy();
+};
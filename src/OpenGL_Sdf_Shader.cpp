@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <glad/gl.h>
+
+#include "OpenGL_Sdf_Shader.h"
+#include "internal_includes.h"
+
+#include <imgui.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static const char SdfVertexShader[] =
+    "uniform mat4 ProjMtx;\n"
+    "IN vec2 Position;\n"
+    "IN vec2 UV;\n"
+    "IN vec4 Color;\n"
+    "OUT vec2 Frag_UV;\n"
+    "OUT vec4 Frag_Color;\n"
+    "void main()\n"
+    "{\n"
+    "    Frag_UV = UV;\n"
+    "    Frag_Color = Color;\n"
+    "    gl_Position = ProjMtx * vec4(Position.xy, 0, 1);\n"
+    "}\n";
+
+static const char SdfFragmentShader[] =
+    "uniform sampler2D Texture;\n"
+    "IN vec2 Frag_UV;\n"
+    "IN vec4 Frag_Color;\n"
+    "void main()\n"
+    "{\n"
+    // The alpha channel holds the distance to the glyph edge, 0.5 on the edge.
+    "    float distance = TEXTURE(Texture, Frag_UV.st).a;\n"
+    // Antialias over one screen pixel, whatever the text scale is.
+    "    float width = max(fwidth(distance) * 0.5, 0.0001);\n"
+    "    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);\n"
+    "    FRAG_COLOR = vec4(Frag_Color.rgb, Frag_Color.a * alpha);\n"
+    "}\n";
+
+static void SdfDrawCallback(const ImDrawList*, const ImDrawCmd* cmd)
+{
+    reinterpret_cast<OpenGL_Sdf_Shader*>(cmd->UserCallbackData)->Use();
+}
+
+static GLuint CompileShader(GLenum type, std::string const& header, const char* source)
+{
+    const GLchar* sources[] = { header.c_str(), source };
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 2, sources, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[512] = {};
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        SPDLOG_WARN("Failed to compile the SDF {} shader: {}", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+OpenGL_Sdf_Shader::OpenGL_Sdf_Shader():
+    _Program(0),
+    _ImGuiProgram(0),
+    _ProjectionLocation(-1),
+    _TextureLocation(-1),
+    _BuildFailed(false)
+{}
+
+bool OpenGL_Sdf_Shader::_Build(uint32_t imgui_program)
+{
+    // Reuse the ImGui shaders #version line, the backend picked it for this context.
+    std::string version = "#version 130";
+    GLuint imgui_shaders[2];
+    GLsizei imgui_shader_count = 0;
+    glGetAttachedShaders(imgui_program, 2, &imgui_shader_count, imgui_shaders);
+    if (imgui_shader_count > 0)
+    {
+        GLint source_length = 0;
+        glGetShaderiv(imgui_shaders[0], GL_SHADER_SOURCE_LENGTH, &source_length);
+
+        std::vector<GLchar> source(static_cast<size_t>(source_length) + 1, '\0');
+        glGetShaderSource(imgui_shaders[0], static_cast<GLsizei>(source.size()), nullptr, source.data());
+        if (strncmp(source.data(), "#version", 8) == 0)
+            version.assign(source.data(), strcspn(source.data(), "\r\n"));
+    }
+
+    const int version_number = atoi(version.c_str() + 8);
+    const bool is_es = version.find(" es") != std::string::npos || version_number == 100;
+
+    std::string vertex_header = version + "\n";
+    std::string fragment_header = version + "\n";
+    if (version_number >= 130)
+    {
+        vertex_header += "#define IN in\n#define OUT out\n";
+        fragment_header += "#define IN in\n#define TEXTURE texture\n#define FRAG_COLOR Out_Color\n";
+        if (is_es)
+            fragment_header += "precision mediump float;\n";
+
+        fragment_header += "out vec4 Out_Color;\n";
+    }
+    else
+    {
+        vertex_header += "#define IN attribute\n#define OUT varying\n";
+        if (is_es)
+            fragment_header += "#extension GL_OES_standard_derivatives : enable\nprecision mediump float;\n";
+
+        fragment_header += "#define IN varying\n#define TEXTURE texture2D\n#define FRAG_COLOR gl_FragColor\n";
+    }
+
+    GLuint vertex_shader = CompileShader(GL_VERTEX_SHADER, vertex_header, SdfVertexShader);
+    GLuint fragment_shader = CompileShader(GL_FRAGMENT_SHADER, fragment_header, SdfFragmentShader);
+    if (vertex_shader == 0 || fragment_shader == 0)
+    {
+        if (vertex_shader != 0)
+            glDeleteShader(vertex_shader);
+        if (fragment_shader != 0)
+            glDeleteShader(fragment_shader);
+
+        return false;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertex_shader);
+    glAttachShader(program, fragment_shader);
+
+    // The vertex arrays are set up for the ImGui program, use its attribute locations.
+    static const char* attributes[] = { "Position", "UV", "Color" };
+    for (const char* attribute : attributes)
+    {
+        GLint location = glGetAttribLocation(imgui_program, attribute);
+        if (location >= 0)
+            glBindAttribLocation(program, static_cast<GLuint>(location), attribute);
+    }
+
+    glLinkProgram(program);
+    glDetachShader(program, vertex_shader);
+    glDetachShader(program, fragment_shader);
+    glDeleteShader(vertex_shader);
+    glDeleteShader(fragment_shader);
+
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE)
+    {
+        GLchar log[512] = {};
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        SPDLOG_WARN("Failed to link the SDF program: {}", log);
+        glDeleteProgram(program);
+        return false;
+    }
+
+    _Program = program;
+    _ImGuiProgram = imgui_program;
+    _ProjectionLocation = glGetUniformLocation(program, "ProjMtx");
+    _TextureLocation = glGetUniformLocation(program, "Texture");
+    return true;
+}
+
+bool OpenGL_Sdf_Shader::Begin(void* imgui_draw_list)
+{
+    ImDrawList* draw_list = reinterpret_cast<ImDrawList*>(imgui_draw_list);
+    if (draw_list == nullptr || _BuildFailed)
+        return false;
+
+    draw_list->AddCallback(&SdfDrawCallback, this);
+    return true;
+}
+
+void OpenGL_Sdf_Shader::End(void* imgui_draw_list)
+{
+    ImDrawList* draw_list = reinterpret_cast<ImDrawList*>(imgui_draw_list);
+    if (draw_list != nullptr)
+        draw_list->AddCallback(ImDrawCallback_ResetRenderState, nullptr);
+}
+
+void OpenGL_Sdf_Shader::Use()
+{
+    GLint imgui_program = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &imgui_program);
+    if (imgui_program == 0 || _BuildFailed)
+        return;
+
+    // The ImGui backend was restarted, its attribute locations may have changed.
+    if (_Program != 0 && _ImGuiProgram != static_cast<uint32_t>(imgui_program))
+        Destroy();
+
+    if (_Program == 0 && !_Build(static_cast<uint32_t>(imgui_program)))
+    {// Keep the ImGui shader, the glyphs are drawn blurry but readable.
+        _BuildFailed = true;
+        return;
+    }
+
+    GLfloat projection[16];
+    glGetUniformfv(static_cast<GLuint>(imgui_program), glGetUniformLocation(static_cast<GLuint>(imgui_program), "ProjMtx"), projection);
+
+    glUseProgram(_Program);
+    glUniform1i(_TextureLocation, 0);
+    glUniformMatrix4fv(_ProjectionLocation, 1, GL_FALSE, projection);
+}
+
+void OpenGL_Sdf_Shader::Destroy()
+{
+    if (_Program != 0)
+        glDeleteProgram(_Program);
+
+    _Program = 0;
+    _ImGuiProgram = 0;
+    _ProjectionLocation = -1;
+    _TextureLocation = -1;
+    _BuildFailed = false;
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+// Draws signed distance field glyphs inside the render state of the ImGui OpenGL3 backend.
+// The program is built the first time a draw list uses it, with the GLSL version and vertex layout of the ImGui program.
+class OpenGL_Sdf_Shader
+{
+    uint32_t _Program;
+    // The ImGui program _Program was built against.
+    uint32_t _ImGuiProgram;
+    int32_t _ProjectionLocation;
+    int32_t _TextureLocation;
+    bool _BuildFailed;
+
+    bool _Build(uint32_t imgui_program);
+
+public:
+    OpenGL_Sdf_Shader();
+
+    /// <summary>
+    ///   Adds a callback switching the next draw commands to the distance field program.
+    /// </summary>
+    bool Begin(/*ImDrawList* */ void* imgui_draw_list);
+
+    /// <summary>
+    ///   Adds a callback resetting the ImGui render state.
+    /// </summary>
+    void End(/*ImDrawList* */ void* imgui_draw_list);
+
+    /// <summary>
+    ///   Binds the distance field program, with the ImGui program projection. Called from the draw list callback.
+    /// </summary>
+    void Use();
+
+    /// <summary>
+    ///   Deletes the program, the GL context must be current.
+    /// </summary>
+    void Destroy();
+};
@@ -0,0 +1,432 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Overlay_Host.h>
+#include <ingame_overlay/Job_Pool.h>
+
+#include "internal_includes.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <condition_variable>
+#include <cstring>
+
+namespace ingame_overlay {
+
+struct Overlay_Host::Client_t
+{
+    OverlayClientHandle Handle;
+    std::string Name;
+    int32_t Layer;
+    bool OwnContext;
+    std::function<void()> Proc;
+
+    // Own context clients only.
+    ImGuiContext* Context;
+    // Valid until the next frame of Context.
+    ImDrawData* DrawData;
+    // io.WantCaptureMouse of the last frame, used to pick the mouse owner.
+    bool WantsMouse;
+    // Inputs last sent to Context, only the changes are queued as ImGui input events.
+    ImVec2 MousePos;
+    bool MouseDown[IM_ARRAYSIZE(ImGuiIO::MouseDown)];
+    bool KeysDown[IM_ARRAYSIZE(ImGuiIO::KeysData)];
+    bool KeyCtrl, KeyShift, KeyAlt, KeySuper;
+};
+
+// The host inputs of the frame, read before switching to the clients contexts.
+struct Overlay_Host::Inputs_t
+{
+    ImVec2 DisplaySize;
+    ImVec2 FramebufferScale;
+    float DeltaTime;
+    ImGuiBackendFlags BackendFlags;
+    ImVec2 MousePos;
+    bool MouseDown[IM_ARRAYSIZE(ImGuiIO::MouseDown)];
+    float MouseWheel, MouseWheelH;
+    bool KeysDown[IM_ARRAYSIZE(ImGuiIO::KeysData)];
+    bool KeyCtrl, KeyShift, KeyAlt, KeySuper;
+    std::vector<ImWchar> Characters;
+};
+
+// Appends the commands of draw_data to destination, keeping their texture and clip rect.
+// Each command only copies the vertices its indices reference, so the 16 bits indices never overflow.
+static void AppendDrawData(ImDrawList* destination, ImDrawData const* draw_data)
+{
+    if (draw_data == nullptr || !draw_data->Valid)
+        return;
+
+    for (int list_index = 0; list_index < draw_data->CmdListsCount; ++list_index)
+    {
+        const ImDrawList* source = draw_data->CmdLists[list_index];
+        for (ImDrawCmd const& cmd : source->CmdBuffer)
+        {
+            if (cmd.UserCallback != nullptr)
+            {
+                destination->AddCallback(cmd.UserCallback, cmd.UserCallbackData);
+                continue;
+            }
+
+            if (cmd.ElemCount == 0)
+                continue;
+
+            const ImDrawIdx* indices = source->IdxBuffer.Data + cmd.IdxOffset;
+            ImDrawIdx min_index = indices[0];
+            ImDrawIdx max_index = indices[0];
+            for (unsigned int i = 1; i < cmd.ElemCount; ++i)
+            {
+                min_index = std::min(min_index, indices[i]);
+                max_index = std::max(max_index, indices[i]);
+            }
+
+            const int vertex_count = static_cast<int>(max_index - min_index) + 1;
+
+            destination->PushClipRect(ImVec2(cmd.ClipRect.x, cmd.ClipRect.y), ImVec2(cmd.ClipRect.z, cmd.ClipRect.w));
+            destination->PushTextureID(cmd.TextureId);
+
+            destination->PrimReserve(static_cast<int>(cmd.ElemCount), vertex_count);
+            memcpy(destination->_VtxWritePtr, source->VtxBuffer.Data + cmd.VtxOffset + min_index, vertex_count * sizeof(ImDrawVert));
+            for (unsigned int i = 0; i < cmd.ElemCount; ++i)
+                destination->_IdxWritePtr[i] = static_cast<ImDrawIdx>(destination->_VtxCurrentIdx + indices[i] - min_index);
+
+            destination->_VtxWritePtr += vertex_count;
+            destination->_IdxWritePtr += cmd.ElemCount;
+            destination->_VtxCurrentIdx += vertex_count;
+
+            destination->PopTextureID();
+            destination->PopClipRect();
+        }
+    }
+}
+
+Overlay_Host::Overlay_Host(Renderer_Hook* renderer, OverlayHostOptions const& options):
+    _Renderer(renderer),
+    _BuildPool(options.BuildPool),
+    _NextHandle(1),
+    _MouseOwner(nullptr),
+    _KeyboardOwner(nullptr),
+    _MouseWasDown(false)
+{
+    _Renderer->OverlayProc = [this]()
+    {
+        _OverlayProc();
+    };
+}
+
+Overlay_Host::~Overlay_Host()
+{
+    _Renderer->OverlayProc = nullptr;
+
+    for (auto& client : _Clients)
+    {
+        if (client->Context != nullptr)
+            ImGui::DestroyContext(client->Context);
+    }
+}
+
+OverlayClientHandle Overlay_Host::AddClient(OverlayClientOptions options)
+{
+    if (!options.Proc)
+        return 0;
+
+    std::unique_ptr<Client_t> client(new Client_t);
+    client->Handle = _NextHandle.fetch_add(1);
+    client->Name = std::move(options.Name);
+    client->Layer = options.Layer;
+    client->OwnContext = options.OwnContext;
+    client->Proc = std::move(options.Proc);
+    client->Context = nullptr;
+    client->DrawData = nullptr;
+    client->WantsMouse = false;
+    client->MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+    memset(client->MouseDown, 0, sizeof(client->MouseDown));
+    memset(client->KeysDown, 0, sizeof(client->KeysDown));
+    client->KeyCtrl = client->KeyShift = client->KeyAlt = client->KeySuper = false;
+
+    const OverlayClientHandle handle = client->Handle;
+
+    std::lock_guard<std::mutex> lk(_ChangesMutex);
+    _AddedClients.emplace_back(std::move(client));
+    return handle;
+}
+
+void Overlay_Host::RemoveClient(OverlayClientHandle client)
+{
+    std::lock_guard<std::mutex> lk(_ChangesMutex);
+    _RemovedClients.emplace_back(client);
+}
+
+void Overlay_Host::_ApplyChanges()
+{
+    std::vector<std::unique_ptr<Client_t>> added_clients;
+    std::vector<OverlayClientHandle> removed_clients;
+    {
+        std::lock_guard<std::mutex> lk(_ChangesMutex);
+        added_clients.swap(_AddedClients);
+        removed_clients.swap(_RemovedClients);
+    }
+
+    if (added_clients.empty() && removed_clients.empty())
+        return;
+
+    ImGuiContext* host_context = ImGui::GetCurrentContext();
+    for (auto& client : added_clients)
+    {
+        if (client->OwnContext)
+        {
+            client->Context = ImGui::CreateContext(ImGui::GetIO().Fonts);
+            ImGui::SetCurrentContext(client->Context);
+
+            ImGuiIO& io = ImGui::GetIO();
+            // The host context owns the settings and the cursor.
+            io.IniFilename = nullptr;
+            io.LogFilename = nullptr;
+            io.ConfigFlags |= ImGuiConfigFlags_NoMouseCursorChange;
+
+            ImGui::SetCurrentContext(host_context);
+        }
+
+        SPDLOG_INFO("Overlay client {} added on layer {}.", client->Name, client->Layer);
+        _Clients.emplace_back(std::move(client));
+    }
+
+    for (OverlayClientHandle handle : removed_clients)
+    {
+        auto it = std::find_if(_Clients.begin(), _Clients.end(), [handle](std::unique_ptr<Client_t> const& client) { return client->Handle == handle; });
+        if (it == _Clients.end())
+            continue;
+
+        Client_t* client = it->get();
+        if (_MouseOwner == client)
+            _MouseOwner = nullptr;
+        if (_KeyboardOwner == client)
+            _KeyboardOwner = nullptr;
+
+        if (client->Context != nullptr)
+        {
+            ImGui::DestroyContext(client->Context);
+            ImGui::SetCurrentContext(host_context);
+        }
+
+        SPDLOG_INFO("Overlay client {} removed.", client->Name);
+        _Clients.erase(it);
+    }
+
+    std::stable_sort(_Clients.begin(), _Clients.end(), [](std::unique_ptr<Client_t> const& a, std::unique_ptr<Client_t> const& b)
+    {
+        return a->Layer < b->Layer;
+    });
+}
+
+void Overlay_Host::_PickInputOwners(bool host_wants_mouse, bool mouse_down)
+{
+    // A drag stays with the client it started on.
+    if (mouse_down && _MouseWasDown)
+        return;
+
+    _MouseOwner = nullptr;
+    // Top to bottom: the clients above the host windows, the host windows, then the clients under them.
+    for (auto it = _Clients.rbegin(); it != _Clients.rend(); ++it)
+    {
+        Client_t* client = it->get();
+        if (!client->OwnContext)
+            continue;
+
+        if (client->Layer < 0 && host_wants_mouse)
+            break;
+
+        if (client->WantsMouse)
+        {
+            _MouseOwner = client;
+            break;
+        }
+    }
+
+    if (mouse_down)
+        _KeyboardOwner = _MouseOwner;
+}
+
+void Overlay_Host::_BuildClientFrame(Client_t& client, Inputs_t const& inputs)
+{
+    ImGui::SetCurrentContext(client.Context);
+    ImGuiIO& io = ImGui::GetIO();
+
+    io.DisplaySize = inputs.DisplaySize;
+    io.DisplayFramebufferScale = inputs.FramebufferScale;
+    io.DeltaTime = inputs.DeltaTime;
+    io.BackendFlags = inputs.BackendFlags;
+
+    // ImGui builds its io state from the input events in NewFrame, only the changes are sent like a platform backend would.
+    // Every client sees the mouse, so hovering is known for the next owner pick, only the owner gets the buttons.
+    if (inputs.MousePos.x != client.MousePos.x || inputs.MousePos.y != client.MousePos.y)
+    {
+        client.MousePos = inputs.MousePos;
+        io.AddMousePosEvent(inputs.MousePos.x, inputs.MousePos.y);
+    }
+
+    const bool mouse_owner = &client == _MouseOwner;
+    for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); ++i)
+    {
+        const bool down = mouse_owner && inputs.MouseDown[i];
+        if (down != client.MouseDown[i])
+        {
+            client.MouseDown[i] = down;
+            io.AddMouseButtonEvent(i, down);
+        }
+    }
+
+    if (mouse_owner && (inputs.MouseWheel != 0.0f || inputs.MouseWheelH != 0.0f))
+        io.AddMouseWheelEvent(inputs.MouseWheelH, inputs.MouseWheel);
+
+    const bool keyboard_owner = &client == _KeyboardOwner;
+    // The legacy native keys before ImGuiKey_NamedKey_BEGIN aren't valid AddKeyEvent keys.
+    for (int named_key = ImGuiKey_NamedKey_BEGIN; named_key < ImGuiKey_NamedKey_END; ++named_key)
+    {
+        const ImGuiKey key = static_cast<ImGuiKey>(named_key);
+        const int i = named_key - ImGuiKey_KeysData_OFFSET;
+        // Mouse keys follow the mouse button events, the modifiers are sent below.
+        if ((key >= ImGuiKey_MouseLeft && key <= ImGuiKey_MouseWheelY) || (key >= ImGuiKey_ReservedForModCtrl && key <= ImGuiKey_ReservedForModSuper))
+            continue;
+
+        const bool down = keyboard_owner && inputs.KeysDown[i];
+        if (down != client.KeysDown[i])
+        {
+            client.KeysDown[i] = down;
+            io.AddKeyEvent(key, down);
+        }
+    }
+
+    struct
+    {
+        bool Down;
+        bool& Sent;
+        ImGuiKey Key;
+    } const modifiers[] = {
+        { keyboard_owner && inputs.KeyCtrl , client.KeyCtrl , ImGuiMod_Ctrl  },
+        { keyboard_owner && inputs.KeyShift, client.KeyShift, ImGuiMod_Shift },
+        { keyboard_owner && inputs.KeyAlt  , client.KeyAlt  , ImGuiMod_Alt   },
+        { keyboard_owner && inputs.KeySuper, client.KeySuper, ImGuiMod_Super },
+    };
+    for (auto const& modifier : modifiers)
+    {
+        if (modifier.Down != modifier.Sent)
+        {
+            modifier.Sent = modifier.Down;
+            io.AddKeyEvent(modifier.Key, modifier.Down);
+        }
+    }
+
+    if (keyboard_owner)
+    {
+        for (ImWchar character : inputs.Characters)
+            io.AddInputCharacterUTF16(character);
+    }
+
+    ImGui::NewFrame();
+    client.Proc();
+    ImGui::Render();
+
+    client.DrawData = ImGui::GetDrawData();
+    client.WantsMouse = io.WantCaptureMouse;
+}
+
+void Overlay_Host::_OverlayProc()
+{
+    _ApplyChanges();
+
+    std::vector<Client_t*> own_context_clients;
+    for (auto& client : _Clients)
+    {
+        if (client->OwnContext)
+            own_context_clients.emplace_back(client.get());
+        else
+            client->Proc();
+    }
+
+    if (own_context_clients.empty())
+        return;
+
+    ImGuiContext* host_context = ImGui::GetCurrentContext();
+    ImGuiIO& host_io = ImGui::GetIO();
+
+    Inputs_t inputs;
+    inputs.DisplaySize = host_io.DisplaySize;
+    inputs.FramebufferScale = host_io.DisplayFramebufferScale;
+    inputs.DeltaTime = host_io.DeltaTime;
+    inputs.BackendFlags = host_io.BackendFlags;
+    inputs.MousePos = host_io.MousePos;
+    bool mouse_down = false;
+    for (int i = 0; i < IM_ARRAYSIZE(host_io.MouseDown); ++i)
+    {
+        inputs.MouseDown[i] = host_io.MouseDown[i];
+        mouse_down |= host_io.MouseDown[i];
+    }
+    inputs.MouseWheel = host_io.MouseWheel;
+    inputs.MouseWheelH = host_io.MouseWheelH;
+    for (int i = 0; i < IM_ARRAYSIZE(host_io.KeysData); ++i)
+        inputs.KeysDown[i] = host_io.KeysData[i].Down;
+    inputs.KeyCtrl = host_io.KeyCtrl;
+    inputs.KeyShift = host_io.KeyShift;
+    inputs.KeyAlt = host_io.KeyAlt;
+    inputs.KeySuper = host_io.KeySuper;
+    inputs.Characters.assign(host_io.InputQueueCharacters.begin(), host_io.InputQueueCharacters.end());
+
+    _PickInputOwners(host_io.WantCaptureMouse, mouse_down);
+    _MouseWasDown = mouse_down;
+
+    if (_BuildPool != nullptr && own_context_clients.size() > 1)
+    {// The render thread builds the first client while the pool builds the others.
+        std::mutex done_mutex;
+        std::condition_variable done_cv;
+        size_t pending = own_context_clients.size() - 1;
+
+        for (size_t i = 1; i < own_context_clients.size(); ++i)
+        {
+            Client_t* client = own_context_clients[i];
+            _BuildPool->Submit([this, client, &inputs, &done_mutex, &done_cv, &pending]()
+            {
+                _BuildClientFrame(*client, inputs);
+                ImGui::SetCurrentContext(nullptr);
+
+                std::lock_guard<std::mutex> lk(done_mutex);
+                if (--pending == 0)
+                    done_cv.notify_one();
+            }, JobOptions{ JobPriority::High, -1 });
+        }
+
+        _BuildClientFrame(*own_context_clients[0], inputs);
+
+        std::unique_lock<std::mutex> lk(done_mutex);
+        done_cv.wait(lk, [&pending]() { return pending == 0; });
+    }
+    else
+    {
+        for (Client_t* client : own_context_clients)
+            _BuildClientFrame(*client, inputs);
+    }
+
+    ImGui::SetCurrentContext(host_context);
+
+    for (Client_t* client : own_context_clients)
+        AppendDrawData(client->Layer < 0 ? ImGui::GetBackgroundDrawList() : ImGui::GetForegroundDrawList(), client->DrawData);
+}
+
+}
@@ -0,0 +1,588 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Pixel_Convert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || ((defined(__i386__) || defined(_M_IX86)) && (defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)))
+    #define PIXEL_CONVERT_SSE2
+    #include <immintrin.h>
+    #if defined(_MSC_VER) && !defined(__clang__)
+        #include <intrin.h>
+        #define PIXEL_CONVERT_AVX2_FUNCTION
+    #else
+        #define PIXEL_CONVERT_AVX2_FUNCTION __attribute__((target("avx2")))
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define PIXEL_CONVERT_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace ingame_overlay {
+namespace Pixel_Convert {
+
+struct Kernels_t
+{
+    // BGRA to RGBA
+    void (*SwapRedBlue)(const uint8_t* src, uint8_t* dst, size_t count);
+    // RGB to RGBA
+    void (*ExpandRgb)(const uint8_t* src, uint8_t* dst, size_t count);
+    // BGR to RGBA
+    void (*ExpandBgr)(const uint8_t* src, uint8_t* dst, size_t count);
+    // Premultiplied RGBA to straight RGBA, in place.
+    void (*Unpremultiply)(uint8_t* pixels, size_t count);
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Scalar kernels, also used for the rows tails of the SIMD ones.
+static void ScalarSwapRedBlue(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, src += 4, dst += 4)
+    {
+        dst[0] = src[2];
+        dst[1] = src[1];
+        dst[2] = src[0];
+        dst[3] = src[3];
+    }
+}
+
+template<bool SwapRedBlue>
+static void ScalarExpand(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, src += 3, dst += 4)
+    {
+        dst[0] = src[SwapRedBlue ? 2 : 0];
+        dst[1] = src[1];
+        dst[2] = src[SwapRedBlue ? 0 : 2];
+        dst[3] = 0xff;
+    }
+}
+
+static void ScalarUnpremultiply(uint8_t* pixels, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, pixels += 4)
+    {
+        const uint8_t alpha = pixels[3];
+        if (alpha == 0)
+        {
+            pixels[0] = pixels[1] = pixels[2] = 0;
+            continue;
+        }
+
+        // Same float operations as the SIMD kernels, so every path rounds the same way.
+        const float scale = 255.0f / static_cast<float>(alpha);
+        for (int c = 0; c < 3; ++c)
+        {
+            float value = static_cast<float>(pixels[c]) * scale;
+            if (value > 255.0f)
+                value = 255.0f;
+
+            pixels[c] = static_cast<uint8_t>(std::nearbyint(value));
+        }
+    }
+}
+
+static const Kernels_t ScalarKernels = {
+    &ScalarSwapRedBlue,
+    &ScalarExpand<false>,
+    &ScalarExpand<true>,
+    &ScalarUnpremultiply,
+};
+
+#if defined(PIXEL_CONVERT_SSE2)
+//////////////////////////////////////////////////////////////////////////////
+// SSE2 kernels, 4 pixels at a time.
+static inline __m128i Sse2SwapRedBlue(__m128i pixels)
+{
+    const __m128i green_alpha = _mm_and_si128(pixels, _mm_set1_epi32(static_cast<int>(0xff00ff00)));
+    const __m128i red_blue = _mm_and_si128(pixels, _mm_set1_epi32(0x00ff00ff));
+    return _mm_or_si128(green_alpha, _mm_or_si128(_mm_srli_epi32(red_blue, 16), _mm_slli_epi32(red_blue, 16)));
+}
+
+static void Sse2SwapRedBlueRow(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), Sse2SwapRedBlue(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4))));
+
+    ScalarSwapRedBlue(src + i * 4, dst + i * 4, count - i);
+}
+
+// SSE2 has no byte shuffle: load each 3 bytes pixel as a 32 bits word, then mask in the alpha.
+template<bool SwapRedBlue>
+static void Sse2Expand(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m128i rgb_mask = _mm_set1_epi32(0x00ffffff);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+    size_t i = 0;
+    // The 32 bits load of the 4th pixel reads one byte of the 5th one.
+    for (; i + 5 <= count; i += 4)
+    {
+        int32_t words[4];
+        memcpy(&words[0], src + i * 3, 4);
+        memcpy(&words[1], src + i * 3 + 3, 4);
+        memcpy(&words[2], src + i * 3 + 6, 4);
+        memcpy(&words[3], src + i * 3 + 9, 4);
+
+        __m128i pixels = _mm_or_si128(_mm_and_si128(_mm_set_epi32(words[3], words[2], words[1], words[0]), rgb_mask), alpha);
+        if (SwapRedBlue)
+            pixels = Sse2SwapRedBlue(pixels);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), pixels);
+    }
+
+    ScalarExpand<SwapRedBlue>(src + i * 3, dst + i * 4, count - i);
+}
+
+static inline __m128 Sse2UnpremultiplyPixel(__m128 pixel)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 alpha_lane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+
+    const __m128 alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 value = _mm_min_ps(_mm_mul_ps(pixel, _mm_div_ps(_mm_set1_ps(255.0f), alpha)), _mm_set1_ps(255.0f));
+    // 0 alpha gives a NaN, the min above turned it into 255, clear it.
+    value = _mm_andnot_ps(_mm_cmpeq_ps(alpha, zero), value);
+    // Keep alpha as is.
+    return _mm_or_ps(_mm_and_ps(alpha_lane, pixel), _mm_andnot_ps(alpha_lane, value));
+}
+
+static void Sse2Unpremultiply(uint8_t* pixels, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i * 4));
+        const __m128i low = _mm_unpacklo_epi8(packed, zero);
+        const __m128i high = _mm_unpackhi_epi8(packed, zero);
+
+        const __m128i p0 = _mm_cvtps_epi32(Sse2UnpremultiplyPixel(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero))));
+        const __m128i p1 = _mm_cvtps_epi32(Sse2UnpremultiplyPixel(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero))));
+        const __m128i p2 = _mm_cvtps_epi32(Sse2UnpremultiplyPixel(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero))));
+        const __m128i p3 = _mm_cvtps_epi32(Sse2UnpremultiplyPixel(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero))));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixels + i * 4), _mm_packus_epi16(_mm_packs_epi32(p0, p1), _mm_packs_epi32(p2, p3)));
+    }
+
+    ScalarUnpremultiply(pixels + i * 4, count - i);
+}
+
+static const Kernels_t Sse2Kernels = {
+    &Sse2SwapRedBlueRow,
+    &Sse2Expand<false>,
+    &Sse2Expand<true>,
+    &Sse2Unpremultiply,
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// AVX2 kernels, 8 pixels at a time. Only called when the CPU supports AVX2.
+PIXEL_CONVERT_AVX2_FUNCTION static void Avx2SwapRedBlueRow(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i * 4)), shuffle));
+
+    ScalarSwapRedBlue(src + i * 4, dst + i * 4, count - i);
+}
+
+template<bool SwapRedBlue>
+PIXEL_CONVERT_AVX2_FUNCTION static void Avx2Expand(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    // Each 128 bits lane holds 4 RGB pixels in its first 12 bytes.
+    const __m256i shuffle = SwapRedBlue
+        ? _mm256_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1,
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1)
+        : _mm256_setr_epi8(
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+            0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+
+    size_t i = 0;
+    // The high lane load reads 28 bytes from the first pixel, keep it inside the row.
+    for (; i + 10 <= count; i += 8)
+    {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 3 + 12));
+        const __m256i pixels = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(pixels, shuffle), alpha));
+    }
+
+    ScalarExpand<SwapRedBlue>(src + i * 3, dst + i * 4, count - i);
+}
+
+PIXEL_CONVERT_AVX2_FUNCTION static inline __m256 Avx2UnpremultiplyPixels(__m256 pixels)
+{
+    const __m256 alpha_lane = _mm256_castsi256_ps(_mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1));
+
+    const __m256 alpha = _mm256_shuffle_ps(pixels, pixels, _MM_SHUFFLE(3, 3, 3, 3));
+    __m256 value = _mm256_min_ps(_mm256_mul_ps(pixels, _mm256_div_ps(_mm256_set1_ps(255.0f), alpha)), _mm256_set1_ps(255.0f));
+    value = _mm256_andnot_ps(_mm256_cmp_ps(alpha, _mm256_setzero_ps(), _CMP_EQ_OQ), value);
+    return _mm256_blendv_ps(value, pixels, alpha_lane);
+}
+
+PIXEL_CONVERT_AVX2_FUNCTION static void Avx2Unpremultiply(uint8_t* pixels, size_t count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        // Unpacks and packs work per 128 bits lane, the pixels end up back in order.
+        const __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i * 4));
+        const __m256i low = _mm256_unpacklo_epi8(packed, zero);
+        const __m256i high = _mm256_unpackhi_epi8(packed, zero);
+
+        const __m256i p0 = _mm256_cvtps_epi32(Avx2UnpremultiplyPixels(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(low, zero))));
+        const __m256i p1 = _mm256_cvtps_epi32(Avx2UnpremultiplyPixels(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(low, zero))));
+        const __m256i p2 = _mm256_cvtps_epi32(Avx2UnpremultiplyPixels(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(high, zero))));
+        const __m256i p3 = _mm256_cvtps_epi32(Avx2UnpremultiplyPixels(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(high, zero))));
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i * 4), _mm256_packus_epi16(_mm256_packs_epi32(p0, p1), _mm256_packs_epi32(p2, p3)));
+    }
+
+    ScalarUnpremultiply(pixels + i * 4, count - i);
+}
+
+static const Kernels_t Avx2Kernels = {
+    &Avx2SwapRedBlueRow,
+    &Avx2Expand<false>,
+    &Avx2Expand<true>,
+    &Avx2Unpremultiply,
+};
+
+static bool CpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int infos[4];
+    __cpuid(infos, 0);
+    if (infos[0] < 7)
+        return false;
+
+    __cpuid(infos, 1);
+    // OSXSAVE and AVX, then make sure the OS saves the YMM registers.
+    if ((infos[2] & (1 << 27)) == 0 || (infos[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(infos, 7, 0);
+    return (infos[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#elif defined(PIXEL_CONVERT_NEON)
+//////////////////////////////////////////////////////////////////////////////
+// NEON kernels, 16 pixels at a time.
+static void NeonSwapRedBlueRow(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        uint8x16x4_t pixels = vld4q_u8(src + i * 4);
+        const uint8x16_t red = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = red;
+        vst4q_u8(dst + i * 4, pixels);
+    }
+
+    ScalarSwapRedBlue(src + i * 4, dst + i * 4, count - i);
+}
+
+template<bool SwapRedBlue>
+static void NeonExpand(const uint8_t* src, uint8_t* dst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const uint8x16x3_t rgb = vld3q_u8(src + i * 3);
+        uint8x16x4_t pixels;
+        pixels.val[0] = rgb.val[SwapRedBlue ? 2 : 0];
+        pixels.val[1] = rgb.val[1];
+        pixels.val[2] = rgb.val[SwapRedBlue ? 0 : 2];
+        pixels.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(dst + i * 4, pixels);
+    }
+
+    ScalarExpand<SwapRedBlue>(src + i * 3, dst + i * 4, count - i);
+}
+
+static inline uint16x4_t NeonUnpremultiplyChannel(uint16x4_t channel, float32x4_t scale, uint32x4_t transparent)
+{
+    float32x4_t value = vmulq_f32(vcvtq_f32_u32(vmovl_u16(channel)), scale);
+    // 0 alpha gives a NaN, clear it before the min that would keep it.
+    value = vbslq_f32(transparent, vdupq_n_f32(0.0f), value);
+    value = vminq_f32(value, vdupq_n_f32(255.0f));
+    return vmovn_u32(vcvtnq_u32_f32(value));
+}
+
+static inline uint8x8_t NeonUnpremultiplyChannel(uint8x8_t channel, uint16x8_t alpha)
+{
+    const uint16x8_t wide = vmovl_u8(channel);
+
+    const float32x4_t alpha_low = vcvtq_f32_u32(vmovl_u16(vget_low_u16(alpha)));
+    const float32x4_t alpha_high = vcvtq_f32_u32(vmovl_u16(vget_high_u16(alpha)));
+
+    const uint16x4_t low = NeonUnpremultiplyChannel(vget_low_u16(wide), vdivq_f32(vdupq_n_f32(255.0f), alpha_low), vceqq_f32(alpha_low, vdupq_n_f32(0.0f)));
+    const uint16x4_t high = NeonUnpremultiplyChannel(vget_high_u16(wide), vdivq_f32(vdupq_n_f32(255.0f), alpha_high), vceqq_f32(alpha_high, vdupq_n_f32(0.0f)));
+
+    return vmovn_u16(vcombine_u16(low, high));
+}
+
+static void NeonUnpremultiply(uint8_t* pixels, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint8x8x4_t rgba = vld4_u8(pixels + i * 4);
+        const uint16x8_t alpha = vmovl_u8(rgba.val[3]);
+
+        rgba.val[0] = NeonUnpremultiplyChannel(rgba.val[0], alpha);
+        rgba.val[1] = NeonUnpremultiplyChannel(rgba.val[1], alpha);
+        rgba.val[2] = NeonUnpremultiplyChannel(rgba.val[2], alpha);
+        vst4_u8(pixels + i * 4, rgba);
+    }
+
+    ScalarUnpremultiply(pixels + i * 4, count - i);
+}
+
+static const Kernels_t NeonKernels = {
+    &NeonSwapRedBlueRow,
+    &NeonExpand<false>,
+    &NeonExpand<true>,
+    &NeonUnpremultiply,
+};
+#endif
+
+static const Kernels_t* FindKernels(KernelSet kernel_set)
+{
+    switch (kernel_set)
+    {
+        case KernelSet::Scalar: return &ScalarKernels;
+#if defined(PIXEL_CONVERT_SSE2)
+        case KernelSet::SSE2  : return &Sse2Kernels;
+        case KernelSet::AVX2  : return CpuHasAvx2() ? &Avx2Kernels : nullptr;
+#elif defined(PIXEL_CONVERT_NEON)
+        case KernelSet::NEON  : return &NeonKernels;
+#endif
+        default: return nullptr;
+    }
+}
+
+static const Kernels_t& GetKernels()
+{
+    static const Kernels_t& kernels = *FindKernels(GetKernelSet());
+    return kernels;
+}
+
+static void ConvertRow(const Kernels_t& kernels, const uint8_t* src, uint8_t* dst, uint32_t width, PixelFormat format, AlphaMode alpha_mode)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA: memcpy(dst, src, static_cast<size_t>(width) * 4); break;
+        case PixelFormat::BGRA: kernels.SwapRedBlue(src, dst, width); break;
+        // No alpha channel, nothing to unpremultiply.
+        case PixelFormat::RGB : kernels.ExpandRgb(src, dst, width); return;
+        case PixelFormat::BGR : kernels.ExpandBgr(src, dst, width); return;
+    }
+
+    if (alpha_mode == AlphaMode::Premultiplied)
+        kernels.Unpremultiply(dst, width);
+}
+
+const char* KernelSetName(KernelSet kernel_set)
+{
+    switch (kernel_set)
+    {
+        case KernelSet::Scalar: return "Scalar";
+        case KernelSet::SSE2  : return "SSE2";
+        case KernelSet::AVX2  : return "AVX2";
+        case KernelSet::NEON  : return "NEON";
+    }
+
+    return "Unknown";
+}
+
+bool HasKernelSet(KernelSet kernel_set)
+{
+    return FindKernels(kernel_set) != nullptr;
+}
+
+KernelSet GetKernelSet()
+{
+#if defined(PIXEL_CONVERT_SSE2)
+    static const KernelSet kernel_set = CpuHasAvx2() ? KernelSet::AVX2 : KernelSet::SSE2;
+    return kernel_set;
+#elif defined(PIXEL_CONVERT_NEON)
+    return KernelSet::NEON;
+#else
+    return KernelSet::Scalar;
+#endif
+}
+
+uint32_t BytesPerPixel(PixelFormat format)
+{
+    switch (format)
+    {
+        case PixelFormat::RGBA:
+        case PixelFormat::BGRA:
+            return 4;
+
+        case PixelFormat::RGB:
+        case PixelFormat::BGR:
+            return 3;
+    }
+
+    return 0;
+}
+
+void ConvertRow(const uint8_t* src, uint8_t* dst, uint32_t width, PixelFormat format, AlphaMode alpha_mode)
+{
+    ConvertRow(GetKernels(), src, dst, width, format, alpha_mode);
+}
+
+bool ConvertRow(const uint8_t* src, uint8_t* dst, uint32_t width, PixelFormat format, AlphaMode alpha_mode, KernelSet kernel_set)
+{
+    const Kernels_t* kernels = FindKernels(kernel_set);
+    if (kernels == nullptr)
+        return false;
+
+    ConvertRow(*kernels, src, dst, width, format, alpha_mode);
+    return true;
+}
+
+bool ToRGBA(const void* image_data, uint32_t width, uint32_t height, PixelFormat format, uint32_t stride, AlphaMode alpha_mode, std::vector<uint8_t>& rgba)
+{
+    const uint32_t bytes_per_pixel = BytesPerPixel(format);
+    if (image_data == nullptr || width == 0 || height == 0 || bytes_per_pixel == 0)
+        return false;
+
+    if (stride == 0)
+        stride = width * bytes_per_pixel;
+
+    if (stride < width * bytes_per_pixel)
+        return false;
+
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(image_data);
+    for (uint32_t row = 0; row < height; ++row)
+        ConvertRow(src + static_cast<size_t>(row) * stride, &rgba[static_cast<size_t>(row) * width * 4], width, format, alpha_mode);
+
+    return true;
+}
+
+void Downscale(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst, uint32_t dst_width, uint32_t dst_height)
+{
+    for (uint32_t dy = 0; dy < dst_height; ++dy)
+    {
+        const uint32_t y0 = static_cast<uint32_t>(static_cast<uint64_t>(dy) * src_height / dst_height);
+        const uint32_t y1 = std::max(y0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(dy + 1) * src_height / dst_height));
+
+        for (uint32_t dx = 0; dx < dst_width; ++dx, dst += 4)
+        {
+            const uint32_t x0 = static_cast<uint32_t>(static_cast<uint64_t>(dx) * src_width / dst_width);
+            const uint32_t x1 = std::max(x0 + 1, static_cast<uint32_t>(static_cast<uint64_t>(dx + 1) * src_width / dst_width));
+
+            uint64_t red = 0, green = 0, blue = 0, alpha = 0;
+            for (uint32_t y = y0; y < y1; ++y)
+            {
+                const uint8_t* pixel = src + (static_cast<size_t>(y) * src_width + x0) * 4;
+                for (uint32_t x = x0; x < x1; ++x, pixel += 4)
+                {
+                    red   += pixel[0] * pixel[3];
+                    green += pixel[1] * pixel[3];
+                    blue  += pixel[2] * pixel[3];
+                    alpha += pixel[3];
+                }
+            }
+
+            const uint64_t count = static_cast<uint64_t>(x1 - x0) * (y1 - y0);
+            if (alpha == 0)
+            {
+                dst[0] = dst[1] = dst[2] = dst[3] = 0;
+                continue;
+            }
+
+            dst[0] = static_cast<uint8_t>((red + alpha / 2) / alpha);
+            dst[1] = static_cast<uint8_t>((green + alpha / 2) / alpha);
+            dst[2] = static_cast<uint8_t>((blue + alpha / 2) / alpha);
+            dst[3] = static_cast<uint8_t>((alpha + count / 2) / count);
+        }
+    }
+}
+
+bool Fit(const uint8_t* src, uint32_t width, uint32_t height, uint32_t max_width, uint32_t max_height, std::vector<uint8_t>& dst, uint32_t& new_width, uint32_t& new_height)
+{
+    double scale = 1.0;
+    if (max_width != 0 && width > max_width)
+        scale = std::min(scale, static_cast<double>(max_width) / width);
+    if (max_height != 0 && height > max_height)
+        scale = std::min(scale, static_cast<double>(max_height) / height);
+
+    if (scale >= 1.0)
+        return false;
+
+    new_width = std::max<uint32_t>(1, static_cast<uint32_t>(width * scale));
+    new_height = std::max<uint32_t>(1, static_cast<uint32_t>(height * scale));
+
+    dst.resize(static_cast<size_t>(new_width) * new_height * 4);
+    Downscale(src, width, height, dst.data(), new_width, new_height);
+    return true;
+}
+
+uint32_t MipLevelCount(uint32_t width, uint32_t height)
+{
+    uint32_t count = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size >>= 1)
+        ++count;
+
+    return count;
+}
+
+void BuildMipChain(const uint8_t* src, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels)
+{
+    levels.resize(MipLevelCount(width, height) - 1);
+    for (auto& level : levels)
+    {
+        const uint32_t level_width = std::max<uint32_t>(1, width / 2);
+        const uint32_t level_height = std::max<uint32_t>(1, height / 2);
+
+        level.resize(static_cast<size_t>(level_width) * level_height * 4);
+        Downscale(src, width, height, level.data(), level_width, level_height);
+
+        src = level.data();
+        width = level_width;
+        height = level_height;
+    }
+}
+
+}
+}
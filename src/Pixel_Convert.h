@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ingame_overlay/Renderer_Hook.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ingame_overlay {
+
+// Converts the PixelFormat/AlphaMode combinations accepted by CreateImageResource to straight RGBA.
+// Rows go through SSE2, AVX2 or NEON kernels picked at runtime, with a scalar fallback giving the exact same bytes.
+namespace Pixel_Convert {
+
+enum class KernelSet
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+const char* KernelSetName(KernelSet kernel_set);
+
+// Whether this build and this CPU can run a kernel set.
+bool HasKernelSet(KernelSet kernel_set);
+
+// The kernel set ConvertRow uses.
+KernelSet GetKernelSet();
+
+uint32_t BytesPerPixel(PixelFormat format);
+
+// Converts width pixels from src into RGBA pixels in dst. src and dst must not overlap.
+void ConvertRow(const uint8_t* src, uint8_t* dst, uint32_t width, PixelFormat format, AlphaMode alpha_mode);
+
+// ConvertRow with a given kernel set, to compare them. Returns false if HasKernelSet is false for it.
+bool ConvertRow(const uint8_t* src, uint8_t* dst, uint32_t width, PixelFormat format, AlphaMode alpha_mode, KernelSet kernel_set);
+
+// Converts a whole image to tightly packed RGBA. A 0 stride means the rows of image_data are tightly packed.
+bool ToRGBA(const void* image_data, uint32_t width, uint32_t height, PixelFormat format, uint32_t stride, AlphaMode alpha_mode, std::vector<uint8_t>& rgba);
+
+// Shrinks a tightly packed RGBA image by averaging the source pixels covered by each destination pixel.
+// Colors are weighted by alpha, so transparent pixels don't darken the edges.
+void Downscale(const uint8_t* src, uint32_t src_width, uint32_t src_height, uint8_t* dst, uint32_t dst_width, uint32_t dst_height);
+
+// Shrinks a tightly packed RGBA image into dst so it fits max_width x max_height, keeping its aspect ratio. A 0 max means no limit.
+// Returns false and leaves dst alone when the image already fits.
+bool Fit(const uint8_t* src, uint32_t width, uint32_t height, uint32_t max_width, uint32_t max_height, std::vector<uint8_t>& dst, uint32_t& new_width, uint32_t& new_height);
+
+// The level count of a full mip chain, level 0 included.
+uint32_t MipLevelCount(uint32_t width, uint32_t height);
+
+// Builds the mip levels 1 to MipLevelCount - 1 of a tightly packed RGBA image, each one is Downscale'd from the previous one.
+void BuildMipChain(const uint8_t* src, uint32_t width, uint32_t height, std::vector<std::vector<uint8_t>>& levels);
+
+}
+
+}
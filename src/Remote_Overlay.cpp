@@ -0,0 +1,433 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ingame_overlay/Remote_Overlay.h>
+
+#include "internal_includes.h"
+#include "Pixel_Convert.h"
+#include "Shared_Memory.h"
+
+#include <imgui.h>
+
+#include <atomic>
+#include <new>
+#include <cstring>
+
+namespace ingame_overlay {
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "The channel atomics must be lock-free to work across processes.");
+
+static constexpr uint32_t ChannelMagic = 0x524F4749; // 'IGOR'
+static constexpr uint32_t ChannelVersion = 1;
+static constexpr uint32_t FrameSlotCount = 3;
+static constexpr uint32_t FrameReadTries = 3;
+
+enum class RemoteFrameFormat : uint32_t
+{
+    PremultipliedRGBA,
+};
+
+struct Frame_Slot_t
+{
+    // Odd while the overlay process writes the slot.
+    std::atomic<uint64_t> Sequence;
+    std::atomic<uint32_t> Width;
+    std::atomic<uint32_t> Height;
+    std::atomic<uint32_t> Format;
+};
+
+// Start of the shared memory, followed by the FrameSlotCount pixel buffers on their own pages.
+// Both processes may be built by different compilers, the layout only uses fixed size types and lock-free atomics.
+struct Remote_Overlay_Channel::Header_t
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t MaxWidth;
+    uint32_t MaxHeight;
+
+    // Frames published so far, the newest one is in slot (LatestFrame - 1) % FrameSlotCount.
+    alignas(64) std::atomic<uint64_t> LatestFrame;
+    alignas(64) Frame_Slot_t Slots[FrameSlotCount];
+
+    // Input ring, written by the game and read by the overlay process, on their own cache lines.
+    alignas(64) std::atomic<uint32_t> InputHead;
+    alignas(64) std::atomic<uint32_t> InputTail;
+    alignas(64) RemoteInputEvent Inputs[InputCapacity];
+};
+
+size_t Remote_Overlay_Channel::_PixelsOffset()
+{
+    return (sizeof(Header_t) + 4095) & ~static_cast<size_t>(4095);
+}
+
+static size_t SlotSize(uint32_t max_width, uint32_t max_height)
+{
+    return static_cast<size_t>(max_width) * max_height * 4;
+}
+
+Remote_Overlay_Channel::Remote_Overlay_Channel():
+    _Memory(new Shared_Memory),
+    _Header(nullptr),
+    _Pixels(nullptr),
+    _LastFrame(0)
+{}
+
+Remote_Overlay_Channel::~Remote_Overlay_Channel()
+{
+    Close();
+}
+
+bool Remote_Overlay_Channel::Create(std::string const& name, uint32_t max_width, uint32_t max_height)
+{
+    Close();
+
+    if (max_width == 0 || max_height == 0)
+        return false;
+
+    if (!_Memory->Create(name, _PixelsOffset() + SlotSize(max_width, max_height) * FrameSlotCount))
+        return false;
+
+    // The memory is zero filled, the atomics start at 0.
+    _Header = new (_Memory->Data()) Header_t;
+    _Header->MaxWidth = max_width;
+    _Header->MaxHeight = max_height;
+    _Header->Version = ChannelVersion;
+    _Header->LatestFrame.store(0, std::memory_order_relaxed);
+    for (auto& slot : _Header->Slots)
+    {
+        slot.Sequence.store(0, std::memory_order_relaxed);
+        slot.Width.store(0, std::memory_order_relaxed);
+        slot.Height.store(0, std::memory_order_relaxed);
+        slot.Format.store(static_cast<uint32_t>(RemoteFrameFormat::PremultipliedRGBA), std::memory_order_relaxed);
+    }
+    _Header->InputHead.store(0, std::memory_order_relaxed);
+    _Header->InputTail.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _Header->Magic = ChannelMagic;
+
+    _Pixels = reinterpret_cast<uint8_t*>(_Memory->Data()) + _PixelsOffset();
+    _LastFrame = 0;
+
+    SPDLOG_INFO("Remote overlay channel {} created for frames up to {}x{}.", name, max_width, max_height);
+    return true;
+}
+
+bool Remote_Overlay_Channel::Open(std::string const& name)
+{
+    Close();
+
+    if (!_Memory->Open(name))
+        return false;
+
+    Header_t* header = reinterpret_cast<Header_t*>(_Memory->Data());
+    if (_Memory->Size() < _PixelsOffset() || header->Magic != ChannelMagic || header->Version != ChannelVersion ||
+        _Memory->Size() < _PixelsOffset() + SlotSize(header->MaxWidth, header->MaxHeight) * FrameSlotCount)
+    {
+        SPDLOG_WARN("Failed to open the remote overlay channel {}: not a channel or another version.", name);
+        _Memory->Close();
+        return false;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    _Header = header;
+    _Pixels = reinterpret_cast<uint8_t*>(_Memory->Data()) + _PixelsOffset();
+    _LastFrame = 0;
+    return true;
+}
+
+void Remote_Overlay_Channel::Close()
+{
+    _Memory->Close();
+    _Header = nullptr;
+    _Pixels = nullptr;
+    _LastFrame = 0;
+}
+
+bool Remote_Overlay_Channel::IsOpen() const
+{
+    return _Header != nullptr;
+}
+
+uint32_t Remote_Overlay_Channel::MaxWidth() const
+{
+    return _Header == nullptr ? 0 : _Header->MaxWidth;
+}
+
+uint32_t Remote_Overlay_Channel::MaxHeight() const
+{
+    return _Header == nullptr ? 0 : _Header->MaxHeight;
+}
+
+bool Remote_Overlay_Channel::PublishFrame(const void* premultiplied_rgba, uint32_t width, uint32_t height, uint32_t stride)
+{
+    if (_Header == nullptr || width > _Header->MaxWidth || height > _Header->MaxHeight || (width != 0 && premultiplied_rgba == nullptr))
+        return false;
+
+    if (width == 0 || height == 0)
+        width = height = 0;
+
+    if (stride == 0)
+        stride = width * 4;
+
+    // The slot after the newest frame, the game may only be reading it if it is 2 frames late, then its read is retried.
+    const uint64_t frame = _Header->LatestFrame.load(std::memory_order_relaxed) + 1;
+    Frame_Slot_t& slot = _Header->Slots[(frame - 1) % FrameSlotCount];
+    uint8_t* pixels = _Pixels + SlotSize(_Header->MaxWidth, _Header->MaxHeight) * ((frame - 1) % FrameSlotCount);
+
+    const uint64_t sequence = slot.Sequence.load(std::memory_order_relaxed);
+    slot.Sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.Width.store(width, std::memory_order_relaxed);
+    slot.Height.store(height, std::memory_order_relaxed);
+    slot.Format.store(static_cast<uint32_t>(RemoteFrameFormat::PremultipliedRGBA), std::memory_order_relaxed);
+
+    const uint8_t* source = reinterpret_cast<const uint8_t*>(premultiplied_rgba);
+    const size_t row_size = static_cast<size_t>(width) * 4;
+    for (uint32_t y = 0; y < height; ++y)
+        memcpy(pixels + row_size * y, source + static_cast<size_t>(stride) * y, row_size);
+
+    slot.Sequence.store(sequence + 2, std::memory_order_release);
+    _Header->LatestFrame.store(frame, std::memory_order_release);
+    return true;
+}
+
+bool Remote_Overlay_Channel::PopInput(RemoteInputEvent& input_event)
+{
+    if (_Header == nullptr)
+        return false;
+
+    const uint32_t head = _Header->InputHead.load(std::memory_order_relaxed);
+    if (head == _Header->InputTail.load(std::memory_order_acquire))
+        return false;
+
+    input_event = _Header->Inputs[head % InputCapacity];
+    _Header->InputHead.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool Remote_Overlay_Channel::ReadFrame(std::vector<uint8_t>& premultiplied_rgba, uint32_t& width, uint32_t& height)
+{
+    if (_Header == nullptr)
+        return false;
+
+    for (uint32_t i = 0; i < FrameReadTries; ++i)
+    {
+        const uint64_t frame = _Header->LatestFrame.load(std::memory_order_acquire);
+        if (frame == 0 || frame == _LastFrame)
+            return false;
+
+        Frame_Slot_t& slot = _Header->Slots[(frame - 1) % FrameSlotCount];
+        const uint8_t* pixels = _Pixels + SlotSize(_Header->MaxWidth, _Header->MaxHeight) * ((frame - 1) % FrameSlotCount);
+
+        const uint64_t sequence = slot.Sequence.load(std::memory_order_acquire);
+        if ((sequence & 1) != 0)
+            continue;
+
+        const uint32_t frame_width = slot.Width.load(std::memory_order_relaxed);
+        const uint32_t frame_height = slot.Height.load(std::memory_order_relaxed);
+        if (frame_width > _Header->MaxWidth || frame_height > _Header->MaxHeight)
+            continue;
+
+        premultiplied_rgba.resize(static_cast<size_t>(frame_width) * frame_height * 4);
+        memcpy(premultiplied_rgba.data(), pixels, premultiplied_rgba.size());
+
+        // The overlay process moved to this slot again while we were copying, the copy may be torn.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.Sequence.load(std::memory_order_relaxed) != sequence)
+            continue;
+
+        _LastFrame = frame;
+        width = frame_width;
+        height = frame_height;
+        return true;
+    }
+
+    return false;
+}
+
+bool Remote_Overlay_Channel::PushInput(RemoteInputEvent const& input_event)
+{
+    if (_Header == nullptr)
+        return false;
+
+    const uint32_t tail = _Header->InputTail.load(std::memory_order_relaxed);
+    if (tail - _Header->InputHead.load(std::memory_order_acquire) >= InputCapacity)
+        return false;
+
+    _Header->Inputs[tail % InputCapacity] = input_event;
+    _Header->InputTail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+Remote_Overlay_Compositor::Remote_Overlay_Compositor(Renderer_Hook* renderer):
+    _Renderer(renderer),
+    _Image(0),
+    _ImageWidth(0),
+    _ImageHeight(0),
+    _DisplayWidth(0.0f),
+    _DisplayHeight(0.0f),
+    _MouseX(0.0f),
+    _MouseY(0.0f),
+    _MouseButtons(0),
+    _KeyMods(0)
+{}
+
+Remote_Overlay_Compositor::~Remote_Overlay_Compositor()
+{
+    if (_Image != 0)
+        _Renderer->ReleaseImageResource(_Image);
+}
+
+bool Remote_Overlay_Compositor::Create(std::string const& name, uint32_t max_width, uint32_t max_height)
+{
+    return _Channel.Create(name, max_width, max_height);
+}
+
+void Remote_Overlay_Compositor::_Push(RemoteInputType type, int32_t code, int32_t value, float x, float y)
+{
+    RemoteInputEvent input_event;
+    input_event.Type = type;
+    input_event.Code = code;
+    input_event.Value = value;
+    input_event.X = x;
+    input_event.Y = y;
+    if (!_Channel.PushInput(input_event))
+        SPDLOG_DEBUG("Remote overlay input ring full, input dropped.");
+}
+
+void Remote_Overlay_Compositor::_ForwardInputs()
+{
+    ImGuiIO& io = ImGui::GetIO();
+
+    if (io.DisplaySize.x != _DisplayWidth || io.DisplaySize.y != _DisplayHeight)
+    {
+        _DisplayWidth = io.DisplaySize.x;
+        _DisplayHeight = io.DisplaySize.y;
+        _Push(RemoteInputType::DisplaySize, 0, 0, _DisplayWidth, _DisplayHeight);
+    }
+
+    if (io.MousePos.x != _MouseX || io.MousePos.y != _MouseY)
+    {
+        _MouseX = io.MousePos.x;
+        _MouseY = io.MousePos.y;
+        _Push(RemoteInputType::MousePos, 0, 0, _MouseX, _MouseY);
+    }
+
+    for (int i = 0; i < IM_ARRAYSIZE(io.MouseDown); ++i)
+    {
+        const uint32_t bit = 1u << i;
+        if (io.MouseDown[i] != ((_MouseButtons & bit) != 0))
+        {
+            _MouseButtons ^= bit;
+            _Push(RemoteInputType::MouseButton, i, io.MouseDown[i] ? 1 : 0, 0.0f, 0.0f);
+        }
+    }
+
+    if (io.MouseWheel != 0.0f || io.MouseWheelH != 0.0f)
+        _Push(RemoteInputType::MouseWheel, 0, 0, io.MouseWheelH, io.MouseWheel);
+
+    // Same keys as Overlay_Host sends its clients: the overlay process passes them to io.AddKeyEvent.
+    _KeysDown.resize(IM_ARRAYSIZE(io.KeysData), false);
+    for (int named_key = ImGuiKey_NamedKey_BEGIN; named_key < ImGuiKey_NamedKey_END; ++named_key)
+    {
+        const ImGuiKey key = static_cast<ImGuiKey>(named_key);
+        const int i = named_key - ImGuiKey_KeysData_OFFSET;
+        // Mouse keys follow the mouse button events, the modifiers are sent below.
+        if ((key >= ImGuiKey_MouseLeft && key <= ImGuiKey_MouseWheelY) || (key >= ImGuiKey_ReservedForModCtrl && key <= ImGuiKey_ReservedForModSuper))
+            continue;
+
+        if (io.KeysData[i].Down != _KeysDown[i])
+        {
+            _KeysDown[i] = io.KeysData[i].Down;
+            _Push(RemoteInputType::Key, key, io.KeysData[i].Down ? 1 : 0, 0.0f, 0.0f);
+        }
+    }
+
+    struct
+    {
+        bool Down;
+        ImGuiKey Key;
+    } const modifiers[] = {
+        { io.KeyCtrl , ImGuiMod_Ctrl  },
+        { io.KeyShift, ImGuiMod_Shift },
+        { io.KeyAlt  , ImGuiMod_Alt   },
+        { io.KeySuper, ImGuiMod_Super },
+    };
+    for (auto const& modifier : modifiers)
+    {
+        const uint32_t bit = static_cast<uint32_t>(modifier.Key);
+        if (modifier.Down != ((_KeyMods & bit) != 0))
+        {
+            _KeyMods ^= bit;
+            _Push(RemoteInputType::Key, modifier.Key, modifier.Down ? 1 : 0, 0.0f, 0.0f);
+        }
+    }
+
+    for (ImWchar character : io.InputQueueCharacters)
+        _Push(RemoteInputType::Character, character, 0, 0.0f, 0.0f);
+}
+
+void Remote_Overlay_Compositor::Update()
+{
+    if (!_Channel.IsOpen())
+        return;
+
+    _ForwardInputs();
+
+    uint32_t width, height;
+    if (_Channel.ReadFrame(_Frame, width, height))
+    {
+        if (width != _ImageWidth || height != _ImageHeight)
+        {
+            if (_Image != 0)
+                _Renderer->ReleaseImageResource(_Image);
+
+            _Image = 0;
+            _ImageWidth = 0;
+            _ImageHeight = 0;
+            if (width != 0)
+            {
+                _Image = _Renderer->CreateImageResource(_Frame.data(), width, height, PixelFormat::RGBA, 0, AlphaMode::Premultiplied);
+                if (_Image != 0)
+                {
+                    _ImageWidth = width;
+                    _ImageHeight = height;
+                }
+            }
+        }
+        else if (_Image != 0)
+        {// The ImGui shader blends straight alpha.
+            _StraightFrame.resize(_Frame.size());
+            for (uint32_t y = 0; y < height; ++y)
+                Pixel_Convert::ConvertRow(_Frame.data() + static_cast<size_t>(width) * 4 * y, _StraightFrame.data() + static_cast<size_t>(width) * 4 * y, width, PixelFormat::RGBA, AlphaMode::Premultiplied);
+
+            _Renderer->UpdateImageResource(_Image, 0, 0, width, height, _StraightFrame.data());
+        }
+    }
+
+    if (_Image == 0)
+        return;
+
+    void* texture = _Renderer->GetImageResourceTexture(_Image);
+    if (texture != nullptr)
+        ImGui::GetBackgroundDrawList()->AddImage(texture, ImVec2(0.0f, 0.0f), ImVec2(static_cast<float>(_ImageWidth), static_cast<float>(_ImageHeight)));
+}
+
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Renderer_Detection_Service.h"
+#include "internal_includes.h"
+
+constexpr std::chrono::milliseconds Renderer_Detection_Service::ProbeInterval;
+
+Renderer_Detection_Service::Renderer_Detection_Service():
+    _Busy(false),
+    _Cancelled(false),
+    _Quit(false)
+{}
+
+Renderer_Detection_Service::~Renderer_Detection_Service()
+{
+    _Shutdown();
+}
+
+void Renderer_Detection_Service::_Shutdown()
+{
+    Stop();
+
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        _Quit = true;
+    }
+    _WakeCv.notify_all();
+
+    if (_Thread.joinable())
+        _Thread.join();
+}
+
+void Renderer_Detection_Service::_Complete(std::vector<Request_t>& requests, ingame_overlay::Renderer_Hook* renderer)
+{
+    for (auto& request : requests)
+        request.Callback(renderer);
+
+    requests.clear();
+}
+
+void Renderer_Detection_Service::Detect(ingame_overlay::RendererDetectionCallback callback, std::chrono::milliseconds timeout)
+{
+    Request_t request;
+    request.Callback = std::move(callback);
+    request.Infinite = timeout.count() < 0;
+    request.Deadline = std::chrono::steady_clock::now() + (request.Infinite ? std::chrono::milliseconds{ 0 } : timeout);
+
+    {
+        std::lock_guard<std::mutex> lock(_Mutex);
+        if (!_Busy && _Requests.empty())
+        {// If we have no detections in progress, a previous StopRendererDetection doesn't apply anymore.
+            _Cancelled = false;
+        }
+
+        _Requests.emplace_back(std::move(request));
+
+        if (!_Thread.joinable())
+            _Thread = std::thread(&Renderer_Detection_Service::_Run, this);
+    }
+    _WakeCv.notify_one();
+}
+
+void Renderer_Detection_Service::Stop()
+{
+    std::unique_lock<std::mutex> lock(_Mutex);
+    if (!_Busy && _Requests.empty())
+        return;
+
+    _Cancelled = true;
+    _WakeCv.notify_all();
+    _IdleCv.wait(lock, [this]() { return !_Busy && _Requests.empty(); });
+}
+
+void Renderer_Detection_Service::_Run()
+{
+    std::vector<Request_t> completed;
+    std::unique_lock<std::mutex> lock(_Mutex);
+    for (;;)
+    {
+        // Parked without timeout while nobody waits for a renderer.
+        _WakeCv.wait(lock, [this]() { return _Quit || !_Requests.empty(); });
+        if (_Quit)
+            break;
+
+        _Busy = true;
+        lock.unlock();
+
+        ingame_overlay::Renderer_Hook* renderer = nullptr;
+        const bool probing = _BeginProbe(renderer);
+        if (probing)
+        {
+            SPDLOG_TRACE("Started renderer detection.");
+
+            for (;;)
+            {
+                const bool detected = _ProbeStep();
+
+                lock.lock();
+                bool stop = detected || _Cancelled;
+                if (!stop)
+                {// Requests past their deadline give up, the probe goes on for the others.
+                    const auto now = std::chrono::steady_clock::now();
+                    for (auto it = _Requests.begin(); it != _Requests.end();)
+                    {
+                        if (!it->Infinite && it->Deadline <= now)
+                        {
+                            completed.emplace_back(std::move(*it));
+                            it = _Requests.erase(it);
+                        }
+                        else
+                        {
+                            ++it;
+                        }
+                    }
+
+                    stop = _Requests.empty();
+                }
+                lock.unlock();
+
+                _Complete(completed, nullptr);
+                if (stop)
+                    break;
+
+                lock.lock();
+                _WakeCv.wait_for(lock, ProbeInterval, [this]() { return _Cancelled || _Quit; });
+                lock.unlock();
+            }
+
+            renderer = _EndProbe();
+            SPDLOG_TRACE("Renderer detection done {}.", (void*)renderer);
+        }
+
+        lock.lock();
+        if (renderer != nullptr || _Cancelled || !probing)
+        {
+            completed.swap(_Requests);
+        }
+        // Else every request of this probe timed out, the ones that came in the meantime start a new probe.
+        lock.unlock();
+
+        _Complete(completed, renderer);
+
+        lock.lock();
+        _Busy = false;
+        _IdleCv.notify_all();
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ingame_overlay/Renderer_Detector.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs every DetectRenderer request on a single service thread.
+// Concurrent requests share one probe, which runs as long as one of them still waits, each request only keeps its own deadline.
+// The platform detectors implement the probe, the virtuals are only called from the service thread.
+class Renderer_Detection_Service
+{
+    struct Request_t
+    {
+        ingame_overlay::RendererDetectionCallback Callback;
+        std::chrono::steady_clock::time_point Deadline;
+        bool Infinite;
+    };
+
+    std::thread _Thread;
+    std::mutex _Mutex;
+    std::condition_variable _WakeCv;
+    std::condition_variable _IdleCv;
+    std::vector<Request_t> _Requests;
+    // A probe is running, its requests are in _Requests.
+    bool _Busy;
+    bool _Cancelled;
+    bool _Quit;
+
+    Renderer_Detection_Service(const Renderer_Detection_Service&) = delete;
+    Renderer_Detection_Service(Renderer_Detection_Service&&) = delete;
+    Renderer_Detection_Service& operator =(const Renderer_Detection_Service&) = delete;
+    Renderer_Detection_Service& operator =(Renderer_Detection_Service&&) = delete;
+
+    void _Run();
+    // Completes the requests, outside of _Mutex, the callbacks may call Detect again.
+    static void _Complete(std::vector<Request_t>& requests, ingame_overlay::Renderer_Hook* renderer);
+
+protected:
+    // Delay between two probe steps.
+    static constexpr std::chrono::milliseconds ProbeInterval{ 100 };
+
+    Renderer_Detection_Service();
+
+    // The derived destructor must call it first, the service thread calls its virtuals.
+    void _Shutdown();
+
+    // Prepares a probe. Returns false when no probe is needed or possible, renderer is then given to the requests.
+    virtual bool _BeginProbe(ingame_overlay::Renderer_Hook*& renderer) = 0;
+    // Hooks the renderer libraries loaded since the last step, returns true once a renderer has been detected.
+    virtual bool _ProbeStep() = 0;
+    // Removes the detection hooks, returns the detected renderer or nullptr.
+    virtual ingame_overlay::Renderer_Hook* _EndProbe() = 0;
+
+public:
+    virtual ~Renderer_Detection_Service();
+
+    void Detect(ingame_overlay::RendererDetectionCallback callback, std::chrono::milliseconds timeout);
+    // Completes every pending request with the current result and waits for the probe to end.
+    void Stop();
+};
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Shared_Memory.h"
+#include "internal_includes.h"
+
+#include <atomic>
+#include <cerrno>
+
+#if !defined(_WIN32) && !defined(WIN32) && !defined(_WIN64) && !defined(WIN64)
+    #include <fcntl.h>
+    #include <signal.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+Shared_Memory::Shared_Memory():
+    _Data(nullptr),
+    _Size(0),
+    _Owner(false)
+#if defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(WIN64)
+    , _Mapping(nullptr)
+#else
+    , _Device(0)
+    , _Inode(0)
+#endif
+{}
+
+Shared_Memory::~Shared_Memory()
+{
+    Close();
+}
+
+#if defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(WIN64)
+
+bool Shared_Memory::Create(std::string const& name, size_t size)
+{
+    Close();
+
+    const uint64_t size64 = size;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64), name.c_str());
+    if (mapping == nullptr)
+    {
+        SPDLOG_WARN("Failed to create the shared memory {}: {}.", name, GetLastError());
+        return false;
+    }
+
+    if (GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        SPDLOG_WARN("Failed to create the shared memory {}: it already exists.", name);
+        CloseHandle(mapping);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (data == nullptr)
+    {
+        SPDLOG_WARN("Failed to map the shared memory {}: {}.", name, GetLastError());
+        CloseHandle(mapping);
+        return false;
+    }
+
+    // Pagefile backed mappings are zero filled.
+    _Mapping = mapping;
+    _Data = data;
+    _Size = size;
+    _Name = name;
+    _Owner = true;
+    return true;
+}
+
+bool Shared_Memory::Open(std::string const& name)
+{
+    Close();
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    if (mapping == nullptr)
+    {
+        SPDLOG_WARN("Failed to open the shared memory {}: {}.", name, GetLastError());
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (data == nullptr || VirtualQuery(data, &info, sizeof(info)) == 0)
+    {
+        SPDLOG_WARN("Failed to map the shared memory {}: {}.", name, GetLastError());
+        if (data != nullptr)
+            UnmapViewOfFile(data);
+
+        CloseHandle(mapping);
+        return false;
+    }
+
+    _Mapping = mapping;
+    _Data = data;
+    _Size = info.RegionSize;
+    _Name = name;
+    _Owner = false;
+    return true;
+}
+
+void Shared_Memory::Close()
+{
+    if (_Data != nullptr)
+        UnmapViewOfFile(_Data);
+
+    if (_Mapping != nullptr)
+        CloseHandle(_Mapping);
+
+    _Data = nullptr;
+    _Mapping = nullptr;
+    _Size = 0;
+    _Name.clear();
+    _Owner = false;
+}
+
+#else
+
+// Start of the POSIX objects, before the caller's data. It keeps the caller's data page aligned.
+struct Owner_Block_t
+{
+    // 0 until the creator wrote it.
+    std::atomic<int32_t> Pid;
+};
+
+static constexpr size_t OwnerBlockSize = 4096;
+
+static bool IsProcessAlive(pid_t pid)
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+static bool SameObject(std::string const& name, struct stat const& object)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+        return false;
+
+    struct stat current;
+    const bool same = fstat(fd, &current) == 0 && current.st_dev == object.st_dev && current.st_ino == object.st_ino;
+    close(fd);
+    return same;
+}
+
+// POSIX shared memory outlives its process, a crashed owner never unlinked its object.
+// Only an object whose owner process is gone is removed, a live one belongs to another overlay.
+static bool RemoveStaleObject(std::string const& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1)
+    {// Removed in the meantime, the name is free.
+        return errno == ENOENT;
+    }
+
+    struct stat st;
+    int32_t pid = 0;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(OwnerBlockSize))
+    {
+        void* data = mmap(nullptr, OwnerBlockSize, PROT_READ, MAP_SHARED, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            pid = reinterpret_cast<Owner_Block_t*>(data)->Pid.load(std::memory_order_acquire);
+            munmap(data, OwnerBlockSize);
+        }
+    }
+    close(fd);
+
+    // Without a pid, the owner is still creating it.
+    if (pid <= 0 || IsProcessAlive(static_cast<pid_t>(pid)))
+        return false;
+
+    // Another process may have replaced the stale object already.
+    if (!SameObject(name, st))
+        return true;
+
+    SPDLOG_INFO("Removing the shared memory {} of the dead process {}.", name, pid);
+    return shm_unlink(name.c_str()) == 0 || errno == ENOENT;
+}
+
+bool Shared_Memory::Create(std::string const& name, size_t size)
+{
+    Close();
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1 && errno == EEXIST && RemoveStaleObject(name))
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+
+    if (fd == -1)
+    {
+        SPDLOG_WARN("Failed to create the shared memory {}: {}.", name, errno);
+        return false;
+    }
+
+    // A new shared memory object is zero filled by ftruncate.
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && ftruncate(fd, static_cast<off_t>(OwnerBlockSize + size)) == 0)
+        data = mmap(nullptr, OwnerBlockSize + size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    // The mapping keeps the object alive.
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SPDLOG_WARN("Failed to map the shared memory {}: {}.", name, errno);
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    reinterpret_cast<Owner_Block_t*>(data)->Pid.store(static_cast<int32_t>(getpid()), std::memory_order_release);
+
+    _Data = reinterpret_cast<uint8_t*>(data) + OwnerBlockSize;
+    _Size = size;
+    _Name = name;
+    _Owner = true;
+    _Device = static_cast<uint64_t>(st.st_dev);
+    _Inode = static_cast<uint64_t>(st.st_ino);
+    return true;
+}
+
+bool Shared_Memory::Open(std::string const& name)
+{
+    Close();
+
+    int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd == -1)
+    {
+        SPDLOG_WARN("Failed to open the shared memory {}: {}.", name, errno);
+        return false;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > static_cast<off_t>(OwnerBlockSize))
+        data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SPDLOG_WARN("Failed to map the shared memory {}: {}.", name, errno);
+        return false;
+    }
+
+    _Data = reinterpret_cast<uint8_t*>(data) + OwnerBlockSize;
+    _Size = static_cast<size_t>(st.st_size) - OwnerBlockSize;
+    _Name = name;
+    _Owner = false;
+    return true;
+}
+
+void Shared_Memory::Close()
+{
+    if (_Data != nullptr)
+        munmap(reinterpret_cast<uint8_t*>(_Data) - OwnerBlockSize, OwnerBlockSize + _Size);
+
+    // The name may have been taken over after this process was thought dead, only remove our own object.
+    if (_Owner)
+    {
+        struct stat st;
+        st.st_dev = static_cast<dev_t>(_Device);
+        st.st_ino = static_cast<ino_t>(_Inode);
+        if (SameObject(_Name, st))
+            shm_unlink(_Name.c_str());
+    }
+
+    _Data = nullptr;
+    _Size = 0;
+    _Name.clear();
+    _Owner = false;
+    _Device = 0;
+    _Inode = 0;
+}
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Named shared memory region, mapped read/write. Shared between processes by name: shm_open on Linux and MacOS,
+// a named file mapping on Windows.
+class Shared_Memory
+{
+    void* _Data;
+    size_t _Size;
+    std::string _Name;
+    bool _Owner;
+#if defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(WIN64)
+    void* _Mapping;
+#else
+    // The object this process created, the name may point to another one after a takeover.
+    uint64_t _Device;
+    uint64_t _Inode;
+#endif
+
+    Shared_Memory(const Shared_Memory&) = delete;
+    Shared_Memory(Shared_Memory&&) = delete;
+    Shared_Memory& operator =(const Shared_Memory&) = delete;
+    Shared_Memory& operator =(Shared_Memory&&) = delete;
+
+public:
+    Shared_Memory();
+    ~Shared_Memory();
+
+    // Creates the region, zero filled. The creator removes the name on Close, the processes that opened it keep their mapping.
+    // Fails while another live process owns the name, the region left by a dead owner is replaced.
+    bool Create(std::string const& name, size_t size);
+    // Opens a region created by another process, its whole size is mapped.
+    bool Open(std::string const& name);
+    void Close();
+
+    void* Data() const { return _Data; }
+    size_t Size() const { return _Size; }
+};
@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include "Texture_Decompress.h"
+
+#include <algorithm>
+
+namespace ingame_overlay {
+namespace Texture_Decompress {
+
+// A decoded 4x4 block, row major RGBA.
+using Block_t = uint8_t[16][4];
+
+static inline uint8_t Clamp255(int value)
+{
+    return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+static inline uint64_t ReadLE64(const uint8_t* data)
+{
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | data[i];
+
+    return value;
+}
+
+static inline uint64_t ReadBE64(const uint8_t* data)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+        value = (value << 8) | data[i];
+
+    return value;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// S3TC/RGTC
+static void DecodeColorBlock(const uint8_t* data, Block_t& block, bool allow_transparent)
+{
+    const uint16_t c0 = static_cast<uint16_t>(data[0] | (data[1] << 8));
+    const uint16_t c1 = static_cast<uint16_t>(data[2] | (data[3] << 8));
+    const uint32_t indices = static_cast<uint32_t>(data[4] | (data[5] << 8) | (data[6] << 16) | (data[7] << 24));
+
+    uint8_t colors[4][4];
+    for (int i = 0; i < 2; ++i)
+    {
+        const uint16_t c = i == 0 ? c0 : c1;
+        const uint8_t r = (c >> 11) & 0x1f;
+        const uint8_t g = (c >> 5) & 0x3f;
+        const uint8_t b = c & 0x1f;
+        colors[i][0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        colors[i][1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        colors[i][2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        colors[i][3] = 255;
+    }
+
+    if (c0 > c1 || !allow_transparent)
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            colors[2][c] = static_cast<uint8_t>((2 * colors[0][c] + colors[1][c] + 1) / 3);
+            colors[3][c] = static_cast<uint8_t>((colors[0][c] + 2 * colors[1][c] + 1) / 3);
+        }
+        colors[2][3] = colors[3][3] = 255;
+    }
+    else
+    {
+        for (int c = 0; c < 3; ++c)
+        {
+            colors[2][c] = static_cast<uint8_t>((colors[0][c] + colors[1][c]) / 2);
+            colors[3][c] = 0;
+        }
+        colors[2][3] = 255;
+        colors[3][3] = 0;
+    }
+
+    for (int i = 0; i < 16; ++i)
+    {
+        const uint8_t* color = colors[(indices >> (i * 2)) & 0x03];
+        block[i][0] = color[0];
+        block[i][1] = color[1];
+        block[i][2] = color[2];
+        block[i][3] = color[3];
+    }
+}
+
+// BC3 alpha, BC4 and BC5 channels: 2 endpoints and 3 bits indices.
+static void DecodeChannelBlock(const uint8_t* data, Block_t& block, int channel)
+{
+    const int a0 = data[0];
+    const int a1 = data[1];
+    const uint64_t indices = ReadLE64(data) >> 16;
+
+    uint8_t values[8];
+    values[0] = static_cast<uint8_t>(a0);
+    values[1] = static_cast<uint8_t>(a1);
+    if (a0 > a1)
+    {
+        for (int i = 1; i < 7; ++i)
+            values[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1 + 3) / 7);
+    }
+    else
+    {
+        for (int i = 1; i < 5; ++i)
+            values[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1 + 2) / 5);
+        values[6] = 0;
+        values[7] = 255;
+    }
+
+    for (int i = 0; i < 16; ++i)
+        block[i][channel] = values[(indices >> (i * 3)) & 0x07];
+}
+
+static void DecodeBC2AlphaBlock(const uint8_t* data, Block_t& block)
+{
+    const uint64_t alphas = ReadLE64(data);
+    for (int i = 0; i < 16; ++i)
+        block[i][3] = static_cast<uint8_t>(((alphas >> (i * 4)) & 0x0f) * 17);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ETC2
+static const int EtcModifiers[8][4] = {
+    {  2,   8,  -2,   -8 },
+    {  5,  17,  -5,  -17 },
+    {  9,  29,  -9,  -29 },
+    { 13,  42, -13,  -42 },
+    { 18,  60, -18,  -60 },
+    { 24,  80, -24,  -80 },
+    { 33, 106, -33, -106 },
+    { 47, 183, -47, -183 },
+};
+
+static const int EtcDistances[8] = { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int EacModifiers[16][8] = {
+    { -3, -6,  -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 },
+    { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 },
+    { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 },
+    { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 },
+    { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 },
+    { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 },
+    { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+    { -3, -5,  -7,  -9, 2, 4, 6,  8 },
+};
+
+static inline uint32_t Bits(uint64_t value, int high, int low)
+{
+    return static_cast<uint32_t>((value >> low) & ((1ull << (high - low + 1)) - 1));
+}
+
+static inline uint8_t Extend4(uint32_t value) { return static_cast<uint8_t>((value << 4) | value); }
+static inline uint8_t Extend5(uint32_t value) { return static_cast<uint8_t>((value << 3) | (value >> 2)); }
+static inline uint8_t Extend6(uint32_t value) { return static_cast<uint8_t>((value << 2) | (value >> 4)); }
+static inline uint8_t Extend7(uint32_t value) { return static_cast<uint8_t>((value << 1) | (value >> 6)); }
+
+// ETC pixel indices are column major, the block is row major.
+static inline int EtcPixelIndex(uint64_t bits, int x, int y)
+{
+    const int i = x * 4 + y;
+    return static_cast<int>((((bits >> (16 + i)) & 1) << 1) | ((bits >> i) & 1));
+}
+
+static void DecodeEtcPaintBlock(uint64_t bits, uint8_t const (&paint)[4][3], Block_t& block)
+{
+    for (int y = 0; y < 4; ++y)
+    {
+        for (int x = 0; x < 4; ++x)
+        {
+            const uint8_t* color = paint[EtcPixelIndex(bits, x, y)];
+            uint8_t* pixel = block[y * 4 + x];
+            pixel[0] = color[0];
+            pixel[1] = color[1];
+            pixel[2] = color[2];
+            pixel[3] = 255;
+        }
+    }
+}
+
+static void DecodeEtc2ColorBlock(const uint8_t* data, Block_t& block)
+{
+    const uint64_t bits = ReadBE64(data);
+    const bool differential = Bits(bits, 33, 33) != 0;
+    const bool flip = Bits(bits, 32, 32) != 0;
+
+    uint8_t base[2][3];
+
+    if (differential)
+    {
+        const int r = static_cast<int>(Bits(bits, 63, 59));
+        const int g = static_cast<int>(Bits(bits, 55, 51));
+        const int b = static_cast<int>(Bits(bits, 47, 43));
+        // 3 bits two's complement deltas.
+        const int dr = static_cast<int>(Bits(bits, 58, 56) ^ 4) - 4;
+        const int dg = static_cast<int>(Bits(bits, 50, 48) ^ 4) - 4;
+        const int db = static_cast<int>(Bits(bits, 42, 40) ^ 4) - 4;
+
+        if (r + dr < 0 || r + dr > 31)
+        {// T mode
+            uint8_t paint[4][3];
+            const uint8_t c0[3] = {
+                Extend4((Bits(bits, 60, 59) << 2) | Bits(bits, 57, 56)),
+                Extend4(Bits(bits, 55, 52)),
+                Extend4(Bits(bits, 51, 48)),
+            };
+            const uint8_t c1[3] = {
+                Extend4(Bits(bits, 47, 44)),
+                Extend4(Bits(bits, 43, 40)),
+                Extend4(Bits(bits, 39, 36)),
+            };
+            const int distance = EtcDistances[(Bits(bits, 35, 34) << 1) | Bits(bits, 32, 32)];
+
+            for (int c = 0; c < 3; ++c)
+            {
+                paint[0][c] = c0[c];
+                paint[1][c] = Clamp255(c1[c] + distance);
+                paint[2][c] = c1[c];
+                paint[3][c] = Clamp255(c1[c] - distance);
+            }
+
+            DecodeEtcPaintBlock(bits, paint, block);
+            return;
+        }
+
+        if (g + dg < 0 || g + dg > 31)
+        {// H mode
+            uint8_t paint[4][3];
+            const uint32_t r0 = Bits(bits, 62, 59);
+            const uint32_t g0 = (Bits(bits, 58, 56) << 1) | Bits(bits, 52, 52);
+            const uint32_t b0 = (Bits(bits, 51, 51) << 3) | Bits(bits, 49, 47);
+            const uint32_t r1 = Bits(bits, 46, 43);
+            const uint32_t g1 = Bits(bits, 42, 39);
+            const uint32_t b1 = Bits(bits, 38, 35);
+            const uint32_t order = ((r0 << 8) | (g0 << 4) | b0) >= ((r1 << 8) | (g1 << 4) | b1) ? 1 : 0;
+            const int distance = EtcDistances[(Bits(bits, 34, 34) << 2) | (Bits(bits, 32, 32) << 1) | order];
+
+            const uint8_t c0[3] = { Extend4(r0), Extend4(g0), Extend4(b0) };
+            const uint8_t c1[3] = { Extend4(r1), Extend4(g1), Extend4(b1) };
+            for (int c = 0; c < 3; ++c)
+            {
+                paint[0][c] = Clamp255(c0[c] + distance);
+                paint[1][c] = Clamp255(c0[c] - distance);
+                paint[2][c] = Clamp255(c1[c] + distance);
+                paint[3][c] = Clamp255(c1[c] - distance);
+            }
+
+            DecodeEtcPaintBlock(bits, paint, block);
+            return;
+        }
+
+        if (b + db < 0 || b + db > 31)
+        {// Planar mode
+            const int origin[3] = {
+                Extend6(Bits(bits, 62, 57)),
+                Extend7((Bits(bits, 56, 56) << 6) | Bits(bits, 54, 49)),
+                Extend6((Bits(bits, 48, 48) << 5) | (Bits(bits, 44, 43) << 3) | Bits(bits, 41, 39)),
+            };
+            const int horizontal[3] = {
+                Extend6((Bits(bits, 38, 34) << 1) | Bits(bits, 32, 32)),
+                Extend7(Bits(bits, 31, 25)),
+                Extend6(Bits(bits, 24, 19)),
+            };
+            const int vertical[3] = {
+                Extend6(Bits(bits, 18, 13)),
+                Extend7(Bits(bits, 12, 6)),
+                Extend6(Bits(bits, 5, 0)),
+            };
+
+            for (int y = 0; y < 4; ++y)
+            {
+                for (int x = 0; x < 4; ++x)
+                {
+                    uint8_t* pixel = block[y * 4 + x];
+                    for (int c = 0; c < 3; ++c)
+                        pixel[c] = Clamp255((x * (horizontal[c] - origin[c]) + y * (vertical[c] - origin[c]) + 4 * origin[c] + 2) >> 2);
+
+                    pixel[3] = 255;
+                }
+            }
+            return;
+        }
+
+        base[0][0] = Extend5(r);
+        base[0][1] = Extend5(g);
+        base[0][2] = Extend5(b);
+        base[1][0] = Extend5(r + dr);
+        base[1][1] = Extend5(g + dg);
+        base[1][2] = Extend5(b + db);
+    }
+    else
+    {// Individual mode
+        base[0][0] = Extend4(Bits(bits, 63, 60));
+        base[1][0] = Extend4(Bits(bits, 59, 56));
+        base[0][1] = Extend4(Bits(bits, 55, 52));
+        base[1][1] = Extend4(Bits(bits, 51, 48));
+        base[0][2] = Extend4(Bits(bits, 47, 44));
+        base[1][2] = Extend4(Bits(bits, 43, 40));
+    }
+
+    const int* modifiers[2] = {
+        EtcModifiers[Bits(bits, 39, 37)],
+        EtcModifiers[Bits(bits, 36, 34)],
+    };
+
+    for (int y = 0; y < 4; ++y)
+    {
+        for (int x = 0; x < 4; ++x)
+        {
+            // Two 2x4 sub blocks side by side, or two 4x2 sub blocks on top of each other when flipped.
+            const int sub_block = flip ? (y >= 2) : (x >= 2);
+            const int modifier = modifiers[sub_block][EtcPixelIndex(bits, x, y)];
+
+            uint8_t* pixel = block[y * 4 + x];
+            for (int c = 0; c < 3; ++c)
+                pixel[c] = Clamp255(base[sub_block][c] + modifier);
+
+            pixel[3] = 255;
+        }
+    }
+}
+
+static void DecodeEacAlphaBlock(const uint8_t* data, Block_t& block)
+{
+    const uint64_t bits = ReadBE64(data);
+    const int base = static_cast<int>(Bits(bits, 63, 56));
+    const int multiplier = static_cast<int>(Bits(bits, 55, 52));
+    const int* modifiers = EacModifiers[Bits(bits, 51, 48)];
+
+    for (int x = 0; x < 4; ++x)
+    {
+        for (int y = 0; y < 4; ++y)
+        {
+            const int i = x * 4 + y;
+            const int index = static_cast<int>(Bits(bits, 47 - i * 3, 45 - i * 3));
+            block[y * 4 + x][3] = Clamp255(base + modifiers[index] * multiplier);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+uint32_t BlockSize(CompressedFormat format)
+{
+    switch (format)
+    {
+        case CompressedFormat::BC1:
+        case CompressedFormat::BC4:
+        case CompressedFormat::ETC2_RGB:
+            return 8;
+
+        case CompressedFormat::BC2:
+        case CompressedFormat::BC3:
+        case CompressedFormat::BC5:
+        case CompressedFormat::ETC2_RGBA:
+            return 16;
+    }
+
+    return 0;
+}
+
+size_t CompressedSize(CompressedFormat format, uint32_t width, uint32_t height)
+{
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BlockSize(format);
+}
+
+bool ToRGBA(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, CompressedFormat format, std::vector<uint8_t>& rgba)
+{
+    const size_t block_size = BlockSize(format);
+    if (compressed_data == nullptr || width == 0 || height == 0 || block_size == 0 || compressed_size < CompressedSize(format, width, height))
+        return false;
+
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(compressed_data);
+    const uint32_t blocks_x = (width + 3) / 4;
+    const uint32_t blocks_y = (height + 3) / 4;
+
+    Block_t block;
+    for (uint32_t by = 0; by < blocks_y; ++by)
+    {
+        for (uint32_t bx = 0; bx < blocks_x; ++bx, data += block_size)
+        {
+            switch (format)
+            {
+                case CompressedFormat::BC1:
+                    DecodeColorBlock(data, block, true);
+                    break;
+
+                case CompressedFormat::BC2:
+                    DecodeColorBlock(data + 8, block, false);
+                    DecodeBC2AlphaBlock(data, block);
+                    break;
+
+                case CompressedFormat::BC3:
+                    DecodeColorBlock(data + 8, block, false);
+                    DecodeChannelBlock(data, block, 3);
+                    break;
+
+                case CompressedFormat::BC4:
+                case CompressedFormat::BC5:
+                    for (int i = 0; i < 16; ++i)
+                    {
+                        block[i][1] = 0;
+                        block[i][2] = 0;
+                        block[i][3] = 255;
+                    }
+                    DecodeChannelBlock(data, block, 0);
+                    if (format == CompressedFormat::BC5)
+                        DecodeChannelBlock(data + 8, block, 1);
+                    break;
+
+                case CompressedFormat::ETC2_RGB:
+                    DecodeEtc2ColorBlock(data, block);
+                    break;
+
+                case CompressedFormat::ETC2_RGBA:
+                    DecodeEtc2ColorBlock(data + 8, block);
+                    DecodeEacAlphaBlock(data, block);
+                    break;
+            }
+
+            // Blocks on the right and bottom edges can go past the image.
+            const uint32_t block_width = std::min<uint32_t>(4, width - bx * 4);
+            const uint32_t block_height = std::min<uint32_t>(4, height - by * 4);
+            for (uint32_t y = 0; y < block_height; ++y)
+            {
+                uint8_t* row = &rgba[((static_cast<size_t>(by) * 4 + y) * width + bx * 4) * 4];
+                for (uint32_t x = 0; x < block_width; ++x)
+                {
+                    row[x * 4 + 0] = block[y * 4 + x][0];
+                    row[x * 4 + 1] = block[y * 4 + x][1];
+                    row[x * 4 + 2] = block[y * 4 + x][2];
+                    row[x * 4 + 3] = block[y * 4 + x][3];
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+}
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <ingame_overlay/Renderer_Hook.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ingame_overlay {
+
+// CPU decoders for the block compressed formats, used when the renderer can't sample them.
+// Decoded channels match what the GPU returns: BC4 is (r, 0, 0, 255), BC5 is (r, g, 0, 255).
+namespace Texture_Decompress {
+
+uint32_t BlockSize(CompressedFormat format);
+
+// The byte count of a width x height image made of 4x4 blocks, 0 for an unknown format.
+size_t CompressedSize(CompressedFormat format, uint32_t width, uint32_t height);
+
+// Decodes a whole image to tightly packed RGBA. compressed_size must be at least CompressedSize.
+bool ToRGBA(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, CompressedFormat format, std::vector<uint8_t>& rgba);
+
+}
+
+}
@@ -19,8 +19,13 @@
 
 #include <glad/gl.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "OpenGLX_Hook.h"
 #include "X11_Hook.h"
+#include "../Pixel_Convert.h"
+#include "../Texture_Decompress.h"
 
 #include <imgui.h>
 #include <backends/imgui_impl_opengl3.h>
@@ -28,6 +33,8 @@
 OpenGLX_Hook* OpenGLX_Hook::_inst = nullptr;
 
 constexpr decltype(OpenGLX_Hook::DLL_NAME) OpenGLX_Hook::DLL_NAME;
+constexpr std::chrono::milliseconds OpenGLX_Hook::DrawableReuseDelay;
+constexpr std::chrono::seconds OpenGLX_Hook::InstanceIdleTimeout;
 
 bool OpenGLX_Hook::StartHook(std::function<void()> key_combination_callback, std::set<ingame_overlay::ToggleKey> toggle_keys, /*ImFontAtlas* */ void* imgui_font_atlas)
 {
@@ -75,80 +82,202 @@ void OpenGLX_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t OpenGLX_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return X11_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t OpenGLX_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return X11_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool OpenGLX_Hook::IsStarted()
 {
     return _Hooked;
 }
 
-void OpenGLX_Hook::_ResetRenderState()
+OpenGLX_Hook::OverlayInstance_t* OpenGLX_Hook::_GetInstance(Display* display, GLXDrawable drawable, GLXContext context, std::chrono::steady_clock::time_point now)
 {
-    if (_Initialized)
+    const InstanceKey_t key{ display, drawable, context };
+    auto it = _Instances.find(key);
+    if (it != _Instances.end())
+        return it->second.get();
+
+    for (it = _Instances.begin(); it != _Instances.end(); ++it)
     {
-        OverlayHookReady(false);
+        OverlayInstance_t& instance = *it->second;
+        if (instance.XDisplay == display && instance.GLContext == context && (now - instance.LastSwap) > DrawableReuseDelay)
+            break;
+    }
 
+    if (it != _Instances.end())
+    {// The game switched drawables (fullscreen toggle, recreated window...), the instance follows it.
+        // Its ImGui context and font texture survive, only the X11 platform backend moves to the new drawable.
+        std::unique_ptr<OverlayInstance_t> instance = std::move(it->second);
+        _Instances.erase(it);
+
+        instance->GLDrawable = drawable;
+        instance->DrawableChangeTime = now;
+        instance->DrawableChangePending = true;
+        return (_Instances[key] = std::move(instance)).get();
+    }
+
+    // A drawable or a context we never drew on, like a launcher window next to the game or a second render thread.
+    std::unique_ptr<OverlayInstance_t> instance(new OverlayInstance_t);
+    instance->XDisplay = display;
+    instance->GLDrawable = drawable;
+    instance->GLContext = context;
+    instance->FontTexture = nullptr;
+    instance->LastSwap = now;
+    instance->DrawableChangePending = false;
+
+    instance->ImGuiCtx = ImGui::CreateContext(reinterpret_cast<ImFontAtlas*>(_ImGuiFontAtlas));
+    ImGui::SetCurrentContext(instance->ImGuiCtx);
+    ImGui_ImplOpenGL3_Init();
+
+    X11_Hook::Inst()->SetInitialWindowSize(display, (Window)drawable);
+
+    GLXContext no_context = nullptr;
+    _ResourceContext.compare_exchange_strong(no_context, context);
+
+    SPDLOG_INFO("Created overlay instance {} for drawable {} and GL context {}.", _Instances.size(), (uint64_t)drawable, (void*)context);
+    return (_Instances[key] = std::move(instance)).get();
+}
+
+// Must be called with the ImGui mutex held.
+// The GL objects are only deleted when the instance GL context is current, else they are left to the context and go away with it.
+void OpenGLX_Hook::_DestroyInstance(OverlayInstance_t& instance)
+{
+    ImGui::SetCurrentContext(instance.ImGuiCtx);
+
+    if (glXGetCurrentContext() == instance.GLContext)
+    {
+        instance.SdfShader.Destroy();
+        instance.QuadRenderer.Destroy();
         ImGui_ImplOpenGL3_Shutdown();
+    }
+    else
+    {// The backend data can't be freed without its GL objects, detach it so the context can be destroyed.
+        ImGuiIO& io = ImGui::GetIO();
+        io.BackendRendererName = nullptr;
+        io.BackendRendererUserData = nullptr;
+        io.BackendFlags &= ~ImGuiBackendFlags_RendererHasVtxOffset;
+    }
+
+    if (_X11Hooked)
         X11_Hook::Inst()->ResetRenderState();
-        ImGui::DestroyContext();
 
-        glXDestroyContext(_Display, _Context);
-        _Display = nullptr;
-        _Initialized = false;
+    ImGui::DestroyContext(instance.ImGuiCtx);
+    instance.ImGuiCtx = nullptr;
+}
+
+void OpenGLX_Hook::_DestroyIdleInstances(GLXContext context, std::chrono::steady_clock::time_point now)
+{
+    // GL objects can only be deleted with their context current, instances of the other contexts wait for their next swap.
+    for (auto it = _Instances.begin(); it != _Instances.end();)
+    {
+        OverlayInstance_t& instance = *it->second;
+        if (instance.GLContext == context && (now - instance.LastSwap) > InstanceIdleTimeout)
+        {
+            SPDLOG_INFO("Destroying idle overlay instance of drawable {}.", (uint64_t)instance.GLDrawable);
+            _DestroyInstance(instance);
+            it = _Instances.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
     }
 }
 
 // Try to make this function and overlay's proc as short as possible or it might affect game's fps.
 void OpenGLX_Hook::_PrepareForOverlay(Display* display, GLXDrawable drawable)
 {
-    if( !_Initialized )
-    {
-        ImGui::CreateContext(reinterpret_cast<ImFontAtlas*>(_ImGuiFontAtlas));
-        ImGui_ImplOpenGL3_Init();
-
-        //int attributes[] = { //can't be const b/c X11 doesn't like it.  Not sure if that's intentional or just stupid.
-        //    GLX_RGBA, //apparently nothing comes after this?
-        //    GLX_RED_SIZE,    8,
-        //    GLX_GREEN_SIZE,  8,
-        //    GLX_BLUE_SIZE,   8,
-        //    GLX_ALPHA_SIZE,  8,
-        //    //Ideally, the size would be 32 (or at least 24), but I have actually seen
-        //    //  this size (on a modern OS even).
-        //    GLX_DEPTH_SIZE, 16,
-        //    GLX_DOUBLEBUFFER, True,
-        //    None
-        //};
-        //
-        //XVisualInfo* visual_info = glXChooseVisual(_Display, DefaultScreen(_Display), attributes);
-        //if (visual_info == nullptr)
-        //    return;
-        //
-        //_Context = glXCreateContext(_Display, visual_info, nullptr, True);
-        //if (_Context == nullptr)
-        //    return;
-
-        _Display = display;
-
-        X11_Hook::Inst()->SetInitialWindowSize(_Display, (Window)drawable);
+    GLXContext context = glXGetCurrentContext();
+    if (context == nullptr)
+        return;
+
+    // Swaps can come from several render threads, the ImGui current context is a global.
+    std::lock_guard<std::recursive_mutex> lock(X11_Hook::Inst()->GetImGuiMutex());
+    ImGuiContext* previous_context = ImGui::GetCurrentContext();
 
+    const auto now = std::chrono::steady_clock::now();
+    OverlayInstance_t* instance = _GetInstance(display, drawable, context, now);
+    instance->LastSwap = now;
+    ImGui::SetCurrentContext(instance->ImGuiCtx);
+    _CurrentInstance = instance;
+
+    if (!_Initialized)
+    {
         _Initialized = true;
         OverlayHookReady(true);
     }
 
-    //auto oldContext = glXGetCurrentContext();
+    // Image resources live in the first instance context, they are only created, updated and drawn there.
+    const bool resource_context = context == _ResourceContext.load(std::memory_order_relaxed);
+    if (resource_context)
+    {
+        _CollectReleasedTextures(false);
+        _ProcessImageCommands();
+    }
 
-    //glXMakeCurrent(_Display, drawable, _Context);
+    ImGuiIO& io = ImGui::GetIO();
+    if (instance->FontTexture != nullptr)
+        io.Fonts->SetTexID(instance->FontTexture);
 
-    if (ImGui_ImplOpenGL3_NewFrame() && X11_Hook::Inst()->PrepareForOverlay(_Display, (Window)drawable))
+    if (ImGui_ImplOpenGL3_NewFrame())
     {
-        ImGui::NewFrame();
+        // The first NewFrame uploads the font texture of this instance.
+        instance->FontTexture = io.Fonts->TexID;
+
+        if (X11_Hook::Inst()->PrepareForOverlay(display, (Window)drawable))
+        {
+            ImGui::NewFrame();
+
+            OverlayProc();
+
+            // Every instance draws on each swap, the scheduled work is run once per frame, where the images can be created.
+            if (resource_context)
+                FrameScheduler.RunFrame();
 
-        OverlayProc();
+            ImGui::Render();
 
-        ImGui::Render();
+            instance->QuadRenderer.RenderDrawData(ImGui::GetDrawData());
 
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            if (instance->DrawableChangePending)
+            {
+                instance->DrawableChangePending = false;
+                SPDLOG_DEBUG("First overlay frame drawn {}us after the drawable change.", std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - instance->DrawableChangeTime).count());
+            }
+        }
+    }
+
+    if (resource_context)
+    {
+        // Textures released during this frame can be deleted once the GPU went past it.
+        if (GLAD_GL_ARB_sync && !_PendingReleases.empty() && _PendingReleases.back().Fence == nullptr)
+        {
+            GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            for (auto& release : _PendingReleases)
+            {
+                if (release.Fence == nullptr)
+                    release.Fence = fence;
+            }
+        }
+        ++_FrameCount;
     }
 
-    //glXMakeCurrent(_Display, drawable, oldContext);
+    _CurrentInstance = nullptr;
+    _DestroyIdleInstances(context, now);
+
+    ImGui::SetCurrentContext(previous_context);
 }
 
 void OpenGLX_Hook::MyglXSwapBuffers(Display* display, GLXDrawable drawable)
@@ -161,9 +290,16 @@ OpenGLX_Hook::OpenGLX_Hook():
     _Initialized(false),
     _Hooked(false),
     _X11Hooked(false),
+    _CurrentInstance(nullptr),
+    _ResourceContext(nullptr),
     _ImGuiFontAtlas(nullptr),
+    _ImageUploadBuffer(0),
+    _FrameCount(0),
     glXSwapBuffers(nullptr)
 {
+    // Let other threads create images before the first frame.
+    _ReserveImageResources();
+
     //_library = dlopen(DLL_NAME);
 }
 
@@ -171,14 +307,42 @@ OpenGLX_Hook::~OpenGLX_Hook()
 {
     SPDLOG_INFO("OpenGLX Hook removed");
 
-    if (_X11Hooked)
-        delete X11_Hook::Inst();
-
     if (_Initialized)
     {
-        ImGui_ImplOpenGL3_Shutdown();
-        ImGui::DestroyContext();
-        glXDestroyContext(_Display, _Context);
+        // The hook is usually removed from a thread without the game GL context, the image resources are then left to it.
+        GLXContext current_context = glXGetCurrentContext();
+        if (current_context != nullptr && current_context == _ResourceContext.load())
+        {
+            std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+            _ImageResources.ForEach([](ingame_overlay::ImageResourceHandle, uint32_t& texture)
+            {
+                GLuint name = texture;
+                if (name != 0)
+                    glDeleteTextures(1, &name);
+            });
+            _CollectReleasedTextures(true);
+
+            if (_ImageUploadBuffer != 0)
+            {
+                GLuint buffer = _ImageUploadBuffer;
+                glDeleteBuffers(1, &buffer);
+                _ImageUploadBuffer = 0;
+            }
+        }
+
+        {
+            std::lock_guard<std::recursive_mutex> lock(X11_Hook::Inst()->GetImGuiMutex());
+            for (auto& item : _Instances)
+                _DestroyInstance(*item.second);
+
+            _Instances.clear();
+        }
+    }
+
+    if (_X11Hooked)
+    {// Shuts the platform backend of the windows left down.
+        delete X11_Hook::Inst();
+        _X11Hooked = false;
     }
 
     //dlclose(_library);
@@ -204,52 +368,550 @@ void OpenGLX_Hook::LoadFunctions(decltype(::glXSwapBuffers)* pfnglXSwapBuffers)
     glXSwapBuffers = pfnglXSwapBuffers;
 }
 
-std::weak_ptr<uint64_t> OpenGLX_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+bool OpenGLX_Hook::_IsRenderThread() const
 {
-    GLuint* texture = new GLuint(0);
-    glGenTextures(1, texture);
-    if (glGetError() != GL_NO_ERROR)
+    // A GL context is current on one thread at most, the thread that has the resource context is the one that can use its objects.
+    GLXContext context = _ResourceContext.load(std::memory_order_relaxed);
+    return context != nullptr && glXGetCurrentContext() == context;
+}
+
+void OpenGLX_Hook::_ReserveImageResources()
+{
+    // Other threads pick their handles from this ring, the mutex is only contended when it was emptied.
+    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+    while (!_ReservedImageResources.Full())
+        _ReservedImageResources.Push(_ImageResources.Insert(0));
+}
+
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::_PopReservedImageResource()
+{
+    ingame_overlay::ImageResourceHandle handle;
+    if (_ReservedImageResources.Pop(handle))
+        return handle;
+
+    // More creations than reserved handles since the last frame.
+    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+    return _ImageResources.Insert(0);
+}
+
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::_InsertTexture(uint32_t texture)
+{
+    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+    return _ImageResources.Insert(texture);
+}
+
+uint32_t OpenGLX_Hook::_GetTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    // Pointers into _ImageResources don't outlive the lock, another thread's Insert might move the slots.
+    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+    uint32_t* texture = _ImageResources.Get(resource);
+    return texture == nullptr ? 0 : *texture;
+}
+
+void OpenGLX_Hook::_SetCreatedTexture(ingame_overlay::ImageResourceHandle resource, uint32_t texture)
+{
+    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+    uint32_t* slot = _ImageResources.Get(resource);
+    if (slot == nullptr)
+        return;
+
+    if (texture == 0)
+    {// Make the handle stale, so the caller sees the failure.
+        uint32_t unused;
+        _ImageResources.Remove(resource, unused);
+    }
+    else
     {
-        delete texture;
-        return std::shared_ptr<uint64_t>(nullptr);
+        *slot = texture;
     }
+}
+
+void OpenGLX_Hook::_ProcessImageCommands()
+{
+    ImageCommand_t command;
+    while (_ImageCommands.Pop(command))
+    {
+        switch (command.CommandType)
+        {
+            case ImageCommand_t::Type::Create:
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+                    // Released before we could create it.
+                    if (_ImageResources.Get(command.Handle) == nullptr)
+                        break;
+                }
+
+                uint32_t texture = _CreateTexture(command.Pixels.data(), command.Width, command.Height, GL_RGBA, 0, 4);
+                if (texture != 0 && command.Mipmaps)
+                    _GenerateMipmaps(texture, command.Pixels.data(), command.Width, command.Height);
+
+                _SetCreatedTexture(command.Handle, texture);
+            }
+            break;
+
+            case ImageCommand_t::Type::CreateCompressed:
+            {
+                {
+                    std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+                    if (_ImageResources.Get(command.Handle) == nullptr)
+                        break;
+                }
+
+                _SetCreatedTexture(command.Handle, _CreateCompressedTexture(command.Pixels.data(), command.Pixels.size(), command.Width, command.Height, command.Format));
+            }
+            break;
+
+            case ImageCommand_t::Type::Update:
+            {
+                uint32_t texture = _GetTexture(command.Handle);
+                if (texture != 0)
+                    _UploadTexture(texture, command.X, command.Y, command.Width, command.Height, command.Pixels.data(), command.Width * 4);
+            }
+            break;
+
+            case ImageCommand_t::Type::Release:
+                ReleaseImageResource(command.Handle);
+                break;
+        }
+    }
+
+    _ReserveImageResources();
+}
+
+void OpenGLX_Hook::_CollectReleasedTextures(bool force)
+{
+    // Without sync objects, assume the driver never queues more than this many frames.
+    constexpr uint64_t MaxFramesInFlight = 3;
+
+    auto it = _PendingReleases.begin();
+    while (it != _PendingReleases.end())
+    {
+        bool gpu_done = force;
+        if (!gpu_done)
+        {
+            if (it->Fence != nullptr)
+            {
+                GLenum status = glClientWaitSync(reinterpret_cast<GLsync>(it->Fence), 0, 0);
+                gpu_done = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED || status == GL_WAIT_FAILED;
+            }
+            else if (!GLAD_GL_ARB_sync)
+            {
+                gpu_done = (_FrameCount - it->Frame) > MaxFramesInFlight;
+            }
+        }
+
+        if (!gpu_done)
+        {
+            ++it;
+            continue;
+        }
+
+        GLuint name = it->Texture;
+        glDeleteTextures(1, &name);
+
+        // Several releases can share the same frame fence, delete it with the last one.
+        if (it->Fence != nullptr && std::none_of(_PendingReleases.begin(), _PendingReleases.end(), [&it](PendingRelease_t const& item) { return &item != &*it && item.Fence == it->Fence; }))
+            glDeleteSync(reinterpret_cast<GLsync>(it->Fence));
+
+        it = _PendingReleases.erase(it);
+    }
+}
+
+uint32_t OpenGLX_Hook::_CreateTexture(const void* image_data, uint32_t width, uint32_t height, uint32_t format, uint32_t row_length, uint32_t alignment)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    if (glGetError() != GL_NO_ERROR)
+        return 0;
     
     // Save old texture id
-    GLint oldTex;
+    GLint oldTex, oldAlignment;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
 
-    glBindTexture(GL_TEXTURE_2D, *texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Upload pixels into texture
+    // Upload pixels into texture, GL swizzles BGR(A) and expands RGB to RGBA for us.
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row_length);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, format, GL_UNSIGNED_BYTE, image_data);
+
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+    glBindTexture(GL_TEXTURE_2D, oldTex);
+
+    return texture;
+}
+
+void OpenGLX_Hook::_GenerateMipmaps(uint32_t texture, const void* image_data, uint32_t width, uint32_t height)
+{
+    GLint oldTex;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    if (GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_framebuffer_object || GLAD_GL_EXT_framebuffer_object)
+    {
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    else
+    {// No GPU mipmap generation, build the levels on the CPU.
+        std::vector<std::vector<uint8_t>> levels;
+        ingame_overlay::Pixel_Convert::BuildMipChain(reinterpret_cast<const uint8_t*>(image_data), width, height, levels);
+
+        GLint oldAlignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            width = std::max<uint32_t>(1, width / 2);
+            height = std::max<uint32_t>(1, height / 2);
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i + 1), GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[i].data());
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+    }
+
+    // Trilinear filtering, blend the two closest levels.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
     glBindTexture(GL_TEXTURE_2D, oldTex);
+}
+
+uint32_t OpenGLX_Hook::_CreateCompressedTexture(const void* compressed_data, uint32_t compressed_size, uint32_t width, uint32_t height, uint32_t internal_format)
+{
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    if (glGetError() != GL_NO_ERROR)
+        return 0;
+
+    // Save old texture id
+    GLint oldTex;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
+
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // The blocks go to the GPU as is, they stay compressed in video memory.
+    glCompressedTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, compressed_size, compressed_data);
+    const bool created = glGetError() == GL_NO_ERROR;
+
+    glBindTexture(GL_TEXTURE_2D, oldTex);
+
+    if (!created)
+    {
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+
+    return texture;
+}
+
+uint32_t OpenGLX_Hook::_CreateCompressedTexture(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
+{
+    GLenum internal_format = 0;
+    switch (format)
+    {
+        case ingame_overlay::CompressedFormat::BC1:
+        case ingame_overlay::CompressedFormat::BC2:
+        case ingame_overlay::CompressedFormat::BC3:
+            if (GLAD_GL_EXT_texture_compression_s3tc)
+            {
+                internal_format = format == ingame_overlay::CompressedFormat::BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT :
+                                  format == ingame_overlay::CompressedFormat::BC2 ? GL_COMPRESSED_RGBA_S3TC_DXT3_EXT :
+                                                                                    GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            }
+            break;
+
+        case ingame_overlay::CompressedFormat::BC4:
+        case ingame_overlay::CompressedFormat::BC5:
+            if (GLAD_GL_VERSION_3_0 || GLAD_GL_ARB_texture_compression_rgtc || GLAD_GL_EXT_texture_compression_rgtc)
+                internal_format = format == ingame_overlay::CompressedFormat::BC4 ? GL_COMPRESSED_RED_RGTC1 : GL_COMPRESSED_RG_RGTC2;
+            break;
+
+        case ingame_overlay::CompressedFormat::ETC2_RGB:
+        case ingame_overlay::CompressedFormat::ETC2_RGBA:
+            if (GLAD_GL_ARB_ES3_compatibility)
+                internal_format = format == ingame_overlay::CompressedFormat::ETC2_RGB ? GL_COMPRESSED_RGB8_ETC2 : GL_COMPRESSED_RGBA8_ETC2_EAC;
+            break;
+    }
+
+    if (internal_format != 0)
+    {
+        uint32_t texture = _CreateCompressedTexture(compressed_data, static_cast<uint32_t>(compressed_size), width, height, internal_format);
+        if (texture != 0)
+            return texture;
+
+        SPDLOG_WARN("Failed to create compressed texture, decompressing it.");
+    }
+
+    // Unsupported format: decompress it and upload it as RGBA.
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Texture_Decompress::ToRGBA(compressed_data, compressed_size, width, height, format, rgba))
+        return 0;
+
+    return _CreateTexture(rgba.data(), width, height, GL_RGBA, 0, 4);
+}
+
+bool OpenGLX_Hook::_UploadTexture(uint32_t texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    const GLsizeiptr upload_size = static_cast<GLsizeiptr>(stride) * (height - 1) + width * 4;
+
+    if (_ImageUploadBuffer == 0)
+    {
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        _ImageUploadBuffer = buffer;
+    }
+
+    // Save old state
+    GLint oldTex, oldUnpackBuffer, oldRowLength, oldAlignment;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &oldUnpackBuffer);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldRowLength);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _ImageUploadBuffer);
+    // Orphan the previous storage so we never wait on an upload still in flight.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_size, nullptr, GL_STREAM_DRAW);
+
+    bool uploaded = false;
+    void* staging = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (staging != nullptr)
+    {
+        memcpy(staging, image_data, upload_size);
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            // Source is the bound pixel unpack buffer, the pointer is an offset into it.
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            uploaded = glGetError() == GL_NO_ERROR;
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, oldRowLength);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, oldUnpackBuffer);
+    glBindTexture(GL_TEXTURE_2D, oldTex);
+
+    return uploaded;
+}
+
+void OpenGLX_Hook::_ReleaseTexture(uint32_t texture)
+{
+    // The current frame, or one still queued in the driver, might sample this texture.
+    _PendingReleases.emplace_back(PendingRelease_t{ texture, nullptr, _FrameCount });
+}
+
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+{
+    return CreateImageResource(image_data, width, height, ingame_overlay::ImageResourceOptions());
+}
+
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    if (image_data == nullptr || width == 0 || height == 0)
+        return 0;
+
+    std::vector<uint8_t> fitted;
+    if (ingame_overlay::Pixel_Convert::Fit(reinterpret_cast<const uint8_t*>(image_data), width, height, options.MaxSize, options.MaxSize, fitted, width, height))
+        image_data = fitted.data();
 
-    auto ptr = std::shared_ptr<uint64_t>((uint64_t*)texture, [](uint64_t* handle)
+    if (_IsRenderThread())
     {
-        if (handle != nullptr)
+        uint32_t texture = _CreateTexture(image_data, width, height, GL_RGBA, 0, 4);
+        if (texture == 0)
+            return 0;
+
+        if (options.Mipmaps)
+            _GenerateMipmaps(texture, image_data, width, height);
+
+        return _InsertTexture(texture);
+    }
+
+    // Not on the render thread: copy the pixels and let the swap hook create the texture.
+    ImageCommand_t command;
+    command.Handle = _PopReservedImageResource();
+    command.CommandType = ImageCommand_t::Type::Create;
+    command.X = 0;
+    command.Y = 0;
+    command.Width = width;
+    command.Height = height;
+    command.Mipmaps = options.Mipmaps;
+    if (fitted.empty())
+    {
+        const uint8_t* pixels = reinterpret_cast<const uint8_t*>(image_data);
+        command.Pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+    }
+    else
+    {
+        command.Pixels = std::move(fitted);
+    }
+
+    ingame_overlay::ImageResourceHandle handle = command.Handle;
+    _ImageCommands.Push(std::move(command));
+    return handle;
+}
+
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    const uint32_t bytes_per_pixel = ingame_overlay::Pixel_Convert::BytesPerPixel(format);
+    if (image_data == nullptr || width == 0 || height == 0 || bytes_per_pixel == 0)
+        return 0;
+
+    if (stride == 0)
+        stride = width * bytes_per_pixel;
+
+    // GL can take straight alpha pixels as is, as long as the stride is a whole number of pixels.
+    if (_IsRenderThread() && alpha_mode == ingame_overlay::AlphaMode::Straight && stride >= width * bytes_per_pixel && (stride % bytes_per_pixel) == 0)
+    {
+        GLenum gl_format = GL_RGBA;
+        switch (format)
         {
-            GLuint* texture = (GLuint*)handle;
-            glDeleteTextures(1, texture);
-            delete texture;
+            case ingame_overlay::PixelFormat::RGBA: gl_format = GL_RGBA; break;
+            case ingame_overlay::PixelFormat::BGRA: gl_format = GL_BGRA; break;
+            case ingame_overlay::PixelFormat::RGB : gl_format = GL_RGB ; break;
+            case ingame_overlay::PixelFormat::BGR : gl_format = GL_BGR ; break;
         }
-    });
 
-    _ImageResources.emplace(ptr);
-    return ptr;
+        uint32_t texture = _CreateTexture(image_data, width, height, gl_format, stride / bytes_per_pixel, bytes_per_pixel == 4 ? 4 : 1);
+        if (texture == 0)
+            return 0;
+
+        return _InsertTexture(texture);
+    }
+
+    // Other threads convert on their side, the swap hook only has to copy the RGBA pixels.
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Pixel_Convert::ToRGBA(image_data, width, height, format, stride, alpha_mode, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
 }
 
-void OpenGLX_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+ingame_overlay::ImageResourceHandle OpenGLX_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
 {
-    auto ptr = resource.lock();
-    if (ptr)
+    const size_t expected_size = ingame_overlay::Texture_Decompress::CompressedSize(format, width, height);
+    if (compressed_data == nullptr || width == 0 || height == 0 || expected_size == 0 || compressed_size < expected_size)
+        return 0;
+
+    if (_IsRenderThread())
     {
-        auto it = _ImageResources.find(ptr);
-        if (it != _ImageResources.end())
-            _ImageResources.erase(it);
+        uint32_t texture = _CreateCompressedTexture(compressed_data, expected_size, width, height, format);
+        if (texture == 0)
+            return 0;
+
+        return _InsertTexture(texture);
     }
+
+    // Not on the render thread: only the swap hook knows what formats the context supports, let it pick.
+    ImageCommand_t command;
+    command.Handle = _PopReservedImageResource();
+
+    const uint8_t* blocks = reinterpret_cast<const uint8_t*>(compressed_data);
+    command.CommandType = ImageCommand_t::Type::CreateCompressed;
+    command.X = 0;
+    command.Y = 0;
+    command.Width = width;
+    command.Height = height;
+    command.Format = format;
+    command.Pixels.assign(blocks, blocks + expected_size);
+
+    ingame_overlay::ImageResourceHandle handle = command.Handle;
+    _ImageCommands.Push(std::move(command));
+    return handle;
+}
+
+void OpenGLX_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
+{
+    if (!_IsRenderThread())
+    {
+        ImageCommand_t command;
+        command.CommandType = ImageCommand_t::Type::Release;
+        command.Handle = resource;
+        _ImageCommands.Push(std::move(command));
+        return;
+    }
+
+    uint32_t texture;
+    bool removed;
+    {
+        std::lock_guard<std::mutex> lock(_ImageResourcesMutex);
+        removed = _ImageResources.Remove(resource, texture);
+    }
+
+    if (removed && texture != 0)
+        _ReleaseTexture(texture);
+}
+
+bool OpenGLX_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    if (resource == 0 || image_data == nullptr || width == 0 || height == 0)
+        return false;
+
+    if (stride == 0)
+        stride = width * 4;
+
+    // GL_UNPACK_ROW_LENGTH is expressed in pixels, the stride must hold whole RGBA pixels.
+    if (stride < width * 4 || (stride % 4) != 0)
+        return false;
+
+    if (_IsRenderThread())
+    {
+        uint32_t texture = _GetTexture(resource);
+        if (texture == 0)
+            return false;
+
+        return _UploadTexture(texture, x, y, width, height, image_data, stride);
+    }
+
+    // Not on the render thread: the handle is checked when the swap hook replays the update.
+    ImageCommand_t command;
+    command.CommandType = ImageCommand_t::Type::Update;
+    command.Handle = resource;
+    command.X = x;
+    command.Y = y;
+    command.Width = width;
+    command.Height = height;
+    command.Pixels.resize(static_cast<size_t>(width) * height * 4);
+
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(image_data);
+    for (uint32_t row = 0; row < height; ++row)
+        memcpy(&command.Pixels[static_cast<size_t>(row) * width * 4], pixels + static_cast<size_t>(row) * stride, width * 4);
+
+    _ImageCommands.Push(std::move(command));
+    return true;
+}
+
+void* OpenGLX_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    // Textures are only meant to be drawn from OverlayProc.
+    if (!_IsRenderThread())
+        return nullptr;
+
+    uint32_t texture = _GetTexture(resource);
+    return texture == 0 ? nullptr : reinterpret_cast<void*>(static_cast<uintptr_t>(texture));
+}
+
+bool OpenGLX_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return _CurrentInstance != nullptr && _CurrentInstance->SdfShader.Begin(imgui_draw_list);
+}
+
+void OpenGLX_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+    if (_CurrentInstance != nullptr)
+        _CurrentInstance->SdfShader.End(imgui_draw_list);
 }
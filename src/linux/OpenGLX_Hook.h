@@ -20,11 +20,25 @@
 #pragma once
 
 #include <ingame_overlay/Renderer_Hook.h>
+#include <ingame_overlay/Slot_Map.h>
 
 #include "../internal_includes.h"
+#include "../OpenGL_Quad_Renderer.h"
+#include "../OpenGL_Sdf_Shader.h"
+#include "../Lockfree_Queue.h"
 
 #include <GL/glx.h>
 
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+struct ImGuiContext;
+
 class OpenGLX_Hook :
     public ingame_overlay::Renderer_Hook,
     public Base_Hook
@@ -35,20 +49,109 @@ public:
 private:
     static OpenGLX_Hook* _inst;
 
+    // Image resource call made outside of the render thread, replayed by the swap hook.
+    struct ImageCommand_t
+    {
+        enum class Type
+        {
+            Create,
+            CreateCompressed,
+            Update,
+            Release,
+        };
+
+        Type CommandType;
+        ingame_overlay::ImageResourceHandle Handle;
+        uint32_t X, Y;
+        uint32_t Width, Height;
+        // Create only, build the mip chain.
+        bool Mipmaps = false;
+        // CreateCompressed only, the format of the blocks in Pixels.
+        ingame_overlay::CompressedFormat Format = ingame_overlay::CompressedFormat::BC1;
+        // Tightly packed RGBA rows, or the compressed blocks for CreateCompressed.
+        std::vector<uint8_t> Pixels;
+    };
+
+    // Texture released by the overlay, deleted once the GPU is done with the frames that might sample it.
+    struct PendingRelease_t
+    {
+        uint32_t Texture;
+        // GLsync of the first frame rendered after the release, nullptr until that frame is submitted.
+        void* Fence;
+        uint64_t Frame;
+    };
+
+    // Overlay drawn on a drawable with a GL context, with its own ImGui context and ImGui GL objects.
+    struct OverlayInstance_t
+    {
+        Display* XDisplay;
+        GLXDrawable GLDrawable;
+        GLXContext GLContext;
+        ImGuiContext* ImGuiCtx;
+        // This instance font texture, the ImFontAtlas given to StartHook is shared by every instance.
+        void* FontTexture;
+        OpenGL_Sdf_Shader SdfShader;
+        // Draws the text and rectangles as instances, the rest through the ImGui backend.
+        OpenGL_Quad_Renderer QuadRenderer;
+        std::chrono::steady_clock::time_point LastSwap;
+        std::chrono::steady_clock::time_point DrawableChangeTime;
+        bool DrawableChangePending;
+    };
+
+    using InstanceKey_t = std::tuple<Display*, GLXDrawable, GLXContext>;
+
+    // An instance of the same context that didn't swap for this long is reused by a new drawable, else a new instance is made.
+    static constexpr std::chrono::milliseconds DrawableReuseDelay{ 500 };
+    // Instances that didn't swap for this long are destroyed, once their GL context is current again.
+    static constexpr std::chrono::seconds InstanceIdleTimeout{ 10 };
+
     // Variables
     bool _Hooked;
     bool _X11Hooked;
     bool _Initialized;
-    Display *_Display;
-    GLXContext _Context;
-    std::set<std::shared_ptr<uint64_t>> _ImageResources;
+    // Guarded by X11_Hook::GetImGuiMutex.
+    std::map<InstanceKey_t, std::unique_ptr<OverlayInstance_t>> _Instances;
+    // Instance being drawn, only set by the swap hook while it holds the ImGui mutex.
+    OverlayInstance_t* _CurrentInstance;
+    // GL context owning the image resources, the one of the first instance.
+    // Other contexts can't sample them unless they share their objects with it, so they are only drawn by its instances.
+    std::atomic<GLXContext> _ResourceContext;
+    // GL texture names. 0 is a handle reserved for a creation still in _ImageCommands.
+    ingame_overlay::Slot_Map<uint32_t> _ImageResources;
+    // Guards _ImageResources. Other threads only take it when _ReservedImageResources ran out of handles.
+    std::mutex _ImageResourcesMutex;
+    // Handles given to CreateImageResource calls made outside of the render thread.
+    Spmc_Ring<ingame_overlay::ImageResourceHandle, 64> _ReservedImageResources;
+    Mpsc_Queue<ImageCommand_t> _ImageCommands;
+    std::vector<PendingRelease_t> _PendingReleases;
+    uint64_t _FrameCount;
+    // Pixel unpack buffer used to stream UpdateImageResource uploads.
+    uint32_t _ImageUploadBuffer;
     void* _ImGuiFontAtlas;
 
     // Functions
     OpenGLX_Hook();
 
-    void _ResetRenderState();
     void _PrepareForOverlay(Display* display, GLXDrawable drawable);
+    OverlayInstance_t* _GetInstance(Display* display, GLXDrawable drawable, GLXContext context, std::chrono::steady_clock::time_point now);
+    void _DestroyInstance(OverlayInstance_t& instance);
+    void _DestroyIdleInstances(GLXContext context, std::chrono::steady_clock::time_point now);
+    bool _IsRenderThread() const;
+    void _ReserveImageResources();
+    ingame_overlay::ImageResourceHandle _PopReservedImageResource();
+    ingame_overlay::ImageResourceHandle _InsertTexture(uint32_t texture);
+    // 0 for a stale handle or a creation still queued.
+    uint32_t _GetTexture(ingame_overlay::ImageResourceHandle resource);
+    void _SetCreatedTexture(ingame_overlay::ImageResourceHandle resource, uint32_t texture);
+    void _ProcessImageCommands();
+    void _CollectReleasedTextures(bool force);
+    uint32_t _CreateTexture(const void* image_data, uint32_t width, uint32_t height, uint32_t format, uint32_t row_length, uint32_t alignment);
+    void _GenerateMipmaps(uint32_t texture, const void* image_data, uint32_t width, uint32_t height);
+    uint32_t _CreateCompressedTexture(const void* compressed_data, uint32_t compressed_size, uint32_t width, uint32_t height, uint32_t internal_format);
+    // Uses the native format when the context supports it, or decompresses to RGBA.
+    uint32_t _CreateCompressedTexture(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format);
+    bool _UploadTexture(uint32_t texture, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride);
+    void _ReleaseTexture(uint32_t texture);
 
     // Hook to render functions
     decltype(::glXSwapBuffers)* glXSwapBuffers;
@@ -63,11 +166,20 @@ public:
     virtual bool StartHook(std::function<void()> key_combination_callback, std::set<ingame_overlay::ToggleKey> toggle_keys, /*ImFontAtlas* */ void* imgui_font_atlas = nullptr);
     virtual void HideAppInputs(bool hide);
     virtual void HideOverlayInputs(bool hide);
+    virtual uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    virtual uint32_t ToggleInputPolicy(uint32_t flags);
     virtual bool IsStarted();
     static OpenGLX_Hook* Inst();
     virtual std::string GetLibraryName() const;
     void LoadFunctions(decltype(::glXSwapBuffers)* pfnglXSwapBuffers);
 
-    virtual std::weak_ptr<uint64_t> CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
-    virtual void ReleaseImageResource(std::weak_ptr<uint64_t> resource);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride = 0, ingame_overlay::AlphaMode alpha_mode = ingame_overlay::AlphaMode::Straight);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options);
+    virtual ingame_overlay::ImageResourceHandle CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format);
+    virtual void ReleaseImageResource(ingame_overlay::ImageResourceHandle resource);
+    virtual bool UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride = 0);
+    virtual void* GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource);
+    virtual bool BeginSdfDraw(void* imgui_draw_list);
+    virtual void EndSdfDraw(void* imgui_draw_list);
 };
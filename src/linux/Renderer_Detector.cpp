@@ -25,7 +25,6 @@
 #include <System/String.hpp>
 #include <System/System.h>
 #include <System/Library.h>
-#include <System/ScopedLock.hpp>
 #include <mini_detour/mini_detour.h>
 
 #define GLAD_GL_IMPLEMENTATION
@@ -34,8 +33,10 @@
 #define RENDERERDETECTOR_OS_LINUX
 
 #include "OpenGLX_Hook.h"
+#include "../Renderer_Detection_Service.h"
 
-class Renderer_Detector
+class Renderer_Detector :
+    public Renderer_Detection_Service
 {
     static Renderer_Detector* instance;
 public:
@@ -50,7 +51,7 @@ public:
 
     ~Renderer_Detector()
     {
-        stop_detection();
+        _Shutdown();
 
         delete openglx_hook;
         //delete vulkan_hook;
@@ -59,17 +60,12 @@ public:
     }
 
 private:
-    std::timed_mutex detector_mutex;
     std::mutex renderer_mutex;
 
     Base_Hook detection_hooks;
     ingame_overlay::Renderer_Hook* renderer_hook;
 
     bool detection_done;
-    uint32_t detection_count;
-    bool detection_cancelled;
-    std::condition_variable stop_detection_cv;
-    std::mutex stop_detection_mutex;
 
     decltype(::glXSwapBuffers)* glXSwapBuffers;
 
@@ -84,9 +80,7 @@ private:
         renderer_hook(nullptr),
         openglx_hook(nullptr),
         //vulkan_hook(nullptr),
-        detection_done(false),
-        detection_count(0),
-        detection_cancelled(false)
+        detection_done(false)
     {}
 
     std::string FindPreferedModulePath(std::string const& name)
@@ -168,125 +162,61 @@ private:
         //delete vulkan_hook; vulkan_hook = nullptr;
     }
 
-public:
-    std::future<ingame_overlay::Renderer_Hook*> detect_renderer(std::chrono::milliseconds timeout)
+    virtual bool _BeginProbe(ingame_overlay::Renderer_Hook*& renderer)
     {
-        std::lock_guard<std::mutex> lk(stop_detection_mutex);
-
-        if (detection_count == 0)
-        {// If we have no detections in progress, restart detection.
-            detection_cancelled = false;
-        }
+        std::lock_guard<std::mutex> lk(renderer_mutex);
 
-        ++detection_count;
-
-        return std::async(std::launch::async, [this, timeout]() -> ingame_overlay::Renderer_Hook*
+        if (detection_done)
         {
-            std::unique_lock<std::timed_mutex> detection_lock(detector_mutex, std::defer_lock);
-            constexpr std::chrono::milliseconds infinite_timeout{ -1 };
-        
-            if (!detection_lock.try_lock_for(timeout))
-            {
-                --detection_count;
-                return nullptr;
+            if (renderer_hook == nullptr)
+            {// Renderer detection was run but we didn't find it, restart the detection
+                detection_done = false;
             }
-
-            bool cancel = false;
-            {
-                System::scoped_lock lk(renderer_mutex, stop_detection_mutex);
-
-                if (!detection_cancelled)
-                {
-                    if (detection_done)
-                    {
-                        if (renderer_hook == nullptr)
-                        {// Renderer detection was run but we didn't find it, restart the detection
-                            detection_done = false;
-                        }
-                        else
-                        {// Renderer already detected, cancel detection and return the renderer.
-                            cancel = true;
-                        }
-                    }
-
-                    if (!EnterDetection())
-                        cancel = true;
-                }
-                else
-                {// Detection was cancelled, cancel this detection
-                    cancel = true;
-                }
+            else
+            {// Renderer already detected, return it.
+                renderer = renderer_hook;
+                return false;
             }
+        }
 
-            if (cancel)
-            {
-                --detection_count;
-                stop_detection_cv.notify_all();
-                return renderer_hook;
-            }
+        renderer = renderer_hook;
+        return EnterDetection();
+    }
 
-            SPDLOG_TRACE("Started renderer detection.");
+    virtual bool _ProbeStep()
+    {
+        std::pair<std::string, void(Renderer_Detector::*)(std::string const&)> libraries[]{
+            { OpenGLX_Hook::DLL_NAME, &Renderer_Detector::hook_openglx },
+        };
 
-            std::pair<std::string, void(Renderer_Detector::*)(std::string const&)> libraries[]{
-                { OpenGLX_Hook::DLL_NAME, &Renderer_Detector::hook_openglx },
-            };
-            std::string name;
+        {
+            std::lock_guard<std::mutex> lk(renderer_mutex);
+            if (detection_done)
+                return true;
+        }
 
-            auto start_time = std::chrono::steady_clock::now();
-            do
+        for (auto const& library : libraries)
+        {
+            std::string lib_path = FindPreferedModulePath(library.first);
+            if (!lib_path.empty())
             {
-                std::unique_lock<std::mutex> lck(stop_detection_mutex);
-                if (detection_cancelled || detection_done)
-                    break;
-
-                for (auto const& library : libraries)
+                void* lib_handle = System::Library::GetLibraryHandle(lib_path.c_str());
+                if (lib_handle != nullptr)
                 {
-                    std::string lib_path = FindPreferedModulePath(library.first);
-                    if (!lib_path.empty())
-                    {
-                        void* lib_handle = System::Library::GetLibraryHandle(lib_path.c_str());
-                        if (lib_handle != nullptr)
-                        {
-                            std::lock_guard<std::mutex> lk(renderer_mutex);
-                            (this->*library.second)(System::Library::GetLibraryPath(lib_handle));
-                        }
-                    }
+                    std::lock_guard<std::mutex> lk(renderer_mutex);
+                    (this->*library.second)(System::Library::GetLibraryPath(lib_handle));
                 }
-
-                stop_detection_cv.wait_for(lck, std::chrono::milliseconds{ 100 });
-            } while (timeout == infinite_timeout || (std::chrono::steady_clock::now() - start_time) <= timeout);
-
-            {
-                System::scoped_lock lk(renderer_mutex, stop_detection_mutex);
-                
-                ExitDetection();
-
-                --detection_count;
             }
-            stop_detection_cv.notify_all();
-
-            SPDLOG_TRACE("Renderer detection done {}.", (void*)renderer_hook);
+        }
 
-            return renderer_hook;
-        });
+        return false;
     }
 
-    void stop_detection()
+    virtual ingame_overlay::Renderer_Hook* _EndProbe()
     {
-        {
-            std::lock_guard<std::mutex> lk(stop_detection_mutex);
-            if (detection_count == 0)
-                return;
-        }
-        {
-            System::scoped_lock lk(renderer_mutex, stop_detection_mutex);
-            detection_cancelled = true;
-        }
-        stop_detection_cv.notify_all();
-        {
-            std::unique_lock<std::mutex> lk(stop_detection_mutex);
-            stop_detection_cv.wait(lk, [&]() { return detection_count == 0; });
-        }
+        std::lock_guard<std::mutex> lk(renderer_mutex);
+        ExitDetection();
+        return renderer_hook;
     }
 };
 
@@ -294,14 +224,22 @@ Renderer_Detector* Renderer_Detector::instance = nullptr;
 
 namespace ingame_overlay {
 
+void DetectRenderer(RendererDetectionCallback callback, std::chrono::milliseconds timeout)
+{
+    Renderer_Detector::Inst()->Detect(std::move(callback), timeout);
+}
+
 std::future<ingame_overlay::Renderer_Hook*> DetectRenderer(std::chrono::milliseconds timeout)
 {
-    return Renderer_Detector::Inst()->detect_renderer(timeout);
+    auto promise = std::make_shared<std::promise<ingame_overlay::Renderer_Hook*>>();
+    std::future<ingame_overlay::Renderer_Hook*> future = promise->get_future();
+    Renderer_Detector::Inst()->Detect([promise](ingame_overlay::Renderer_Hook* renderer) { promise->set_value(renderer); }, timeout);
+    return future;
 }
 
 void StopRendererDetection()
 {
-    Renderer_Detector::Inst()->stop_detection();
+    Renderer_Detector::Inst()->Stop();
 }
 
 void FreeDetector()
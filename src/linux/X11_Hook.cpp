@@ -26,6 +26,7 @@
 extern int ImGui_ImplX11_EventHandler(XEvent& event, XEvent* nextEvent);
 
 constexpr decltype(X11_Hook::DLL_NAME) X11_Hook::DLL_NAME;
+constexpr size_t X11_Hook::MaxQueuedEvents;
 
 X11_Hook* X11_Hook::_inst = nullptr;
 
@@ -149,23 +150,39 @@ bool X11_Hook::StartHook(std::function<void()>& _key_combination_callback, std::
 
 void X11_Hook::HideAppInputs(bool hide)
 {
-    _ApplicationInputsHidden = hide;
+    _InputPolicy.Set(ingame_overlay::InputPolicy_HideAppInputs, hide ? ingame_overlay::InputPolicy_HideAppInputs : 0);
 }
 
 void X11_Hook::HideOverlayInputs(bool hide)
 {
-    _OverlayInputsHidden = hide;
+    _InputPolicy.Set(ingame_overlay::InputPolicy_HideOverlayInputs, hide ? ingame_overlay::InputPolicy_HideOverlayInputs : 0);
+}
+
+uint32_t X11_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    return _InputPolicy.Set(mask, flags);
+}
+
+uint32_t X11_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    return _InputPolicy.Toggle(flags);
 }
 
 void X11_Hook::ResetRenderState()
 {
-    if (_Initialized)
+    auto it = _Windows.find(ImGui::GetCurrentContext());
+    if (it != _Windows.end())
     {
-        _GameWnd = 0;
-        _Initialized = false;
+        {
+            std::lock_guard<std::mutex> events_lock(_EventsMutex);
+            _QueuedEvents.erase(it->second);
+            _Windows.erase(it);
+        }
 
-        HideAppInputs(false);
-        HideOverlayInputs(true);
+        if (_Windows.empty())
+        {// The last overlay window is gone, give the inputs back to the game.
+            _InputPolicy.Set(ingame_overlay::InputPolicy_HideAppInputs | ingame_overlay::InputPolicy_HideOverlayInputs, ingame_overlay::InputPolicy_HideOverlayInputs);
+        }
 
         ImGui_ImplX11_Shutdown();
     }
@@ -188,13 +205,28 @@ bool X11_Hook::PrepareForOverlay(Display *display, Window wnd)
     if(!_Hooked)
         return false;
 
-    if (_GameWnd != wnd)
-        ResetRenderState();
+    ImGuiContext* context = ImGui::GetCurrentContext();
+    auto it = _Windows.find(context);
+    if (it != _Windows.end() && it->second != wnd)
+    {// The game switched drawables (fullscreen toggle, recreated window...), only the platform backend follows it.
+        // The inputs state is kept, so an open overlay stays open.
+        ImGui_ImplX11_Shutdown();
+        SetInitialWindowSize(display, wnd);
+        {
+            std::lock_guard<std::mutex> events_lock(_EventsMutex);
+            _QueuedEvents.erase(it->second);
+            _Windows.erase(it);
+        }
+        it = _Windows.end();
+    }
 
-    if (!_Initialized)
+    if (it == _Windows.end())
     {
         ImGui_ImplX11_Init(display, (void*)wnd);
-        _GameWnd = wnd;
+        {
+            std::lock_guard<std::mutex> events_lock(_EventsMutex);
+            _Windows[context] = wnd;
+        }
 
         //XSelectInput(display,
         //    wnd,
@@ -202,11 +234,11 @@ bool X11_Hook::PrepareForOverlay(Display *display, Window wnd)
         //    KeyPressMask | KeyReleaseMask |
         //    ButtonPressMask | ButtonReleaseMask |
         //    FocusChangeMask | ExposureMask);
-
-        _Initialized = true;
     }
 
-    if (!_OverlayInputsHidden)
+    _FeedQueuedEvents(wnd);
+
+    if (!_InputPolicy.OverlayInputsHidden())
     {
         ImGui_ImplX11_NewFrame();
     }
@@ -233,20 +265,86 @@ bool IgnoreEvent(XEvent &event)
     return false;
 }
 
+bool X11_Hook::_HasOverlay(Window wnd) const
+{
+    for (auto const& item : _Windows)
+    {
+        if (item.second == wnd)
+            return true;
+    }
+
+    return false;
+}
+
+void X11_Hook::_QueueEvent(XEvent const& event, XEvent const* next_event, bool hide_overlay_inputs)
+{
+    // Focus changes always go through, so the overlay knows when it gets the inputs back.
+    if (hide_overlay_inputs && event.type != FocusIn && event.type != FocusOut)
+        return;
+
+    std::lock_guard<std::mutex> lock(_EventsMutex);
+    // Windows without an overlay, like a launcher next to the game window, don't feed any ImGui context.
+    if (!_HasOverlay(event.xany.window))
+        return;
+
+    std::vector<QueuedEvent_t>& events = _QueuedEvents[event.xany.window];
+    if (events.size() >= MaxQueuedEvents)
+        return;
+
+    events.emplace_back();
+    QueuedEvent_t& queued = events.back();
+    queued.Event = event;
+    queued.HasNextEvent = next_event != nullptr;
+    if (next_event != nullptr)
+        queued.NextEvent = *next_event;
+}
+
+void X11_Hook::_FeedQueuedEvents(Window wnd)
+{
+    _DrainedEvents.clear();
+    {
+        std::lock_guard<std::mutex> lock(_EventsMutex);
+        auto it = _QueuedEvents.find(wnd);
+        if (it == _QueuedEvents.end() || it->second.empty())
+            return;
+
+        // Both vectors keep their storage, the next frames don't allocate.
+        it->second.swap(_DrainedEvents);
+    }
+
+    for (auto& queued : _DrainedEvents)
+    {
+        if (queued.Event.type == FocusIn || queued.Event.type == FocusOut)
+        {
+            ImGui::GetIO().SetAppAcceptingEvents(queued.Event.type == FocusIn);
+        }
+
+        ImGui_ImplX11_EventHandler(queued.Event, queued.HasNextEvent ? &queued.NextEvent : nullptr);
+    }
+}
+
 int X11_Hook::_CheckForOverlay(Display *d, int num_events)
 {
     X11_Hook* inst = Inst();
 
     char szKey[32];
 
-    if( _Initialized )
+    bool has_overlay;
+    {
+        std::lock_guard<std::mutex> lock(_EventsMutex);
+        has_overlay = !_Windows.empty();
+    }
+
+    if( has_overlay )
     {
         XEvent event, nextEvent;
         XEvent* pNextEvent;
         while(num_events)
         {
-            bool hide_app_inputs = inst->_ApplicationInputsHidden;
-            bool hide_overlay_inputs = inst->_OverlayInputsHidden;
+            // One load, both flags come from the same policy change.
+            const uint32_t policy = inst->_InputPolicy.Load();
+            bool hide_app_inputs = (policy & ingame_overlay::InputPolicy_HideAppInputs) != 0;
+            bool hide_overlay_inputs = (policy & ingame_overlay::InputPolicy_HideOverlayInputs) != 0;
 
             XPeekEvent(d, &event);
 
@@ -277,34 +375,29 @@ int X11_Hook::_CheckForOverlay(Display *d, int num_events)
 
                 if (key_count == inst->_NativeKeyCombination.size())
                 {// All shortcut keys are pressed
-                    if (!inst->_KeyCombinationPushed)
+                    if (!inst->_KeyCombinationPushed.load(std::memory_order_relaxed))
                     {
                         inst->_KeyCombinationCallback();
 
-                        if (inst->_OverlayInputsHidden)
+                        // The callback usually changes the policy, the key press that opened the overlay must not reach the game.
+                        const uint32_t new_policy = inst->_InputPolicy.Load();
+                        if (new_policy & ingame_overlay::InputPolicy_HideOverlayInputs)
                             hide_overlay_inputs = true;
 
-                        if (inst->_ApplicationInputsHidden)
+                        if (new_policy & ingame_overlay::InputPolicy_HideAppInputs)
                             hide_app_inputs = true;
 
-                        inst->_KeyCombinationPushed = true;
+                        inst->_KeyCombinationPushed.store(true, std::memory_order_relaxed);
                     }
                 }
                 else
                 {
-                    inst->_KeyCombinationPushed = false;
+                    inst->_KeyCombinationPushed.store(false, std::memory_order_relaxed);
                 }
             }
 
-            if (event.type == FocusIn || event.type == FocusOut)
-            {
-                ImGui::GetIO().SetAppAcceptingEvents(event.type == FocusIn);
-            }
-
-            if (!hide_overlay_inputs || event.type == FocusIn || event.type == FocusOut)
-            {
-                ImGui_ImplX11_EventHandler(event, pNextEvent);
-            }
+            // The ImGui contexts belong to the render threads, the events wait for their next frame.
+            _QueueEvent(event, pNextEvent, hide_overlay_inputs);
 
             if (!hide_app_inputs || !IgnoreEvent(event))
             {
@@ -349,12 +442,9 @@ int X11_Hook::MyXPending(Display* display)
 /////////////////////////////////////////////////////////////////////////////////////
 
 X11_Hook::X11_Hook() :
-    _Initialized(false),
     _Hooked(false),
-    _GameWnd(0),
     _KeyCombinationPushed(false),
-    _ApplicationInputsHidden(false),
-    _OverlayInputsHidden(true),
+    _InputPolicy(ingame_overlay::InputPolicy_HideOverlayInputs),
     XEventsQueued(nullptr),
     XPending(nullptr)
 {
@@ -364,7 +454,16 @@ X11_Hook::~X11_Hook()
 {
     SPDLOG_INFO("X11 Hook removed");
 
-    ResetRenderState();
+    {
+        std::lock_guard<std::recursive_mutex> lock(_ImGuiMutex);
+        ImGuiContext* previous_context = ImGui::GetCurrentContext();
+        while (!_Windows.empty())
+        {
+            ImGui::SetCurrentContext(_Windows.begin()->first);
+            ResetRenderState();
+        }
+        ImGui::SetCurrentContext(previous_context);
+    }
 
     _inst = nullptr;
 }
@@ -22,11 +22,18 @@
 #include <ingame_overlay/Renderer_Hook.h>
 
 #include "../internal_includes.h"
+#include "../Input_Policy.h"
 
 #include <X11/X.h> // XEvent types
 #include <X11/Xlib.h> // XEvent structure
 #include <X11/Xutil.h> // XEvent keysym
 
+#include <map>
+#include <mutex>
+#include <vector>
+
+struct ImGuiContext;
+
 class X11_Hook :
     public Base_Hook
 {
@@ -36,22 +43,45 @@ public:
 private:
     static X11_Hook* _inst;
 
+    // Event read by the game, fed to the ImGui context of its window by the next PrepareForOverlay.
+    struct QueuedEvent_t
+    {
+        XEvent Event;
+        // The event that followed a KeyRelease, the backend uses it to detect key repeats.
+        XEvent NextEvent;
+        bool HasNextEvent;
+    };
+
+    // Events beyond this are dropped, for windows that stopped drawing their overlay.
+    static constexpr size_t MaxQueuedEvents = 1024;
+
     // Variables
     bool _Hooked;
-    bool _Initialized;
-    Window _GameWnd;
+    // Window of each ImGui context the overlay is drawn with, events are routed to the context of their window.
+    // Written with both mutexes held, read with either.
+    std::map<ImGuiContext*, Window> _Windows;
+    // Held while an ImGui context is current, renderers draw from their own threads.
+    std::recursive_mutex _ImGuiMutex;
+    // Guards _QueuedEvents, the game's event loop only ever waits on it.
+    std::mutex _EventsMutex;
+    std::map<Window, std::vector<QueuedEvent_t>> _QueuedEvents;
+    // Only used by PrepareForOverlay, so the queues are swapped out instead of copied.
+    std::vector<QueuedEvent_t> _DrainedEvents;
 
     // In (bool): Is toggle wanted
     // Out(bool): Is the overlay visible, if true, inputs will be disabled
     std::function<void()> _KeyCombinationCallback;
     std::set<uint32_t> _NativeKeyCombination;
-    bool _KeyCombinationPushed;
-    bool _ApplicationInputsHidden;
-    bool _OverlayInputsHidden;
+    // Only written by the input thread, atomic so a policy change made from the key combination callback is ordered with it.
+    std::atomic<bool> _KeyCombinationPushed;
+    Input_Policy _InputPolicy;
 
     // Functions
     X11_Hook();
     int _CheckForOverlay(Display *d, int num_events);
+    bool _HasOverlay(Window wnd) const;
+    void _QueueEvent(XEvent const& event, XEvent const* next_event, bool hide_overlay_inputs);
+    void _FeedQueuedEvents(Window wnd);
 
     // Hook to X11 window messages
     decltype(::XEventsQueued)* XEventsQueued;
@@ -65,15 +95,18 @@ public:
 
     virtual ~X11_Hook();
 
+    // Those act on the current ImGui context, call them with GetImGuiMutex held.
     void ResetRenderState();
     void SetInitialWindowSize(Display* display, Window wnd);
     bool PrepareForOverlay(Display *display, Window wnd);
 
-    Window GetGameWnd() const{ return _GameWnd; }
+    std::recursive_mutex& GetImGuiMutex() { return _ImGuiMutex; }
 
     bool StartHook(std::function<void()>& key_combination_callback, std::set<ingame_overlay::ToggleKey> const& toggle_keys);
     void HideAppInputs(bool hide);
     void HideOverlayInputs(bool hide);
+    uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    uint32_t ToggleInputPolicy(uint32_t flags);
     static X11_Hook* Inst();
     virtual std::string GetLibraryName() const;
 };
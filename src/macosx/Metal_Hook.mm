@@ -68,6 +68,22 @@ void Metal_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t Metal_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return NSView_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t Metal_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return NSView_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool Metal_Hook::IsStarted()
 {
     return _Hooked;
@@ -110,6 +126,8 @@ void Metal_Hook::_PrepareForOverlay(render_pass_t& render_pass)
         
         OverlayProc();
         
+        FrameScheduler.RunFrame();
+        
         ImGui::Render();
 
         ImGui_ImplMetal_RenderDrawData(ImGui::GetDrawData(), render_pass.command_buffer, render_pass.encoder);
@@ -204,18 +222,45 @@ void Metal_Hook::LoadFunctions(Method MTLCommandBufferRenderCommandEncoderWithDe
     _MTLRenderCommandEncoderEndEncodingMethod = RenderCommandEncoderEndEncoding;
 }
 
-std::weak_ptr<uint64_t> Metal_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle Metal_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
 {
-    return std::shared_ptr<uint64_t>();
+    return 0;
 }
 
-void Metal_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+ingame_overlay::ImageResourceHandle Metal_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle Metal_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle Metal_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
+{
+    return 0;
+}
+
+void Metal_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
+{
+}
+
+bool Metal_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    return false;
+}
+
+void* Metal_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    return nullptr;
+}
+
+bool Metal_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return false;
+}
+
+void Metal_Hook::EndSdfDraw(void* imgui_draw_list)
 {
-    auto ptr = resource.lock();
-    if (ptr)
-    {
-        auto it = _ImageResources.find(ptr);
-        if (it != _ImageResources.end())
-            _ImageResources.erase(it);
-    }
 }
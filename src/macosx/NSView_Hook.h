@@ -22,6 +22,7 @@
 #include <ingame_overlay/Renderer_Hook.h>
 
 #include "../internal_includes.h"
+#include "../Input_Policy.h"
 
 #import <Carbon/Carbon.h>
 #import <Foundation/Foundation.h>
@@ -57,9 +58,9 @@ private:
 public:
     std::function<void()> KeyCombinationCallback;
     std::set<int> NativeKeyCombination;
-    bool KeyCombinationPushed;
-    bool ApplicationInputsHidden;
-    bool OverlayInputsHidden;
+    // Only written by the input thread, atomic so a policy change made from the key combination callback is ordered with it.
+    std::atomic<bool> KeyCombinationPushed;
+    Input_Policy InputPolicy;
 
     std::string LibraryName;
 
@@ -71,6 +72,8 @@ public:
     bool StartHook(std::function<void()>& key_combination_callback, std::set<ingame_overlay::ToggleKey> const& toggle_keys);
     void HideAppInputs(bool hide);
     void HideOverlayInputs(bool hide);
+    uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    uint32_t ToggleInputPolicy(uint32_t flags);
     static NSView_Hook* Inst();
     virtual std::string GetLibraryName() const;
 
@@ -165,8 +165,10 @@ bool NSView_Hook::StartHook(std::function<void()>& _key_combination_callback, st
         {
             auto* inst = NSView_Hook::Inst();
             NSView* view = [[event window]contentView];
-            bool hide_app_inputs = inst->ApplicationInputsHidden;
-            bool hide_overlay_inputs = inst->OverlayInputsHidden;
+            // One load, both flags come from the same policy change.
+            const uint32_t policy = inst->InputPolicy.Load();
+            bool hide_app_inputs = (policy & ingame_overlay::InputPolicy_HideAppInputs) != 0;
+            bool hide_overlay_inputs = (policy & ingame_overlay::InputPolicy_HideOverlayInputs) != 0;
     
             switch ([event type])
             {
@@ -184,14 +186,16 @@ bool NSView_Hook::StartHook(std::function<void()>& _key_combination_callback, st
     
                         if (key_count == inst->NativeKeyCombination.size())
                         {// All shortcut keys are pressed
-                            if (!inst->KeyCombinationPushed)
+                            if (!inst->KeyCombinationPushed.load(std::memory_order_relaxed))
                             {
                                 inst->KeyCombinationCallback();
-    
-                                if (inst->OverlayInputsHidden)
+
+                                // The callback usually changes the policy, the key press that opened the overlay must not reach the game.
+                                const uint32_t new_policy = inst->InputPolicy.Load();
+                                if (new_policy & ingame_overlay::InputPolicy_HideOverlayInputs)
                                     hide_overlay_inputs = true;
 
-                                if(inst->ApplicationInputsHidden)
+                                if (new_policy & ingame_overlay::InputPolicy_HideAppInputs)
                                 {
                                     hide_app_inputs = true;
     
@@ -199,12 +203,12 @@ bool NSView_Hook::StartHook(std::function<void()>& _key_combination_callback, st
                                     // so we can spoof the mouseLocation return value.
                                     inst->_SavedLocation = mouseLocation(event, @selector(mouseLocation));
                                 }
-                                inst->KeyCombinationPushed = true;
+                                inst->KeyCombinationPushed.store(true, std::memory_order_relaxed);
                             }
                         }
                         else
                         {
-                            inst->KeyCombinationPushed = false;
+                            inst->KeyCombinationPushed.store(false, std::memory_order_relaxed);
                         }
                     }
                 }
@@ -229,12 +233,22 @@ bool NSView_Hook::StartHook(std::function<void()>& _key_combination_callback, st
 
 void NSView_Hook::HideAppInputs(bool hide)
 {
-    ApplicationInputsHidden = hide;
+    InputPolicy.Set(ingame_overlay::InputPolicy_HideAppInputs, hide ? ingame_overlay::InputPolicy_HideAppInputs : 0);
 }
 
 void NSView_Hook::HideOverlayInputs(bool hide)
 {
-    OverlayInputsHidden = hide;
+    InputPolicy.Set(ingame_overlay::InputPolicy_HideOverlayInputs, hide ? ingame_overlay::InputPolicy_HideOverlayInputs : 0);
+}
+
+uint32_t NSView_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    return InputPolicy.Set(mask, flags);
+}
+
+uint32_t NSView_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    return InputPolicy.Toggle(flags);
 }
 
 void NSView_Hook::ResetRenderState()
@@ -278,7 +292,7 @@ bool NSView_Hook::PrepareForOverlay()
 NSPoint NSView_Hook::MymouseLocation(id self, SEL sel)
 {
     NSView_Hook* inst = NSView_Hook::Inst();
-    if (inst->ApplicationInputsHidden)
+    if (inst->InputPolicy.AppInputsHidden())
         return inst->_SavedLocation;
 
     return inst->mouseLocation(self, sel);
@@ -287,7 +301,7 @@ NSPoint NSView_Hook::MymouseLocation(id self, SEL sel)
 NSInteger NSView_Hook::MypressedMouseButtons(id self, SEL sel)
 {
     NSView_Hook* inst = NSView_Hook::Inst();
-    if (inst->ApplicationInputsHidden)
+    if (inst->InputPolicy.AppInputsHidden())
         return 0;
 
     return inst->pressedMouseButtons(self, sel);
@@ -306,8 +320,7 @@ NSView_Hook::NSView_Hook() :
     pressedMouseButtons(nullptr),
     mouseLocation(nullptr),
     KeyCombinationPushed(false),
-    ApplicationInputsHidden(false),
-    OverlayInputsHidden(true)
+    InputPolicy(ingame_overlay::InputPolicy_HideOverlayInputs)
 {
 }
 
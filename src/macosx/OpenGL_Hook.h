@@ -20,6 +20,7 @@
 #pragma once
 
 #include <ingame_overlay/Renderer_Hook.h>
+#include <ingame_overlay/Slot_Map.h>
 
 #include "../internal_includes.h"
 
@@ -41,7 +42,10 @@ private:
     // Variables
     bool _Hooked;
     bool _Initialized;
-    std::set<std::shared_ptr<uint64_t>> _ImageResources;
+    // GL texture names
+    ingame_overlay::Slot_Map<uint32_t> _ImageResources;
+    // Pixel unpack buffer used to stream UpdateImageResource uploads.
+    uint32_t _ImageUploadBuffer;
     void* _ImGuiFontAtlas;
 
     // Functions
@@ -63,11 +67,20 @@ public:
     virtual bool StartHook(std::function<void()> key_combination_callback, std::set<ingame_overlay::ToggleKey> toggle_keys, /*ImFontAtlas* */ void* imgui_font_atlas = nullptr);
     virtual void HideAppInputs(bool hide);
     virtual void HideOverlayInputs(bool hide);
+    virtual uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    virtual uint32_t ToggleInputPolicy(uint32_t flags);
     virtual bool IsStarted();
     static OpenGL_Hook* Inst();
     virtual std::string GetLibraryName() const;
     void LoadFunctions(decltype(::CGLFlushDrawable)* pfnCGLFlushDrawable);
 
-    virtual std::weak_ptr<uint64_t> CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
-    virtual void ReleaseImageResource(std::weak_ptr<uint64_t> resource);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride = 0, ingame_overlay::AlphaMode alpha_mode = ingame_overlay::AlphaMode::Straight);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options);
+    virtual ingame_overlay::ImageResourceHandle CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format);
+    virtual void ReleaseImageResource(ingame_overlay::ImageResourceHandle resource);
+    virtual bool UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride = 0);
+    virtual void* GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource);
+    virtual bool BeginSdfDraw(void* imgui_draw_list);
+    virtual void EndSdfDraw(void* imgui_draw_list);
 };
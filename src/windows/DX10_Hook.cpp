@@ -19,6 +19,10 @@
 
 #include "DX10_Hook.h"
 #include "Windows_Hook.h"
+#include "../Pixel_Convert.h"
+#include "../Texture_Decompress.h"
+
+#include <algorithm>
 
 #include <imgui.h>
 #include <backends/imgui_impl_dx10.h>
@@ -88,6 +92,22 @@ void DX10_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t DX10_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t DX10_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool DX10_Hook::IsStarted()
 {
     return _Hooked;
@@ -110,29 +130,49 @@ void DX10_Hook::_ResetRenderState()
     }
 }
 
+void DX10_Hook::_ReleaseRenderTargets()
+{
+    SafeRelease(mainRenderTargetView);
+}
+
+bool DX10_Hook::_CreateRenderTargets(IDXGISwapChain* pSwapChain)
+{
+    ID3D10Texture2D* pBackBuffer = nullptr;
+    if (FAILED(pSwapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer))) || pBackBuffer == nullptr)
+        return false;
+
+    pDevice->CreateRenderTargetView(pBackBuffer, nullptr, &mainRenderTargetView);
+    pBackBuffer->Release();
+
+    return mainRenderTargetView != nullptr;
+}
+
 // Try to make this function and overlay's proc as short as possible or it might affect game's fps.
 void DX10_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain)
 {
     DXGI_SWAP_CHAIN_DESC desc;
     pSwapChain->GetDesc(&desc);
 
+    if (_Initialized && mainRenderTargetView == nullptr)
+    {// ResizeBuffers released the render target, everything else survives unless the device changed.
+        ID3D10Device* pSwapChainDevice = nullptr;
+        if (FAILED(pSwapChain->GetDevice(IID_PPV_ARGS(&pSwapChainDevice))) || pSwapChainDevice != pDevice)
+            _ResetRenderState();
+
+        SafeRelease(pSwapChainDevice);
+    }
+
     if (!_Initialized)
     {
         if (FAILED(pSwapChain->GetDevice(IID_PPV_ARGS(&pDevice))))
             return;
 
-        ID3D10Texture2D* pBackBuffer = nullptr;
-
-        pSwapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer));
-        if (pBackBuffer == nullptr)
+        if (!_CreateRenderTargets(pSwapChain))
         {
-            pDevice->Release();
+            SafeRelease(pDevice);
             return;
         }
 
-        pDevice->CreateRenderTargetView(pBackBuffer, nullptr, &mainRenderTargetView);
-        pBackBuffer->Release();
-
         ImGui::CreateContext(reinterpret_cast<ImFontAtlas*>(_ImGuiFontAtlas));
         ImGui_ImplDX10_Init(pDevice);
 
@@ -141,6 +181,13 @@ void DX10_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain)
         _Initialized = true;
         OverlayHookReady(true);
     }
+    else if (mainRenderTargetView == nullptr)
+    {
+        if (!_CreateRenderTargets(pSwapChain))
+            return;
+
+        Windows_Hook::Inst()->SetInitialWindowSize(desc.OutputWindow);
+    }
 
     if (ImGui_ImplDX10_NewFrame() && Windows_Hook::Inst()->PrepareForOverlay(desc.OutputWindow))
     {
@@ -148,6 +195,8 @@ void DX10_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain)
 
         OverlayProc();
 
+        FrameScheduler.RunFrame();
+
         ImGui::Render();
 
         pDevice->OMSetRenderTargets(1, &mainRenderTargetView, nullptr);
@@ -165,14 +214,15 @@ HRESULT STDMETHODCALLTYPE DX10_Hook::MyPresent(IDXGISwapChain *_this, UINT SyncI
 HRESULT STDMETHODCALLTYPE DX10_Hook::MyResizeTarget(IDXGISwapChain* _this, const DXGI_MODE_DESC* pNewTargetParameters)
 {
     auto inst= DX10_Hook::Inst();
-    inst->_ResetRenderState();
+    // The buffers are left alone, ResizeBuffers follows when the game wants them resized.
     return (_this->*inst->ResizeTarget)(pNewTargetParameters);
 }
 
 HRESULT STDMETHODCALLTYPE DX10_Hook::MyResizeBuffers(IDXGISwapChain* _this, UINT BufferCount, UINT Width, UINT Height, DXGI_FORMAT NewFormat, UINT SwapChainFlags)
 {
     auto inst= DX10_Hook::Inst();
-    inst->_ResetRenderState();
+    // ResizeBuffers fails while the back buffer is referenced, only its view is released and recreated on the next Present.
+    inst->_ReleaseRenderTargets();
     return (_this->*inst->ResizeBuffers)(BufferCount, Width, Height, NewFormat, SwapChainFlags);
 }
 
@@ -204,9 +254,14 @@ DX10_Hook::~DX10_Hook()
     if (_WindowsHooked)
         delete Windows_Hook::Inst();
 
+    _ImageResources.ForEach([](ingame_overlay::ImageResourceHandle, ID3D10ShaderResourceView*& pResource)
+    {
+        pResource->Release();
+    });
+
     if (_Initialized)
     {
-        mainRenderTargetView->Release();
+        SafeRelease(mainRenderTargetView);
 
         ImGui_ImplDX10_InvalidateDeviceObjects();
         ImGui::DestroyContext();
@@ -242,15 +297,31 @@ void DX10_Hook::LoadFunctions(
     Present1 = Present1Fcn;
 }
 
-std::weak_ptr<uint64_t> DX10_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle DX10_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
 {
-    ID3D10ShaderResourceView** resource = new ID3D10ShaderResourceView*(nullptr);
+    return CreateImageResource(image_data, width, height, ingame_overlay::ImageResourceOptions());
+}
+
+ingame_overlay::ImageResourceHandle DX10_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    if (image_data == nullptr || width == 0 || height == 0)
+        return 0;
+
+    std::vector<uint8_t> fitted;
+    if (ingame_overlay::Pixel_Convert::Fit(reinterpret_cast<const uint8_t*>(image_data), width, height, options.MaxSize, options.MaxSize, fitted, width, height))
+        image_data = fitted.data();
+
+    std::vector<std::vector<uint8_t>> levels;
+    if (options.Mipmaps)
+        ingame_overlay::Pixel_Convert::BuildMipChain(reinterpret_cast<const uint8_t*>(image_data), width, height, levels);
+
+    ID3D10ShaderResourceView* resource = nullptr;
 
     // Create texture
     D3D10_TEXTURE2D_DESC desc = {};
     desc.Width = static_cast<UINT>(width);
     desc.Height = static_cast<UINT>(height);
-    desc.MipLevels = 1;
+    desc.MipLevels = static_cast<UINT>(levels.size() + 1);
     desc.ArraySize = 1;
     desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     desc.SampleDesc.Count = 1;
@@ -258,12 +329,17 @@ std::weak_ptr<uint64_t> DX10_Hook::CreateImageResource(const void* image_data, u
     desc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
     desc.CPUAccessFlags = 0;
 
+    // One subresource per mip level, the ImGui sampler already filters between them.
+    std::vector<D3D10_SUBRESOURCE_DATA> subResources(desc.MipLevels);
+    for (UINT i = 0; i < desc.MipLevels; ++i)
+    {
+        subResources[i].pSysMem = i == 0 ? image_data : levels[i - 1].data();
+        subResources[i].SysMemPitch = std::max<UINT>(1, desc.Width >> i) * 4;
+        subResources[i].SysMemSlicePitch = 0;
+    }
+
     ID3D10Texture2D* pTexture = nullptr;
-    D3D10_SUBRESOURCE_DATA subResource;
-    subResource.pSysMem = image_data;
-    subResource.SysMemPitch = desc.Width * 4;
-    subResource.SysMemSlicePitch = 0;
-    pDevice->CreateTexture2D(&desc, &subResource, &pTexture);
+    pDevice->CreateTexture2D(&desc, subResources.data(), &pTexture);
 
     if (pTexture != nullptr)
     {
@@ -274,36 +350,152 @@ std::weak_ptr<uint64_t> DX10_Hook::CreateImageResource(const void* image_data, u
         srvDesc.Texture2D.MipLevels = desc.MipLevels;
         srvDesc.Texture2D.MostDetailedMip = 0;
 
-        pDevice->CreateShaderResourceView(pTexture, &srvDesc, resource);
+        pDevice->CreateShaderResourceView(pTexture, &srvDesc, &resource);
         // Release Texure, the shader resource increases the reference count.
         pTexture->Release();
     }
 
-    if (*resource == nullptr)
-        return std::shared_ptr<uint64_t>();
+    if (resource == nullptr)
+        return 0;
 
-    auto ptr = std::shared_ptr<uint64_t>((uint64_t*)resource, [](uint64_t* handle)
+    return _ImageResources.Insert(resource);
+}
+
+ingame_overlay::ImageResourceHandle DX10_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Pixel_Convert::ToRGBA(image_data, width, height, format, stride, alpha_mode, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
+}
+
+ingame_overlay::ImageResourceHandle DX10_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
+{
+    const size_t expected_size = ingame_overlay::Texture_Decompress::CompressedSize(format, width, height);
+    if (compressed_data == nullptr || width == 0 || height == 0 || expected_size == 0 || compressed_size < expected_size)
+        return 0;
+
+    DXGI_FORMAT dxgi_format = DXGI_FORMAT_UNKNOWN;
+    switch (format)
     {
-        if (handle != nullptr)
-        {
-            ID3D10ShaderResourceView** resource = reinterpret_cast<ID3D10ShaderResourceView**>(handle);
-            (*resource)->Release();
-            delete resource;
-        }
-    });
+        case ingame_overlay::CompressedFormat::BC1: dxgi_format = DXGI_FORMAT_BC1_UNORM; break;
+        case ingame_overlay::CompressedFormat::BC2: dxgi_format = DXGI_FORMAT_BC2_UNORM; break;
+        case ingame_overlay::CompressedFormat::BC3: dxgi_format = DXGI_FORMAT_BC3_UNORM; break;
+        case ingame_overlay::CompressedFormat::BC4: dxgi_format = DXGI_FORMAT_BC4_UNORM; break;
+        case ingame_overlay::CompressedFormat::BC5: dxgi_format = DXGI_FORMAT_BC5_UNORM; break;
+        // No ETC2 support in Direct3D.
+        default: break;
+    }
+
+    // Direct3D wants the top level of a block compressed texture to be made of whole blocks.
+    if (dxgi_format == DXGI_FORMAT_UNKNOWN || (width % 4) != 0 || (height % 4) != 0)
+    {
+        std::vector<uint8_t> rgba;
+        if (!ingame_overlay::Texture_Decompress::ToRGBA(compressed_data, compressed_size, width, height, format, rgba))
+            return 0;
 
-    _ImageResources.emplace(ptr);
+        return CreateImageResource(rgba.data(), width, height);
+    }
+
+    ID3D10ShaderResourceView* resource = nullptr;
 
-    return ptr;
+    D3D10_TEXTURE2D_DESC desc = {};
+    desc.Width = static_cast<UINT>(width);
+    desc.Height = static_cast<UINT>(height);
+    desc.MipLevels = 1;
+    desc.ArraySize = 1;
+    desc.Format = dxgi_format;
+    desc.SampleDesc.Count = 1;
+    desc.Usage = D3D10_USAGE_DEFAULT;
+    desc.BindFlags = D3D10_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+
+    ID3D10Texture2D* pTexture = nullptr;
+    D3D10_SUBRESOURCE_DATA subResource;
+    subResource.pSysMem = compressed_data;
+    // The pitch of a row of blocks.
+    subResource.SysMemPitch = (desc.Width / 4) * ingame_overlay::Texture_Decompress::BlockSize(format);
+    subResource.SysMemSlicePitch = 0;
+    pDevice->CreateTexture2D(&desc, &subResource, &pTexture);
+
+    if (pTexture != nullptr)
+    {
+        D3D10_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+        srvDesc.Format = dxgi_format;
+        srvDesc.ViewDimension = D3D10_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = desc.MipLevels;
+        srvDesc.Texture2D.MostDetailedMip = 0;
+
+        pDevice->CreateShaderResourceView(pTexture, &srvDesc, &resource);
+        pTexture->Release();
+    }
+
+    if (resource == nullptr)
+        return 0;
+
+    return _ImageResources.Insert(resource);
+}
+
+void DX10_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
+{
+    ID3D10ShaderResourceView* pView;
+    if (_ImageResources.Remove(resource, pView))
+        pView->Release();
 }
 
-void DX10_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+bool DX10_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
 {
-    auto ptr = resource.lock();
-    if (ptr)
+    ID3D10ShaderResourceView** pView = _ImageResources.Get(resource);
+    if (pView == nullptr || pDevice == nullptr || image_data == nullptr || width == 0 || height == 0)
+        return false;
+
+    if (stride == 0)
+        stride = width * 4;
+
+    if (stride < width * 4)
+        return false;
+
+    ID3D10Resource* pTexture = nullptr;
+    (*pView)->GetResource(&pTexture);
+    if (pTexture == nullptr)
+        return false;
+
+    // UpdateSubresource doesn't check the box against the texture, image resources are all 2D textures.
+    // The block compressed ones can't take RGBA rows.
+    D3D10_TEXTURE2D_DESC desc;
+    static_cast<ID3D10Texture2D*>(pTexture)->GetDesc(&desc);
+    if (desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM || x >= desc.Width || y >= desc.Height || width > desc.Width - x || height > desc.Height - y)
     {
-        auto it = _ImageResources.find(ptr);
-        if (it != _ImageResources.end())
-            _ImageResources.erase(it);
+        pTexture->Release();
+        return false;
     }
-}
\ No newline at end of file
+
+    D3D10_BOX box;
+    box.left = static_cast<UINT>(x);
+    box.top = static_cast<UINT>(y);
+    box.front = 0;
+    box.right = static_cast<UINT>(x + width);
+    box.bottom = static_cast<UINT>(y + height);
+    box.back = 1;
+
+    pDevice->UpdateSubresource(pTexture, 0, &box, image_data, static_cast<UINT>(stride), 0);
+    pTexture->Release();
+
+    return true;
+}
+
+void* DX10_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    ID3D10ShaderResourceView** pView = _ImageResources.Get(resource);
+    return pView == nullptr ? nullptr : *pView;
+}
+
+bool DX10_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return false;
+}
+
+void DX10_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+}
@@ -20,6 +20,7 @@
 #pragma once
 
 #include <ingame_overlay/Renderer_Hook.h>
+#include <ingame_overlay/Slot_Map.h>
 
 #include "../internal_includes.h"
 
@@ -43,13 +44,15 @@ private:
     ID3D11Device* pDevice;
     ID3D11DeviceContext* pContext;
     ID3D11RenderTargetView* mainRenderTargetView;
-    std::set<std::shared_ptr<uint64_t>> _ImageResources;
+    ingame_overlay::Slot_Map<ID3D11ShaderResourceView*> _ImageResources;
     void* _ImGuiFontAtlas;
 
     // Functions
     DX11_Hook();
 
     void _ResetRenderState();
+    void _ReleaseRenderTargets();
+    bool _CreateRenderTargets(IDXGISwapChain* pSwapChain);
     void _PrepareForOverlay(IDXGISwapChain* pSwapChain);
 
     // Hook to render functions
@@ -71,6 +74,8 @@ public:
     virtual bool StartHook(std::function<void()> key_combination_callback, std::set<ingame_overlay::ToggleKey> toggle_keys, /*ImFontAtlas* */ void* imgui_font_atlas = nullptr);
     virtual void HideAppInputs(bool hide);
     virtual void HideOverlayInputs(bool hide);
+    virtual uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    virtual uint32_t ToggleInputPolicy(uint32_t flags);
     virtual bool IsStarted();
     static DX11_Hook* Inst();
     virtual std::string GetLibraryName() const;
@@ -81,6 +86,13 @@ public:
         decltype(ResizeTarget) ResizeTargetFcn,
         decltype(Present1) Present1Fcn);
 
-    virtual std::weak_ptr<uint64_t> CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
-    virtual void ReleaseImageResource(std::weak_ptr<uint64_t> resource);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride = 0, ingame_overlay::AlphaMode alpha_mode = ingame_overlay::AlphaMode::Straight);
+    virtual ingame_overlay::ImageResourceHandle CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options);
+    virtual ingame_overlay::ImageResourceHandle CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format);
+    virtual void ReleaseImageResource(ingame_overlay::ImageResourceHandle resource);
+    virtual bool UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride = 0);
+    virtual void* GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource);
+    virtual bool BeginSdfDraw(void* imgui_draw_list);
+    virtual void EndSdfDraw(void* imgui_draw_list);
 };
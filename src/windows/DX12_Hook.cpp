@@ -89,6 +89,22 @@ void DX12_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t DX12_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t DX12_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool DX12_Hook::IsStarted()
 {
     return _Hooked;
@@ -158,16 +174,81 @@ void DX12_Hook::_ResetRenderState()
         Windows_Hook::Inst()->ResetRenderState();
         ImGui::DestroyContext();
 
-        OverlayFrames.clear();
+        _ReleaseRenderTargets();
 
+        SafeRelease(pCmdList);
         SafeRelease(pSrvDescHeap);
-        SafeRelease(pRtvDescHeap);
         SafeRelease(pDevice);
 
+        _SwapChain = nullptr;
         _Initialized = false;
     }
 }
 
+void DX12_Hook::_ReleaseRenderTargets()
+{
+    OverlayFrames.clear();
+    SafeRelease(pRtvDescHeap);
+}
+
+bool DX12_Hook::_CreateRenderTargets(IDXGISwapChain3* pSwapChain3, UINT bufferCount)
+{
+    D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+    desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+    desc.NumDescriptors = bufferCount;
+    desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+    desc.NodeMask = 1;
+    if (pDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pRtvDescHeap)) != S_OK)
+    {
+        pRtvDescHeap = nullptr;
+        return false;
+    }
+
+    SIZE_T rtvDescriptorSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = pRtvDescHeap->GetCPUDescriptorHandleForHeapStart();
+    ID3D12CommandAllocator* pCmdAlloc;
+    ID3D12Resource* pBackBuffer;
+
+    for (UINT i = 0; i < bufferCount; ++i)
+    {
+        pCmdAlloc = nullptr;
+        pBackBuffer = nullptr;
+
+        if (pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&pCmdAlloc)) != S_OK || pCmdAlloc == nullptr)
+        {
+            _ReleaseRenderTargets();
+            return false;
+        }
+
+        // The command list outlives the render targets, it only needs an allocator to be created.
+        if (pCmdList == nullptr)
+        {
+            if (pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, pCmdAlloc, NULL, IID_PPV_ARGS(&pCmdList)) != S_OK ||
+                pCmdList == nullptr || pCmdList->Close() != S_OK)
+            {
+                SafeRelease(pCmdList);
+                pCmdAlloc->Release();
+                _ReleaseRenderTargets();
+                return false;
+            }
+        }
+
+        if (pSwapChain3->GetBuffer(i, IID_PPV_ARGS(&pBackBuffer)) != S_OK || pBackBuffer == nullptr)
+        {
+            pCmdAlloc->Release();
+            _ReleaseRenderTargets();
+            return false;
+        }
+
+        pDevice->CreateRenderTargetView(pBackBuffer, NULL, rtvHandle);
+
+        OverlayFrames.emplace_back(rtvHandle, pCmdAlloc, pBackBuffer);
+        rtvHandle.ptr += rtvDescriptorSize;
+    }
+
+    return true;
+}
+
 // Try to make this function and overlay's proc as short as possible or it might affect game's fps.
 void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueue* pCommandQueue)
 {
@@ -182,14 +263,25 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
 
     pSwapChain3->GetDesc(&sc_desc);
 
+    if (_Initialized && pSwapChain != _SwapChain)
+    {// A new swapchain: its buffers replace the old ones, everything else survives unless the device changed too.
+        ID3D12Device* pSwapChainDevice = nullptr;
+        if (pSwapChain3->GetDevice(IID_PPV_ARGS(&pSwapChainDevice)) != S_OK || pSwapChainDevice != pDevice)
+            _ResetRenderState();
+        else
+            _ReleaseRenderTargets();
+
+        SafeRelease(pSwapChainDevice);
+    }
+
     if (!_Initialized)
     {
-        UINT bufferIndex = pSwapChain3->GetCurrentBackBufferIndex();
         pDevice = nullptr;
         if (pSwapChain3->GetDevice(IID_PPV_ARGS(&pDevice)) != S_OK)
+        {
+            pSwapChain3->Release();
             return;
-
-        UINT bufferCount = sc_desc.BufferCount;
+        }
 
         //srvDescHeapBitmap.clear();
 
@@ -203,7 +295,8 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
             desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
             if (pDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pSrvDescHeap)) != S_OK)
             {
-                pDevice->Release();
+                pSrvDescHeap = nullptr;
+                SafeRelease(pDevice);
                 pSwapChain3->Release();
                 return;
             }
@@ -211,79 +304,20 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
         
         //srvDescHeapBitmap.resize(descriptor_count, false);
 
+        if (!_CreateRenderTargets(pSwapChain3, sc_desc.BufferCount))
         {
-            D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-            desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-            desc.NumDescriptors = bufferCount;
-            desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            desc.NodeMask = 1;
-            if (pDevice->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&pRtvDescHeap)) != S_OK)
-            {
-                pDevice->Release();
-                pSwapChain3->Release();
-                pSrvDescHeap->Release();
-                return;
-            }
-        
-            SIZE_T rtvDescriptorSize = pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-            D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = pRtvDescHeap->GetCPUDescriptorHandleForHeapStart();
-            ID3D12CommandAllocator* pCmdAlloc;
-            ID3D12Resource* pBackBuffer;
-
-            for (UINT i = 0; i < bufferCount; ++i)
-            {
-                pCmdAlloc = nullptr;
-                pBackBuffer = nullptr;
-
-                if (pDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&pCmdAlloc)) != S_OK || pCmdAlloc == nullptr)
-                {
-                    OverlayFrames.clear();
-                    pSrvDescHeap->Release();
-                    pRtvDescHeap->Release();
-                    pDevice->Release();
-                    pSwapChain3->Release();
-                    return;
-                }
-
-                if (i == 0)
-                {
-                    if (pDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, pCmdAlloc, NULL, IID_PPV_ARGS(&pCmdList)) != S_OK ||
-                        pCmdList == nullptr || pCmdList->Close() != S_OK)
-                    {
-                        OverlayFrames.clear();
-                        SafeRelease(pCmdList);
-                        pCmdAlloc->Release();
-                        pSrvDescHeap->Release();
-                        pRtvDescHeap->Release();
-                        pDevice->Release();
-                        pSwapChain3->Release();
-                        return;
-                    }
-                }
-
-                if (pSwapChain3->GetBuffer(i, IID_PPV_ARGS(&pBackBuffer)) != S_OK || pBackBuffer == nullptr)
-                {
-                    OverlayFrames.clear();
-                    pCmdList->Release();
-                    pCmdAlloc->Release();
-                    pSrvDescHeap->Release();
-                    pRtvDescHeap->Release();
-                    pDevice->Release();
-                    pSwapChain3->Release();
-                    return;
-                }
-
-                pDevice->CreateRenderTargetView(pBackBuffer, NULL, rtvHandle);
-
-                OverlayFrames.emplace_back(rtvHandle, pCmdAlloc, pBackBuffer);
-                rtvHandle.ptr += rtvDescriptorSize;
-            }
+            SafeRelease(pCmdList);
+            SafeRelease(pSrvDescHeap);
+            SafeRelease(pDevice);
+            pSwapChain3->Release();
+            return;
         }
 
         //auto heaps = std::move(get_free_texture_heap());
 
+        // The ImGui context and the font texture live as long as the device, swapchain buffers are recreated on their own.
         ImGui::CreateContext(reinterpret_cast<ImFontAtlas*>(_ImGuiFontAtlas));
-        ImGui_ImplDX12_Init(pDevice, bufferCount, DXGI_FORMAT_R8G8B8A8_UNORM, pSrvDescHeap,
+        ImGui_ImplDX12_Init(pDevice, sc_desc.BufferCount, DXGI_FORMAT_R8G8B8A8_UNORM, pSrvDescHeap,
             pSrvDescHeap->GetCPUDescriptorHandleForHeapStart(),
             pSrvDescHeap->GetGPUDescriptorHandleForHeapStart());
             //heaps.cpu_handle,
@@ -291,9 +325,21 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
         
         Windows_Hook::Inst()->SetInitialWindowSize(sc_desc.OutputWindow);
 
+        _SwapChain = pSwapChain;
         _Initialized = true;
         OverlayHookReady(true);
     }
+    else if (OverlayFrames.empty())
+    {// ResizeBuffers released the buffers, or the game switched swapchains.
+        if (!_CreateRenderTargets(pSwapChain3, sc_desc.BufferCount))
+        {
+            pSwapChain3->Release();
+            return;
+        }
+
+        Windows_Hook::Inst()->SetInitialWindowSize(sc_desc.OutputWindow);
+        _SwapChain = pSwapChain;
+    }
 
     if (ImGui_ImplDX12_NewFrame() && Windows_Hook::Inst()->PrepareForOverlay(sc_desc.OutputWindow))
     {
@@ -301,6 +347,8 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
 
         OverlayProc();
 
+        FrameScheduler.RunFrame();
+
         UINT bufferIndex = pSwapChain3->GetCurrentBackBufferIndex();
 
         D3D12_RESOURCE_BARRIER barrier = {};
@@ -326,6 +374,12 @@ void DX12_Hook::_PrepareForOverlay(IDXGISwapChain* pSwapChain, ID3D12CommandQueu
         pCmdList->Close();
 
         pCommandQueue->ExecuteCommandLists(1, (ID3D12CommandList* const*)&pCmdList);
+
+        if (_ResizePending)
+        {
+            _ResizePending = false;
+            SPDLOG_DEBUG("First overlay frame submitted {}us after ResizeBuffers.", std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _ResizeTime).count());
+        }
     }
 
     pSwapChain3->Release();
@@ -347,14 +401,17 @@ HRESULT STDMETHODCALLTYPE DX12_Hook::MyPresent(IDXGISwapChain *_this, UINT SyncI
 HRESULT STDMETHODCALLTYPE DX12_Hook::MyResizeTarget(IDXGISwapChain* _this, const DXGI_MODE_DESC* pNewTargetParameters)
 {
     auto inst = DX12_Hook::Inst();
-    inst->_ResetRenderState();
+    // The buffers are left alone, ResizeBuffers follows when the game wants them resized.
     return (_this->*inst->ResizeTarget)(pNewTargetParameters);
 }
 
 HRESULT STDMETHODCALLTYPE DX12_Hook::MyResizeBuffers(IDXGISwapChain* _this, UINT BufferCount, UINT Width, UINT Height, DXGI_FORMAT NewFormat, UINT SwapChainFlags)
 {
     auto inst = DX12_Hook::Inst();
-    inst->_ResetRenderState();
+    // ResizeBuffers fails while the back buffers are referenced, only they are released.
+    inst->_ReleaseRenderTargets();
+    inst->_ResizeTime = std::chrono::steady_clock::now();
+    inst->_ResizePending = true;
     return (_this->*inst->ResizeBuffers)(BufferCount, Width, Height, NewFormat, SwapChainFlags);
 }
 
@@ -388,6 +445,8 @@ DX12_Hook::DX12_Hook():
     pSrvDescHeap(nullptr),
     pCmdList(nullptr),
     pRtvDescHeap(nullptr),
+    _SwapChain(nullptr),
+    _ResizePending(false),
     _ImGuiFontAtlas(nullptr),
     Present(nullptr),
     ResizeBuffers(nullptr),
@@ -407,10 +466,9 @@ DX12_Hook::~DX12_Hook()
 
     if (_Initialized)
     {
-        OverlayFrames.clear();
-
-        pSrvDescHeap->Release();
-        pRtvDescHeap->Release();
+        // The render targets are already gone when the game resized its buffers.
+        _ReleaseRenderTargets();
+        SafeRelease(pSrvDescHeap);
 
         ImGui_ImplDX12_InvalidateDeviceObjects();
         ImGui::DestroyContext();
@@ -450,9 +508,9 @@ void DX12_Hook::LoadFunctions(
     Present1 = Present1Fcn;
 }
 
-std::weak_ptr<uint64_t> DX12_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle DX12_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
 {
-    return std::shared_ptr<uint64_t>();
+    return 0;
     //heap_t heap = get_free_texture_heap();
     //
     //if (heap.id == -1)
@@ -620,7 +678,22 @@ std::weak_ptr<uint64_t> DX12_Hook::CreateImageResource(const void* image_data, u
     //});
 }
 
-void DX12_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+ingame_overlay::ImageResourceHandle DX12_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle DX12_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle DX12_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
+{
+    return 0;
+}
+
+void DX12_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
 {
     //auto ptr = resource.lock();
     //if (ptr)
@@ -629,4 +702,23 @@ void DX12_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
     //    if (it != _ImageResources.end())
     //        _ImageResources.erase(it);
     //}
-}
\ No newline at end of file
+}
+
+bool DX12_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    return false;
+}
+
+void* DX12_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    return nullptr;
+}
+
+bool DX12_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return false;
+}
+
+void DX12_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+}
@@ -19,6 +19,8 @@
 
 #include "DX9_Hook.h"
 #include "Windows_Hook.h"
+#include "../Pixel_Convert.h"
+#include "../Texture_Decompress.h"
 #include "DirectX_VTables.h"
 
 #include <imgui.h>
@@ -94,6 +96,22 @@ void DX9_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t DX9_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t DX9_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool DX9_Hook::IsStarted()
 {
     return _Hooked;
@@ -151,6 +169,10 @@ void DX9_Hook::_PrepareForOverlay(IDirect3DDevice9 *pDevice, HWND destWindow)
         pDevice->AddRef();
         _pDevice = pDevice;
 
+        IDirect3DDevice9Ex* pDeviceEx = nullptr;
+        _DeviceEx = SUCCEEDED(pDevice->QueryInterface(IID_PPV_ARGS(&pDeviceEx)));
+        SafeRelease(pDeviceEx);
+
         ImGui::CreateContext(reinterpret_cast<ImFontAtlas*>(_ImGuiFontAtlas));
         ImGui_ImplDX9_Init(pDevice);
 
@@ -168,6 +190,8 @@ void DX9_Hook::_PrepareForOverlay(IDirect3DDevice9 *pDevice, HWND destWindow)
 
         OverlayProc();
 
+        FrameScheduler.RunFrame();
+
         ImGui::Render();
 
         ImGui_ImplDX9_RenderDrawData(ImGui::GetDrawData());
@@ -177,7 +201,11 @@ void DX9_Hook::_PrepareForOverlay(IDirect3DDevice9 *pDevice, HWND destWindow)
 HRESULT STDMETHODCALLTYPE DX9_Hook::MyReset(IDirect3DDevice9* _this, D3DPRESENT_PARAMETERS* pPresentationParameters)
 {
     auto inst = DX9_Hook::Inst();
-    inst->_ResetRenderState();
+    // Reset fails while D3DPOOL_DEFAULT resources are alive, those are ImGui's buffers and font texture only.
+    // They are created again by the next ImGui_ImplDX9_NewFrame, the images live in the managed pool.
+    if (inst->_Initialized && inst->_pDevice == _this)
+        ImGui_ImplDX9_InvalidateDeviceObjects();
+
     return (_this->*inst->Reset)(pPresentationParameters);
 }
 
@@ -223,6 +251,7 @@ DX9_Hook::DX9_Hook():
     _Hooked(false),
     _WindowsHooked(false),
     _LastWindow(nullptr),
+    _DeviceEx(false),
     _ImGuiFontAtlas(nullptr),
     Present(nullptr),
     PresentEx(nullptr),
@@ -237,6 +266,11 @@ DX9_Hook::~DX9_Hook()
     if (_WindowsHooked)
         delete Windows_Hook::Inst();
 
+    _ImageResources.ForEach([](ingame_overlay::ImageResourceHandle, IDirect3DTexture9*& pResource)
+    {
+        pResource->Release();
+    });
+
     if (_Initialized)
     {
         ImGui_ImplDX9_InvalidateDeviceObjects();
@@ -269,79 +303,150 @@ void DX9_Hook::LoadFunctions(decltype(Present) PresentFcn, decltype(Reset) Reset
     SwapChainPresent = SwapChainPresentFcn;
 }
 
-std::weak_ptr<uint64_t> DX9_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle DX9_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
 {
-    IDirect3DTexture9** pTexture = new IDirect3DTexture9*(nullptr);
+    return CreateImageResource(image_data, width, height, ingame_overlay::ImageResourceOptions());
+}
+
+ingame_overlay::ImageResourceHandle DX9_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    if (image_data == nullptr || width == 0 || height == 0)
+        return 0;
+
+    std::vector<uint8_t> fitted;
+    if (ingame_overlay::Pixel_Convert::Fit(reinterpret_cast<const uint8_t*>(image_data), width, height, options.MaxSize, options.MaxSize, fitted, width, height))
+        image_data = fitted.data();
 
+    IDirect3DTexture9* pTexture = nullptr;
+
+    // Default pool textures have to be released before Reset, except on 9Ex devices.
     _pDevice->CreateTexture(
         width,
         height,
         1,
-        D3DUSAGE_DYNAMIC,
+        _DeviceEx ? D3DUSAGE_DYNAMIC : 0,
         D3DFMT_A8R8G8B8,
-        D3DPOOL_DEFAULT,
-        pTexture,
+        _DeviceEx ? D3DPOOL_DEFAULT : D3DPOOL_MANAGED,
+        &pTexture,
         nullptr
     );
 
-    if (*pTexture != nullptr)
+    if (pTexture == nullptr)
+        return 0;
+
+    D3DLOCKED_RECT rect;
+    if (FAILED(pTexture->LockRect(0, &rect, nullptr, _DeviceEx ? D3DLOCK_DISCARD : 0)))
     {
-        D3DLOCKED_RECT rect;
-        if (SUCCEEDED((*pTexture)->LockRect(0, &rect, nullptr, D3DLOCK_DISCARD)))
-        {
-            const uint32_t* pixels = reinterpret_cast<const uint32_t*>(image_data);
-            uint8_t* texture_bits = reinterpret_cast<uint8_t*>(rect.pBits);
-            for (int32_t i = 0; i < height; ++i)
-            {
-                for (int32_t j = 0; j < width; ++j)
-                {
-                    // RGBA to ARGB Conversion, DX9 doesn't have a RGBA loader
-                    uint32_t color = *pixels++;
-                    reinterpret_cast<uint32_t*>(texture_bits)[j] = ((color & 0xff) << 16) | (color & 0xff00) | ((color & 0xff0000) >> 16) | (color & 0xff000000);
-                }
-                texture_bits += rect.Pitch;
-            }
+        pTexture->Release();
+        return 0;
+    }
 
-            if (FAILED((*pTexture)->UnlockRect(0)))
-            {
-                (*pTexture)->Release();
-                delete pTexture;
-                pTexture = nullptr;
-            }
-        }
-        else
+    const uint32_t* pixels = reinterpret_cast<const uint32_t*>(image_data);
+    uint8_t* texture_bits = reinterpret_cast<uint8_t*>(rect.pBits);
+    for (int32_t i = 0; i < height; ++i)
+    {
+        for (int32_t j = 0; j < width; ++j)
         {
-            (*pTexture)->Release();
-            delete pTexture;
-            pTexture = nullptr;
+            // RGBA to ARGB Conversion, DX9 doesn't have a RGBA loader
+            uint32_t color = *pixels++;
+            reinterpret_cast<uint32_t*>(texture_bits)[j] = ((color & 0xff) << 16) | (color & 0xff00) | ((color & 0xff0000) >> 16) | (color & 0xff000000);
         }
+        texture_bits += rect.Pitch;
     }
 
-    if (pTexture == nullptr)
-        return std::shared_ptr<uint64_t>();
+    if (FAILED(pTexture->UnlockRect(0)))
+    {
+        pTexture->Release();
+        return 0;
+    }
+
+    return _ImageResources.Insert(pTexture);
+}
+
+ingame_overlay::ImageResourceHandle DX9_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Pixel_Convert::ToRGBA(image_data, width, height, format, stride, alpha_mode, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
+}
+
+ingame_overlay::ImageResourceHandle DX9_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
+{
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Texture_Decompress::ToRGBA(compressed_data, compressed_size, width, height, format, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
+}
+
+void DX9_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
+{
+    IDirect3DTexture9* pTexture;
+    if (_ImageResources.Remove(resource, pTexture))
+        pTexture->Release();
+}
+
+bool DX9_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    IDirect3DTexture9** ppTexture = _ImageResources.Get(resource);
+    if (ppTexture == nullptr || image_data == nullptr || width == 0 || height == 0)
+        return false;
 
-    auto ptr = std::shared_ptr<uint64_t>((uint64_t*)pTexture, [](uint64_t* handle)
+    if (stride == 0)
+        stride = width * 4;
+
+    if (stride < width * 4)
+        return false;
+
+    IDirect3DTexture9* pTexture = *ppTexture;
+
+    // LockRect doesn't check the rectangle against the texture.
+    D3DSURFACE_DESC desc;
+    if (FAILED(pTexture->GetLevelDesc(0, &desc)) || x >= desc.Width || y >= desc.Height || width > desc.Width - x || height > desc.Height - y)
+        return false;
+
+    RECT dirty_rect;
+    dirty_rect.left = static_cast<LONG>(x);
+    dirty_rect.top = static_cast<LONG>(y);
+    dirty_rect.right = static_cast<LONG>(x + width);
+    dirty_rect.bottom = static_cast<LONG>(y + height);
+
+    // The texture is dynamic, only the dirty rectangle gets locked so the rest of the image is kept.
+    D3DLOCKED_RECT rect;
+    if (FAILED(pTexture->LockRect(0, &rect, &dirty_rect, 0)))
+        return false;
+
+    const uint8_t* pixels = reinterpret_cast<const uint8_t*>(image_data);
+    uint8_t* texture_bits = reinterpret_cast<uint8_t*>(rect.pBits);
+    for (uint32_t i = 0; i < height; ++i)
     {
-        if (handle != nullptr)
+        const uint32_t* row = reinterpret_cast<const uint32_t*>(pixels);
+        for (uint32_t j = 0; j < width; ++j)
         {
-            IDirect3DTexture9** resource = reinterpret_cast<IDirect3DTexture9**>(handle);
-            (*resource)->Release();
-            delete resource;
+            // RGBA to ARGB Conversion, DX9 doesn't have a RGBA loader
+            uint32_t color = row[j];
+            reinterpret_cast<uint32_t*>(texture_bits)[j] = ((color & 0xff) << 16) | (color & 0xff00) | ((color & 0xff0000) >> 16) | (color & 0xff000000);
         }
-    });
+        pixels += stride;
+        texture_bits += rect.Pitch;
+    }
 
-    _ImageResources.emplace(ptr);
+    return SUCCEEDED(pTexture->UnlockRect(0));
+}
 
-    return ptr;
+void* DX9_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    IDirect3DTexture9** ppTexture = _ImageResources.Get(resource);
+    return ppTexture == nullptr ? nullptr : *ppTexture;
 }
 
-void DX9_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+bool DX9_Hook::BeginSdfDraw(void* imgui_draw_list)
 {
-    auto ptr = resource.lock();
-    if (ptr)
-    {
-        auto it = _ImageResources.find(ptr);
-        if (it != _ImageResources.end())
-            _ImageResources.erase(it);
-    }
-}
\ No newline at end of file
+    return false;
+}
+
+void DX9_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+}
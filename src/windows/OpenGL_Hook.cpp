@@ -19,12 +19,17 @@
 
 #include "OpenGL_Hook.h"
 #include "Windows_Hook.h"
+#include "../Pixel_Convert.h"
+#include "../Texture_Decompress.h"
 
 #include <imgui.h>
 #include <backends/imgui_impl_opengl3.h>
 
 #include <glad/gl.h>
 
+#include <algorithm>
+#include <cstring>
+
 OpenGL_Hook* OpenGL_Hook::_inst = nullptr;
 
 bool OpenGL_Hook::StartHook(std::function<void()> key_combination_callback, std::set<ingame_overlay::ToggleKey> toggle_keys, /*ImFontAtlas* */ void* imgui_font_atlas)
@@ -73,6 +78,22 @@ void OpenGL_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t OpenGL_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t OpenGL_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool OpenGL_Hook::IsStarted()
 {
     return _Hooked;
@@ -84,6 +105,14 @@ void OpenGL_Hook::_ResetRenderState()
     {
         OverlayHookReady(false);
 
+        if (_ImageUploadBuffer != 0)
+        {
+            GLuint buffer = _ImageUploadBuffer;
+            glDeleteBuffers(1, &buffer);
+            _ImageUploadBuffer = 0;
+        }
+
+        _SdfShader.Destroy();
         ImGui_ImplOpenGL3_Shutdown();
         Windows_Hook::Inst()->ResetRenderState();
         ImGui::DestroyContext();
@@ -120,6 +149,8 @@ void OpenGL_Hook::_PrepareForOverlay(HDC hDC)
 
         OverlayProc();
 
+        FrameScheduler.RunFrame();
+
         ImGui::Render();
 
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -139,6 +170,7 @@ OpenGL_Hook::OpenGL_Hook():
     _Initialized(false),
     _LastWindow(nullptr),
     _ImGuiFontAtlas(nullptr),
+    _ImageUploadBuffer(0),
     wglSwapBuffers(nullptr)
 {
 }
@@ -152,6 +184,20 @@ OpenGL_Hook::~OpenGL_Hook()
 
     if (_Initialized)
     {
+        _ImageResources.ForEach([](ingame_overlay::ImageResourceHandle, uint32_t& texture)
+        {
+            GLuint name = texture;
+            glDeleteTextures(1, &name);
+        });
+
+        if (_ImageUploadBuffer != 0)
+        {
+            GLuint buffer = _ImageUploadBuffer;
+            glDeleteBuffers(1, &buffer);
+            _ImageUploadBuffer = 0;
+        }
+
+        _SdfShader.Destroy();
         ImGui_ImplOpenGL3_Shutdown();
         ImGui::DestroyContext();
     }
@@ -177,21 +223,30 @@ void OpenGL_Hook::LoadFunctions(wglSwapBuffers_t pfnwglSwapBuffers)
     wglSwapBuffers = pfnwglSwapBuffers;
 }
 
-std::weak_ptr<uint64_t> OpenGL_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle OpenGL_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
 {
-    GLuint* texture = new GLuint(0);
-    glGenTextures(1, texture);
+    return CreateImageResource(image_data, width, height, ingame_overlay::ImageResourceOptions());
+}
+
+ingame_overlay::ImageResourceHandle OpenGL_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    if (image_data == nullptr || width == 0 || height == 0)
+        return 0;
+
+    std::vector<uint8_t> fitted;
+    if (ingame_overlay::Pixel_Convert::Fit(reinterpret_cast<const uint8_t*>(image_data), width, height, options.MaxSize, options.MaxSize, fitted, width, height))
+        image_data = fitted.data();
+
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
     if (glGetError() != GL_NO_ERROR)
-    {
-        delete texture;
-        return std::shared_ptr<uint64_t>(nullptr);
-    }
+        return 0;
     
     // Save old texture id
     GLint oldTex;
     glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
 
-    glBindTexture(GL_TEXTURE_2D, *texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -200,29 +255,125 @@ std::weak_ptr<uint64_t> OpenGL_Hook::CreateImageResource(const void* image_data,
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image_data);
 
-    glBindTexture(GL_TEXTURE_2D, oldTex);
-
-    auto ptr = std::shared_ptr<uint64_t>((uint64_t*)texture, [](uint64_t* handle)
+    if (options.Mipmaps)
     {
-        if (handle != nullptr)
+        std::vector<std::vector<uint8_t>> levels;
+        ingame_overlay::Pixel_Convert::BuildMipChain(reinterpret_cast<const uint8_t*>(image_data), width, height, levels);
+        for (size_t i = 0; i < levels.size(); ++i)
         {
-            GLuint* texture = (GLuint*)handle;
-            glDeleteTextures(1, texture);
-            delete texture;
+            width = std::max<uint32_t>(1, width / 2);
+            height = std::max<uint32_t>(1, height / 2);
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i + 1), GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, levels[i].data());
         }
-    });
 
-    _ImageResources.emplace(ptr);
-    return ptr;
+        // Trilinear filtering, blend the two closest levels.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, oldTex);
+
+    return _ImageResources.Insert(texture);
+}
+
+ingame_overlay::ImageResourceHandle OpenGL_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Pixel_Convert::ToRGBA(image_data, width, height, format, stride, alpha_mode, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
 }
 
-void OpenGL_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+ingame_overlay::ImageResourceHandle OpenGL_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
 {
-    auto ptr = resource.lock();
-    if (ptr)
+    std::vector<uint8_t> rgba;
+    if (!ingame_overlay::Texture_Decompress::ToRGBA(compressed_data, compressed_size, width, height, format, rgba))
+        return 0;
+
+    return CreateImageResource(rgba.data(), width, height);
+}
+
+void OpenGL_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
+{
+    uint32_t texture;
+    if (_ImageResources.Remove(resource, texture))
+    {
+        GLuint name = texture;
+        glDeleteTextures(1, &name);
+    }
+}
+
+bool OpenGL_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    uint32_t* texture = _ImageResources.Get(resource);
+    if (texture == nullptr || image_data == nullptr || width == 0 || height == 0)
+        return false;
+
+    if (stride == 0)
+        stride = width * 4;
+
+    // GL_UNPACK_ROW_LENGTH is expressed in pixels, the stride must hold whole RGBA pixels.
+    if (stride < width * 4 || (stride % 4) != 0)
+        return false;
+
+    const GLsizeiptr upload_size = static_cast<GLsizeiptr>(stride) * (height - 1) + width * 4;
+
+    if (_ImageUploadBuffer == 0)
+    {
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        _ImageUploadBuffer = buffer;
+    }
+
+    // Save old state
+    GLint oldTex, oldUnpackBuffer, oldRowLength, oldAlignment;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &oldTex);
+    glGetIntegerv(GL_PIXEL_UNPACK_BUFFER_BINDING, &oldUnpackBuffer);
+    glGetIntegerv(GL_UNPACK_ROW_LENGTH, &oldRowLength);
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldAlignment);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _ImageUploadBuffer);
+    // Orphan the previous storage so we never wait on an upload still in flight.
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, upload_size, nullptr, GL_STREAM_DRAW);
+
+    bool uploaded = false;
+    void* staging = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    if (staging != nullptr)
     {
-        auto it = _ImageResources.find(ptr);
-        if (it != _ImageResources.end())
-            _ImageResources.erase(it);
+        memcpy(staging, image_data, upload_size);
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE)
+        {
+            glBindTexture(GL_TEXTURE_2D, *texture);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            // Source is the bound pixel unpack buffer, the pointer is an offset into it.
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            uploaded = glGetError() == GL_NO_ERROR;
+        }
     }
-}
\ No newline at end of file
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, oldAlignment);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, oldRowLength);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, oldUnpackBuffer);
+    glBindTexture(GL_TEXTURE_2D, oldTex);
+
+    return uploaded;
+}
+
+void* OpenGL_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    uint32_t* texture = _ImageResources.Get(resource);
+    return texture == nullptr ? nullptr : reinterpret_cast<void*>(static_cast<uintptr_t>(*texture));
+}
+
+bool OpenGL_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return _SdfShader.Begin(imgui_draw_list);
+}
+
+void OpenGL_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+    _SdfShader.End(imgui_draw_list);
+}
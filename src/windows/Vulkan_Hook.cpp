@@ -72,6 +72,22 @@ void Vulkan_Hook::HideOverlayInputs(bool hide)
     }
 }
 
+uint32_t Vulkan_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->SetInputPolicy(mask, flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
+uint32_t Vulkan_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    if (_Initialized)
+        return Windows_Hook::Inst()->ToggleInputPolicy(flags);
+
+    return ingame_overlay::InputPolicy_HideOverlayInputs;
+}
+
 bool Vulkan_Hook::IsStarted()
 {
     return _Hooked;
@@ -145,12 +161,46 @@ void Vulkan_Hook::LoadFunctions(decltype(::vkQueuePresentKHR)* _vkQueuePresentKH
     vkQueuePresentKHR = _vkQueuePresentKHR;
 }
 
-std::weak_ptr<uint64_t> Vulkan_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+ingame_overlay::ImageResourceHandle Vulkan_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle Vulkan_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::PixelFormat format, uint32_t stride, ingame_overlay::AlphaMode alpha_mode)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle Vulkan_Hook::CreateImageResource(const void* image_data, uint32_t width, uint32_t height, ingame_overlay::ImageResourceOptions const& options)
+{
+    return 0;
+}
+
+ingame_overlay::ImageResourceHandle Vulkan_Hook::CreateCompressedImageResource(const void* compressed_data, size_t compressed_size, uint32_t width, uint32_t height, ingame_overlay::CompressedFormat format)
 {
-    return std::shared_ptr<uint64_t>(nullptr);
+    return 0;
 }
 
-void Vulkan_Hook::ReleaseImageResource(std::weak_ptr<uint64_t> resource)
+void Vulkan_Hook::ReleaseImageResource(ingame_overlay::ImageResourceHandle resource)
 {
 
-}
\ No newline at end of file
+}
+
+bool Vulkan_Hook::UpdateImageResource(ingame_overlay::ImageResourceHandle resource, uint32_t x, uint32_t y, uint32_t width, uint32_t height, const void* image_data, uint32_t stride)
+{
+    return false;
+}
+
+void* Vulkan_Hook::GetImageResourceTexture(ingame_overlay::ImageResourceHandle resource)
+{
+    return nullptr;
+}
+
+bool Vulkan_Hook::BeginSdfDraw(void* imgui_draw_list)
+{
+    return false;
+}
+
+void Vulkan_Hook::EndSdfDraw(void* imgui_draw_list)
+{
+}
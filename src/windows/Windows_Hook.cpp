@@ -155,20 +155,30 @@ bool Windows_Hook::StartHook(std::function<void()>& _key_combination_callback, s
 
 void Windows_Hook::HideAppInputs(bool hide)
 {
-    _ApplicationInputsHidden = hide;
-    if (hide)
-    {
-        _ClipCursor(&_DefaultClipCursor);
-    }
-    else
-    {
-        _ClipCursor(&_SavedClipCursor);
-    }
+    SetInputPolicy(ingame_overlay::InputPolicy_HideAppInputs, hide ? ingame_overlay::InputPolicy_HideAppInputs : 0);
 }
 
 void Windows_Hook::HideOverlayInputs(bool hide)
 {
-    _OverlayInputsHidden = hide;
+    SetInputPolicy(ingame_overlay::InputPolicy_HideOverlayInputs, hide ? ingame_overlay::InputPolicy_HideOverlayInputs : 0);
+}
+
+uint32_t Windows_Hook::SetInputPolicy(uint32_t mask, uint32_t flags)
+{
+    const uint32_t previous = _InputPolicy.Set(mask, flags);
+    if (mask & ingame_overlay::InputPolicy_HideAppInputs)
+        _ClipCursor((flags & ingame_overlay::InputPolicy_HideAppInputs) ? &_DefaultClipCursor : &_SavedClipCursor);
+
+    return previous;
+}
+
+uint32_t Windows_Hook::ToggleInputPolicy(uint32_t flags)
+{
+    const uint32_t previous = _InputPolicy.Toggle(flags);
+    if (flags & ingame_overlay::InputPolicy_HideAppInputs)
+        _ClipCursor(((previous ^ flags) & ingame_overlay::InputPolicy_HideAppInputs) ? &_DefaultClipCursor : &_SavedClipCursor);
+
+    return previous;
 }
 
 void Windows_Hook::ResetRenderState()
@@ -198,8 +208,13 @@ short Windows_Hook::ImGuiGetKeyState(int nVirtKey)
 
 bool Windows_Hook::PrepareForOverlay(HWND hWnd)
 {
-    if (_GameHwnd != hWnd)
-        ResetRenderState();
+    if (_Initialized && _GameHwnd != hWnd)
+    {// The game switched windows, only the platform backend follows it.
+        // The inputs state is kept, so an open overlay stays open.
+        ImGui_ImplWin32_Shutdown();
+        SetInitialWindowSize(hWnd);
+        _Initialized = false;
+    }
 
     if (!_Initialized)
     {
@@ -211,7 +226,7 @@ bool Windows_Hook::PrepareForOverlay(HWND hWnd)
 
     if (_Initialized)
     {
-        if (!_OverlayInputsHidden)
+        if (!_InputPolicy.OverlayInputsHidden())
         {
             ImGui_ImplWin32_NewFrame();
             // Read keyboard modifiers inputs
@@ -294,8 +309,10 @@ void Windows_Hook::_RawEvent(RAWINPUT& raw)
 
 bool Windows_Hook::_HandleEvent(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 {
-    bool hide_app_inputs = _ApplicationInputsHidden;
-    bool hide_overlay_inputs = _OverlayInputsHidden;
+    // One load, both flags come from the same policy change.
+    const uint32_t policy = _InputPolicy.Load();
+    bool hide_app_inputs = (policy & ingame_overlay::InputPolicy_HideAppInputs) != 0;
+    bool hide_overlay_inputs = (policy & ingame_overlay::InputPolicy_HideOverlayInputs) != 0;
     
     if (_Initialized)
     {
@@ -311,14 +328,16 @@ bool Windows_Hook::_HandleEvent(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPar
     
             if (key_count == _NativeKeyCombination.size())
             {// All shortcut keys are pressed
-                if (!_KeyCombinationPushed)
+                if (!_KeyCombinationPushed.load(std::memory_order_relaxed))
                 {
                     _KeyCombinationCallback();
-    
-                    if (_OverlayInputsHidden)
+
+                    // The callback usually changes the policy, the key press that opened the overlay must not reach the game.
+                    const uint32_t new_policy = _InputPolicy.Load();
+                    if (new_policy & ingame_overlay::InputPolicy_HideOverlayInputs)
                         hide_overlay_inputs = true;
     
-                    if(_ApplicationInputsHidden)
+                    if (new_policy & ingame_overlay::InputPolicy_HideAppInputs)
                     {
                         hide_app_inputs = true;
     
@@ -331,12 +350,12 @@ bool Windows_Hook::_HandleEvent(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lPar
                     {
                         _ClipCursor(&_SavedClipCursor);
                     }
-                    _KeyCombinationPushed = true;
+                    _KeyCombinationPushed.store(true, std::memory_order_relaxed);
                 }
             }
             else
             {
-                _KeyCombinationPushed = false;
+                _KeyCombinationPushed.store(false, std::memory_order_relaxed);
             }
         }
     
@@ -372,7 +391,7 @@ UINT WINAPI Windows_Hook::MyGetRawInputBuffer(PRAWINPUT pData, PUINT pcbSize, UI
     if (!inst->_Initialized)
         return res;
 
-    if (!inst->_OverlayInputsHidden)
+    if (!inst->_InputPolicy.OverlayInputsHidden())
     {
         if (pData != nullptr)
         {
@@ -381,7 +400,7 @@ UINT WINAPI Windows_Hook::MyGetRawInputBuffer(PRAWINPUT pData, PUINT pcbSize, UI
         }
     }
 
-    if (!inst->_ApplicationInputsHidden)
+    if (!inst->_InputPolicy.AppInputsHidden())
         return res;
 
     return 0;
@@ -397,7 +416,7 @@ UINT WINAPI Windows_Hook::MyGetRawInputData(HRAWINPUT hRawInput, UINT uiCommand,
     if (uiCommand == RID_INPUT && res == sizeof(RAWINPUT))
         inst->_RawEvent(*reinterpret_cast<RAWINPUT*>(pData));
 
-    if (!inst->_ApplicationInputsHidden)
+    if (!inst->_InputPolicy.AppInputsHidden())
         return res;
 
     memset(pData, 0, *pcbSize);
@@ -409,7 +428,7 @@ SHORT WINAPI Windows_Hook::MyGetKeyState(int nVirtKey)
 {
     Windows_Hook* inst = Windows_Hook::Inst();
 
-    if (inst->_Initialized && inst->_ApplicationInputsHidden)
+    if (inst->_Initialized && inst->_InputPolicy.AppInputsHidden())
         return 0;
 
     return inst->_GetKeyState(nVirtKey);
@@ -419,7 +438,7 @@ SHORT WINAPI Windows_Hook::MyGetAsyncKeyState(int vKey)
 {
     Windows_Hook* inst = Windows_Hook::Inst();
 
-    if (inst->_Initialized && inst->_ApplicationInputsHidden)
+    if (inst->_Initialized && inst->_InputPolicy.AppInputsHidden())
         return 0;
 
     return inst->_GetAsyncKeyState(vKey);
@@ -429,7 +448,7 @@ BOOL WINAPI Windows_Hook::MyGetKeyboardState(PBYTE lpKeyState)
 {
     Windows_Hook* inst = Windows_Hook::Inst();
 
-    if (inst->_Initialized && inst->_ApplicationInputsHidden)
+    if (inst->_Initialized && inst->_InputPolicy.AppInputsHidden())
         return FALSE;
 
     return inst->_GetKeyboardState(lpKeyState);
@@ -440,7 +459,7 @@ BOOL  WINAPI Windows_Hook::MyGetCursorPos(LPPOINT lpPoint)
     Windows_Hook* inst = Windows_Hook::Inst();
     
     BOOL res = inst->_GetCursorPos(lpPoint);
-    if (inst->_Initialized && inst->_ApplicationInputsHidden && lpPoint != nullptr)
+    if (inst->_Initialized && inst->_InputPolicy.AppInputsHidden() && lpPoint != nullptr)
     {
         *lpPoint = inst->_SavedCursorPos;
     }
@@ -452,7 +471,7 @@ BOOL WINAPI Windows_Hook::MySetCursorPos(int X, int Y)
 {
     Windows_Hook* inst = Windows_Hook::Inst();
 
-    if (!inst->_Initialized || !inst->_ApplicationInputsHidden)
+    if (!inst->_Initialized || !inst->_InputPolicy.AppInputsHidden())
         return inst->_SetCursorPos(X, Y);
 
     return TRUE;
@@ -461,7 +480,7 @@ BOOL WINAPI Windows_Hook::MySetCursorPos(int X, int Y)
 BOOL WINAPI Windows_Hook::MyGetClipCursor(RECT* lpRect)
 {
     Windows_Hook* inst = Windows_Hook::Inst();
-    if (lpRect == nullptr || !inst->_Initialized || !inst->_ApplicationInputsHidden)
+    if (lpRect == nullptr || !inst->_Initialized || !inst->_InputPolicy.AppInputsHidden())
         return inst->_GetClipCursor(lpRect);
 
     *lpRect = inst->_SavedClipCursor;
@@ -475,7 +494,7 @@ BOOL WINAPI Windows_Hook::MyClipCursor(CONST RECT* lpRect)
 
     inst->_SavedClipCursor = *v;
 
-    if (!inst->_Initialized || !inst->_ApplicationInputsHidden)
+    if (!inst->_Initialized || !inst->_InputPolicy.AppInputsHidden())
         return inst->_ClipCursor(v);
     
     return inst->_ClipCursor(&inst->_DefaultClipCursor);
@@ -534,7 +553,7 @@ BOOL WINAPI Windows_Hook::MyPeekMessageA(LPMSG lpMsg, HWND hWnd, UINT wMsgFilter
     if (!inst->_Initialized || lpMsg == nullptr || res == FALSE)
         return res;
 
-    if (!(wRemoveMsg & PM_REMOVE) && inst->_ApplicationInputsHidden && IgnoreMsg(lpMsg->message))
+    if (!(wRemoveMsg & PM_REMOVE) && inst->_InputPolicy.AppInputsHidden() && IgnoreMsg(lpMsg->message))
     {
         // Remove message from queue
         inst->_PeekMessageA(lpMsg, hWnd, wMsgFilterMin, wMsgFilterMax, PM_REMOVE | (wRemoveMsg & (~PM_REMOVE)));
@@ -561,7 +580,7 @@ BOOL WINAPI Windows_Hook::MyPeekMessageW(LPMSG lpMsg, HWND hWnd, UINT wMsgFilter
     if (!inst->_Initialized || lpMsg == nullptr || res == FALSE)
         return res;
 
-    if (!(wRemoveMsg & PM_REMOVE) && inst->_ApplicationInputsHidden && IgnoreMsg(lpMsg->message))
+    if (!(wRemoveMsg & PM_REMOVE) && inst->_InputPolicy.AppInputsHidden() && IgnoreMsg(lpMsg->message))
     {
         // Remove message from queue
         inst->_PeekMessageW(lpMsg, hWnd, wMsgFilterMin, wMsgFilterMax, PM_REMOVE | (wRemoveMsg & (~PM_REMOVE)));
@@ -585,8 +604,7 @@ Windows_Hook::Windows_Hook() :
     _GameHwnd(nullptr),
     _RecurseCallCount(0),
     _DefaultClipCursor{ LONG(0xFFFF8000), LONG(0xFFFF8000), LONG(0x00007FFF), LONG(0x00007FFF) },
-    _ApplicationInputsHidden(false),
-    _OverlayInputsHidden(true),
+    _InputPolicy(ingame_overlay::InputPolicy_HideOverlayInputs),
     _KeyCombinationPushed(false)
 {
 }
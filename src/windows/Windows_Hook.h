@@ -22,6 +22,7 @@
 #include <ingame_overlay/Renderer_Hook.h>
 
 #include "../internal_includes.h"
+#include "../Input_Policy.h"
 
 class Windows_Hook :
     public Base_Hook
@@ -40,14 +41,14 @@ private:
     POINT _SavedCursorPos;
     RECT _SavedClipCursor;
     CONST RECT _DefaultClipCursor;
-    bool _ApplicationInputsHidden;
-    bool _OverlayInputsHidden;
+    Input_Policy _InputPolicy;
 
     // In (bool): Is toggle wanted
     // Out(bool): Is the overlay visible, if true, inputs will be disabled
     std::function<void()> _KeyCombinationCallback;
     std::set<int> _NativeKeyCombination;
-    bool _KeyCombinationPushed;
+    // Only written by the input thread, atomic so a policy change made from the key combination callback is ordered with it.
+    std::atomic<bool> _KeyCombinationPushed;
 
     // Functions
     Windows_Hook();
@@ -99,6 +100,8 @@ public:
     bool StartHook(std::function<void()>& key_combination_callback, std::set<ingame_overlay::ToggleKey> const& toggle_keys);
     void HideAppInputs(bool hide);
     void HideOverlayInputs(bool hide);
+    uint32_t SetInputPolicy(uint32_t mask, uint32_t flags);
+    uint32_t ToggleInputPolicy(uint32_t flags);
     static Windows_Hook* Inst();
     virtual std::string GetLibraryName() const;
 };
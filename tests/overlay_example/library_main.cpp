@@ -1,22 +1,42 @@
 #include <thread>
-#include <mutex>
+#include <string>
 
 #include <imgui.h>
 #include <ingame_overlay/Renderer_Detector.h>
+#include <ingame_overlay/Overlay_Channel.h>
+#include <ingame_overlay/Font_Atlas_Cache.h>
+#include <ingame_overlay/Font_Atlas_Builder.h>
 
 using namespace std::chrono_literals;
 
 static void* g_hModule;
 
+enum class overlay_command_t
+{
+    none,
+    show,
+    hide,
+    hook_ready,
+    hook_reset,
+};
+
+struct overlay_status_t
+{
+    std::string font_atlas_source;
+};
+
 struct overlay_t
 {
     std::thread worker;
 
     ImFontAtlas* font_atlas;
     ingame_overlay::Renderer_Hook* renderer;
-    std::mutex overlay_mutex;
+    // Posted by the toggle key callback and the hook, consumed at the start of overlay_proc.
+    ingame_overlay::Command_Queue<overlay_command_t, 64> commands;
+    // Published by the worker, read by overlay_proc.
+    ingame_overlay::State_Snapshot<overlay_status_t> status;
+    // Only touched by overlay_proc.
     bool show;
-    bool stop;
 };
 
 static overlay_t* overlay_datas;
@@ -30,7 +50,6 @@ void shared_library_load(void* hmodule)
 
     overlay_datas->worker = std::thread([]()
     {
-        std::lock_guard<std::mutex> lk(overlay_datas->overlay_mutex);
         // Try to detect renderer for an infinite amount of time.
         auto future = ingame_overlay::DetectRenderer();
         // Try to detect renderer for at most 4 seconds.
@@ -62,9 +81,31 @@ void shared_library_load(void* hmodule)
             // overlay_proc is called  when the process wants to swap buffers.
             overlay_datas->renderer->OverlayProc = []()
             {
-                std::lock_guard<std::mutex> lk(overlay_datas->overlay_mutex);
                 static char buf[255]{};
 
+                // Never blocks, a command posted while we consume is handled next frame.
+                overlay_datas->commands.Consume([](overlay_command_t command)
+                {
+                    switch (command)
+                    {
+                        // The toggle key callback already switched the input policy.
+                        case overlay_command_t::show:
+                            overlay_datas->show = true;
+                            break;
+
+                        case overlay_command_t::hide:
+                            overlay_datas->show = false;
+                            break;
+
+                        case overlay_command_t::hook_reset:
+                            overlay_datas->show = false;
+                            break;
+
+                        default:
+                            break;
+                    }
+                });
+
                 if (!overlay_datas->show)
                     return;
 
@@ -81,13 +122,15 @@ void shared_library_load(void* hmodule)
                 {
                     if (!overlay_datas->show)
                     {
-                        overlay_datas->renderer->HideAppInputs(false);
-                        overlay_datas->renderer->HideOverlayInputs(true);
+                        overlay_datas->renderer->SetInputPolicy(
+                            ingame_overlay::InputPolicy_HideAppInputs | ingame_overlay::InputPolicy_HideOverlayInputs,
+                            ingame_overlay::InputPolicy_HideOverlayInputs);
                     }
 
                     ImGui::TextUnformatted("Hello from overlay !");
                     ImGui::Text("Mouse pos: %d, %d", (int)io.MousePos.x, (int)io.MousePos.y);
                     ImGui::Text("Renderer Hooked: %s", overlay_datas->renderer->GetLibraryName().c_str());
+                    ImGui::Text("Font atlas: %s", overlay_datas->status.Read().font_atlas_source.c_str());
                     ImGui::InputText("Test input text", buf, sizeof(buf));
                 }
                 ImGui::End();
@@ -97,7 +140,7 @@ void shared_library_load(void* hmodule)
             // or when the renderer has been reset (false).
             overlay_datas->renderer->OverlayHookReady = [](bool is_ready)
             {
-                std::lock_guard<std::mutex> lk(overlay_datas->overlay_mutex);
+                overlay_datas->commands.TryPush(is_ready ? overlay_command_t::hook_ready : overlay_command_t::hook_reset);
             };
 
             overlay_datas->font_atlas = new ImFontAtlas();
@@ -110,24 +153,26 @@ void shared_library_load(void* hmodule)
 
             overlay_datas->font_atlas->AddFontDefault(&fontcfg);
 
-            overlay_datas->font_atlas->Build();
+            // Warm starts load the built atlas instead of rasterizing the glyphs again.
+            const uint64_t font_atlas_key = ingame_overlay::Font_Atlas_Cache::ComputeKey(overlay_datas->font_atlas);
+            if (ingame_overlay::Font_Atlas_Cache::Load(overlay_datas->font_atlas, "overlay_font_atlas.cache", font_atlas_key))
+            {
+                overlay_datas->status.Update([](overlay_status_t& status) { status.font_atlas_source = "cache"; });
+            }
+            else
+            {
+                ingame_overlay::Font_Atlas_Builder::Build(overlay_datas->font_atlas);
+                ingame_overlay::Font_Atlas_Cache::Save(overlay_datas->font_atlas, "overlay_font_atlas.cache", font_atlas_key);
+                overlay_datas->status.Update([](overlay_status_t& status) { status.font_atlas_source = "built"; });
+            }
 
             overlay_datas->renderer->StartHook([]()
             {
-                std::lock_guard<std::mutex> lk(overlay_datas->overlay_mutex);
-
-                if (overlay_datas->show)
-                {
-                    overlay_datas->renderer->HideAppInputs(false);
-                    overlay_datas->renderer->HideOverlayInputs(true);
-                    overlay_datas->show = false;
-                }
-                else
-                {
-                    overlay_datas->renderer->HideAppInputs(true);
-                    overlay_datas->renderer->HideOverlayInputs(false);
-                    overlay_datas->show = true;
-                }
+                // The policy is atomic, switching it here makes the key press that opens the overlay already go to it.
+                // Both flags change at once, the input thread never sees the game and the overlay both reading inputs.
+                const uint32_t previous_policy = overlay_datas->renderer->ToggleInputPolicy(ingame_overlay::InputPolicy_HideAppInputs | ingame_overlay::InputPolicy_HideOverlayInputs);
+                const bool show = (previous_policy & ingame_overlay::InputPolicy_HideOverlayInputs) != 0;
+                overlay_datas->commands.TryPush(show ? overlay_command_t::show : overlay_command_t::hide);
             }, { ingame_overlay::ToggleKey::SHIFT, ingame_overlay::ToggleKey::F2 }, overlay_datas->font_atlas);
         }
     });
@@ -135,14 +180,10 @@ void shared_library_load(void* hmodule)
 
 void shared_library_unload(void* hmodule)
 {
-    {
-        std::lock_guard<std::mutex> lk(overlay_datas->overlay_mutex);
-        if (overlay_datas->worker.joinable())
-            overlay_datas->worker.join();
+    if (overlay_datas->worker.joinable())
+        overlay_datas->worker.join();
 
-        overlay_datas->show = false;
-        delete overlay_datas->renderer; overlay_datas->renderer = nullptr;
-    }
+    delete overlay_datas->renderer; overlay_datas->renderer = nullptr;
     delete overlay_datas;
 }
 
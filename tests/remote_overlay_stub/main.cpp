@@ -0,0 +1,95 @@
+// Stands in for the overlay process of a Remote_Overlay_Compositor: opens the channel the game created,
+// publishes a panel following the mouse and prints the inputs it receives.
+//
+//   remote_overlay_stub [channel name] [frame count]
+
+#include <ingame_overlay/Remote_Overlay.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+#if defined(_WIN32) || defined(WIN32) || defined(_WIN64) || defined(WIN64)
+static const char* default_channel_name = "Local\\ingame_overlay_remote";
+#else
+static const char* default_channel_name = "/ingame_overlay_remote";
+#endif
+
+static const char* input_type_name(ingame_overlay::RemoteInputType type)
+{
+    switch (type)
+    {
+        case ingame_overlay::RemoteInputType::MousePos   : return "mouse_pos";
+        case ingame_overlay::RemoteInputType::MouseButton: return "mouse_button";
+        case ingame_overlay::RemoteInputType::MouseWheel : return "mouse_wheel";
+        case ingame_overlay::RemoteInputType::Key        : return "key";
+        case ingame_overlay::RemoteInputType::Character  : return "character";
+        case ingame_overlay::RemoteInputType::DisplaySize: return "display_size";
+    }
+
+    return "unknown";
+}
+
+int main(int argc, char* argv[])
+{
+    const char* channel_name = argc > 1 ? argv[1] : default_channel_name;
+    const long frame_count = argc > 2 ? strtol(argv[2], nullptr, 10) : -1;
+
+    ingame_overlay::Remote_Overlay_Channel channel;
+    while (!channel.Open(channel_name))
+    {
+        printf("Waiting for the channel %s...\n", channel_name);
+        std::this_thread::sleep_for(1s);
+    }
+
+    const uint32_t width = std::min<uint32_t>(channel.MaxWidth(), 640);
+    const uint32_t height = std::min<uint32_t>(channel.MaxHeight(), 360);
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height);
+
+    float mouse_x = 0.0f;
+    float mouse_y = 0.0f;
+    bool clicked = false;
+
+    for (long frame = 0; frame_count < 0 || frame < frame_count; ++frame)
+    {
+        ingame_overlay::RemoteInputEvent input_event;
+        while (channel.PopInput(input_event))
+        {
+            printf("%s code=%d value=%d x=%.1f y=%.1f\n", input_type_name(input_event.Type), input_event.Code, input_event.Value, input_event.X, input_event.Y);
+            if (input_event.Type == ingame_overlay::RemoteInputType::MousePos)
+            {
+                mouse_x = input_event.X;
+                mouse_y = input_event.Y;
+            }
+            else if (input_event.Type == ingame_overlay::RemoteInputType::MouseButton && input_event.Code == 0)
+            {
+                clicked = input_event.Value != 0;
+            }
+        }
+
+        // Half transparent background, premultiplied: the color channels are already scaled by alpha.
+        const uint32_t background = 0x80402010; // A=0x80 B=0x40 G=0x20 R=0x10
+        const uint32_t cursor = clicked ? 0xFF0000FF : 0xFF00FF00;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                const bool in_cursor = x + 16 >= mouse_x && x <= mouse_x + 16 && y + 16 >= mouse_y && y <= mouse_y + 16;
+                const bool in_bar = x < (frame % 60) * width / 60 && y < 8;
+                pixels[static_cast<size_t>(y) * width + x] = in_cursor || in_bar ? cursor : background;
+            }
+        }
+
+        channel.PublishFrame(pixels.data(), width, height);
+        std::this_thread::sleep_for(33ms);
+    }
+
+    // Hides the overlay before leaving.
+    channel.PublishFrame(nullptr, 0, 0);
+    return 0;
+}
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+// Measures Draw_Data_Encoder and Draw_Data_Decoder on frames of a typical overlay.
+//
+//   draw_data_bench [iterations]
+//
+// Exits with 1 when a frame doesn't round trip or when a full encode takes 100us or more on average.
+
+#include <ingame_overlay/Draw_Data_Codec.h>
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static constexpr double EncodeBudgetUs = 100.0;
+
+static void draw_overlay(int frame)
+{
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(20, 20), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(420, 520), ImGuiCond_Always);
+    ImGui::Begin("Friends");
+    for (int i = 0; i < 40; ++i)
+    {
+        ImGui::Text("Friend %02d", i);
+        ImGui::SameLine(200);
+        ImGui::TextColored(i % 3 == 0 ? ImVec4(0.2f, 1.0f, 0.2f, 1.0f) : ImVec4(0.6f, 0.6f, 0.6f, 1.0f), i % 3 == 0 ? "Online" : "Offline");
+    }
+    ImGui::End();
+
+    ImGui::SetNextWindowPos(ImVec2(460, 20), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(400, 300), ImGuiCond_Always);
+    ImGui::Begin("Settings");
+    static float volume = 0.5f;
+    static bool notifications = true;
+    static int quality = 1;
+    ImGui::SliderFloat("Volume", &volume, 0.0f, 1.0f);
+    ImGui::Checkbox("Notifications", &notifications);
+    ImGui::Combo("Quality", &quality, "Low\0Medium\0High\0");
+    ImGui::Button("Apply");
+    ImGui::SameLine();
+    ImGui::Button("Cancel");
+    ImGui::End();
+
+    // Changes every frame, like a FPS counter or a chat.
+    ImGui::SetNextWindowPos(ImVec2(460, 340), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(400, 200), ImGuiCond_Always);
+    ImGui::Begin("Stats");
+    float values[64];
+    for (int i = 0; i < 64; ++i)
+        values[i] = std::sin((frame + i) * 0.1f);
+
+    ImGui::Text("Frame %d", frame);
+    ImGui::PlotLines("##frame_times", values, 64, 0, nullptr, -1.0f, 1.0f, ImVec2(380, 80));
+    ImGui::End();
+
+    ImGui::Render();
+}
+
+static bool same_draw_data(ImDrawData const* original, ImDrawData const* decoded)
+{
+    if (decoded == nullptr || original->CmdListsCount != decoded->CmdListsCount || original->TotalVtxCount != decoded->TotalVtxCount || original->TotalIdxCount != decoded->TotalIdxCount)
+        return false;
+
+    for (int i = 0; i < original->CmdListsCount; ++i)
+    {
+        ImDrawList const* a = original->CmdLists[i];
+        ImDrawList const* b = decoded->CmdLists[i];
+        if (a->IdxBuffer.Size != b->IdxBuffer.Size || a->VtxBuffer.Size != b->VtxBuffer.Size)
+            return false;
+
+        for (int j = 0; j < a->IdxBuffer.Size; ++j)
+        {
+            if (a->IdxBuffer[j] != b->IdxBuffer[j])
+                return false;
+        }
+
+        for (int j = 0; j < a->VtxBuffer.Size; ++j)
+        {
+            ImDrawVert const& va = a->VtxBuffer[j];
+            ImDrawVert const& vb = b->VtxBuffer[j];
+            if (va.col != vb.col || std::fabs(va.pos.x - vb.pos.x) > 1.0f / 64 || std::fabs(va.pos.y - vb.pos.y) > 1.0f / 64 || std::fabs(va.uv.x - vb.uv.x) > 1.0f / 65536 || std::fabs(va.uv.y - vb.uv.y) > 1.0f / 65536)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+struct Result_t
+{
+    double EncodeUs;
+    double DecodeUs;
+    size_t Bytes;
+    bool RoundTrip;
+};
+
+static Result_t run(int iterations, bool keyframes, bool animated)
+{
+    using clock = std::chrono::steady_clock;
+
+    ingame_overlay::Draw_Data_Encoder encoder;
+    ingame_overlay::Draw_Data_Decoder decoder;
+    std::vector<uint8_t> buffer;
+    Result_t result{ 0.0, 0.0, 0, true };
+
+    for (int i = 0; i < iterations; ++i)
+    {
+        draw_overlay(animated ? i : 0);
+        ImDrawData* draw_data = ImGui::GetDrawData();
+
+        const auto start = clock::now();
+        encoder.Encode(draw_data, buffer, keyframes);
+        const auto encoded = clock::now();
+        const bool decoded = decoder.Decode(buffer.data(), buffer.size());
+        const auto end = clock::now();
+
+        result.EncodeUs += std::chrono::duration<double, std::micro>(encoded - start).count();
+        result.DecodeUs += std::chrono::duration<double, std::micro>(end - encoded).count();
+        result.Bytes += buffer.size();
+        result.RoundTrip = result.RoundTrip && decoded && same_draw_data(draw_data, reinterpret_cast<ImDrawData*>(decoder.GetDrawData()));
+    }
+
+    result.EncodeUs /= iterations;
+    result.DecodeUs /= iterations;
+    result.Bytes /= iterations;
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    const int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 1000;
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(1920, 1080);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.IniFilename = nullptr;
+
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+    io.Fonts->SetTexID(reinterpret_cast<ImTextureID>(static_cast<intptr_t>(1)));
+
+    // Settles the windows sizes and the ImGui allocations.
+    for (int i = 0; i < 10; ++i)
+        draw_overlay(i);
+
+    ImDrawData* draw_data = ImGui::GetDrawData();
+    size_t raw_bytes = 0;
+    for (int i = 0; i < draw_data->CmdListsCount; ++i)
+    {
+        ImDrawList const* list = draw_data->CmdLists[i];
+        raw_bytes += list->CmdBuffer.Size * sizeof(ImDrawCmd) + list->VtxBuffer.Size * sizeof(ImDrawVert) + list->IdxBuffer.Size * sizeof(ImDrawIdx);
+    }
+
+    printf("%d draw lists, %d vertices, %d indices, %zu bytes raw\n", draw_data->CmdListsCount, draw_data->TotalVtxCount, draw_data->TotalIdxCount, raw_bytes);
+
+    struct
+    {
+        const char* Name;
+        bool Keyframes;
+        bool Animated;
+    } const cases[] = {
+        { "keyframes", true , true  },
+        { "animated" , false, true  },
+        { "static"   , false, false },
+    };
+
+    bool success = true;
+    for (auto const& test_case : cases)
+    {
+        const Result_t result = run(iterations, test_case.Keyframes, test_case.Animated);
+        printf("%-10s encode %8.2f us  decode %8.2f us  %8zu bytes  %s\n", test_case.Name, result.EncodeUs, result.DecodeUs, result.Bytes, result.RoundTrip ? "ok" : "ROUND TRIP FAILED");
+
+        success = success && result.RoundTrip;
+        if (test_case.Keyframes && result.EncodeUs >= EncodeBudgetUs)
+        {
+            printf("Full frame encode is over the %.0f us budget.\n", EncodeBudgetUs);
+            success = false;
+        }
+    }
+
+    ImGui::DestroyContext();
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
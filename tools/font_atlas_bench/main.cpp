@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+// Times Font_Atlas_Builder on a large glyph range at 1 to N threads, against ImFontAtlas::Build.
+//
+//   font_atlas_bench <font.ttf> [max_threads] [iterations]
+//
+// The font should cover CJK, the atlas uses GetGlyphRangesChineseFull.
+// Exits with 1 when a build fails or when its texture or glyph tables differ from the ImFontAtlas::Build ones.
+
+#include <ingame_overlay/Font_Atlas_Builder.h>
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+static constexpr float FontSize = 16.0f;
+
+static std::unique_ptr<ImFontAtlas> make_atlas(const char* font_path)
+{
+    std::unique_ptr<ImFontAtlas> atlas(new ImFontAtlas());
+    if (atlas->AddFontFromFileTTF(font_path, FontSize, nullptr, atlas->GetGlyphRangesChineseFull()) == nullptr)
+        return nullptr;
+
+    return atlas;
+}
+
+template<typename T>
+static bool same_vector(ImVector<T> const& a, ImVector<T> const& b)
+{
+    return a.Size == b.Size && (a.Size == 0 || memcmp(a.Data, b.Data, a.Size * sizeof(T)) == 0);
+}
+
+static bool same_atlas(ImFontAtlas const& a, ImFontAtlas const& b)
+{
+    if (a.TexWidth != b.TexWidth || a.TexHeight != b.TexHeight || a.TexPixelsAlpha8 == nullptr || b.TexPixelsAlpha8 == nullptr ||
+        memcmp(a.TexPixelsAlpha8, b.TexPixelsAlpha8, static_cast<size_t>(a.TexWidth) * a.TexHeight) != 0)
+        return false;
+
+    if (a.Fonts.Size != b.Fonts.Size)
+        return false;
+
+    for (int i = 0; i < a.Fonts.Size; ++i)
+    {
+        if (!same_vector(a.Fonts[i]->Glyphs, b.Fonts[i]->Glyphs) ||
+            !same_vector(a.Fonts[i]->IndexLookup, b.Fonts[i]->IndexLookup) ||
+            !same_vector(a.Fonts[i]->IndexAdvanceX, b.Fonts[i]->IndexAdvanceX))
+            return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    using clock = std::chrono::steady_clock;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <font.ttf> [max_threads] [iterations]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const char* font_path = argv[1];
+    const uint32_t max_threads = argc > 2 ? static_cast<uint32_t>(std::max(1, atoi(argv[2]))) : std::max(1u, std::thread::hardware_concurrency());
+    const int iterations = argc > 3 ? std::max(1, atoi(argv[3])) : 3;
+
+    std::unique_ptr<ImFontAtlas> reference;
+    double reference_ms = 0.0;
+    for (int i = 0; i < iterations; ++i)
+    {
+        reference = make_atlas(font_path);
+        if (!reference)
+        {
+            fprintf(stderr, "Failed to load %s\n", font_path);
+            return EXIT_FAILURE;
+        }
+
+        const auto start = clock::now();
+        const bool built = reference->Build();
+        const auto end = clock::now();
+        if (!built)
+        {
+            fprintf(stderr, "ImFontAtlas::Build failed.\n");
+            return EXIT_FAILURE;
+        }
+
+        reference_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    }
+    reference_ms /= iterations;
+
+    printf("%d glyphs, %dx%d texture\n", reference->Fonts[0]->Glyphs.Size, reference->TexWidth, reference->TexHeight);
+    printf("ImFontAtlas::Build    %9.2f ms\n", reference_ms);
+
+    bool success = true;
+    for (uint32_t thread_count = 1; thread_count <= max_threads; ++thread_count)
+    {
+        double build_ms = 0.0;
+        bool same = true;
+        for (int i = 0; i < iterations; ++i)
+        {
+            std::unique_ptr<ImFontAtlas> atlas = make_atlas(font_path);
+
+            const auto start = clock::now();
+            const bool built = ingame_overlay::Font_Atlas_Builder::Build(atlas.get(), thread_count);
+            const auto end = clock::now();
+
+            build_ms += std::chrono::duration<double, std::milli>(end - start).count();
+            same = same && built && same_atlas(*reference, *atlas);
+        }
+        build_ms /= iterations;
+
+        printf("%2u thread(s)          %9.2f ms  x%5.2f  %s\n", thread_count, build_ms, reference_ms / build_ms, same ? "ok" : "DIFFERS FROM IMFONTATLAS::BUILD");
+        success = success && same;
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+// Renders a text heavy scene with the ImGui OpenGL3 backend and with OpenGL_Quad_Renderer, in a GLX window.
+//
+//   gl_quad_bench [frames]
+//
+// Run it with LIBGL_ALWAYS_SOFTWARE=1 to measure on llvmpipe. The first frame of both paths is read back and compared.
+
+#define GLAD_GL_IMPLEMENTATION
+#include <glad/gl.h>
+
+#include "../../src/OpenGL_Quad_Renderer.h"
+
+#include <imgui.h>
+#include <backends/imgui_impl_opengl3.h>
+
+#include <GL/glx.h>
+#include <X11/Xlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static constexpr int WindowWidth = 1280;
+static constexpr int WindowHeight = 720;
+
+static void draw_scene(int frame)
+{
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui::NewFrame();
+
+    ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(WindowWidth * 0.7f, WindowHeight), ImGuiCond_Always);
+    ImGui::Begin("Chat", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoScrollbar);
+    for (int i = 0; i < 50; ++i)
+        ImGui::Text("[%02d:%02d] Player%03d: the quick brown fox jumps over the lazy dog, %d times in a row.", (frame + i) / 60 % 24, (frame + i) % 60, i * 7 % 1000, frame + i);
+    ImGui::End();
+
+    ImGui::SetNextWindowPos(ImVec2(WindowWidth * 0.7f, 0), ImGuiCond_Always);
+    ImGui::SetNextWindowSize(ImVec2(WindowWidth * 0.3f, WindowHeight), ImGuiCond_Always);
+    ImGui::Begin("Friends");
+    for (int i = 0; i < 40; ++i)
+    {
+        ImGui::Button(i % 3 == 0 ? "Online" : "Offline");
+        ImGui::SameLine();
+        ImGui::Text("Friend %02d", i);
+    }
+    ImGui::End();
+
+    ImGui::Render();
+}
+
+static size_t draw_data_bytes(ImDrawData const* draw_data)
+{
+    size_t bytes = 0;
+    for (int i = 0; i < draw_data->CmdListsCount; ++i)
+        bytes += draw_data->CmdLists[i]->VtxBuffer.Size * sizeof(ImDrawVert) + draw_data->CmdLists[i]->IdxBuffer.Size * sizeof(ImDrawIdx);
+
+    return bytes;
+}
+
+static std::vector<unsigned char> read_back()
+{
+    std::vector<unsigned char> pixels(static_cast<size_t>(WindowWidth) * WindowHeight * 4);
+    glReadPixels(0, 0, WindowWidth, WindowHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    return pixels;
+}
+
+// Renders frames with the given path, returns the average CPU + GPU time of a frame render in ms.
+static double run(OpenGL_Quad_Renderer* quad_renderer, int frames, size_t& upload_bytes, std::vector<unsigned char>& first_frame)
+{
+    using clock = std::chrono::steady_clock;
+
+    double total_ms = 0.0;
+    upload_bytes = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        draw_scene(i);
+        ImDrawData* draw_data = ImGui::GetDrawData();
+
+        glViewport(0, 0, WindowWidth, WindowHeight);
+        glClearColor(0.2f, 0.3f, 0.4f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glFinish();
+
+        const auto start = clock::now();
+        if (quad_renderer != nullptr)
+        {
+            quad_renderer->RenderDrawData(draw_data);
+            upload_bytes += draw_data_bytes(draw_data) + quad_renderer->GetQuadBytes();
+        }
+        else
+        {
+            upload_bytes += draw_data_bytes(draw_data);
+            ImGui_ImplOpenGL3_RenderDrawData(draw_data);
+        }
+        glFinish();
+        total_ms += std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+        if (i == 0)
+            first_frame = read_back();
+    }
+
+    upload_bytes /= frames;
+    return total_ms / frames;
+}
+
+int main(int argc, char* argv[])
+{
+    const int frames = argc > 1 ? std::max(1, atoi(argv[1])) : 300;
+
+    Display* display = XOpenDisplay(nullptr);
+    if (display == nullptr)
+    {
+        fprintf(stderr, "Failed to open the X display.\n");
+        return EXIT_FAILURE;
+    }
+
+    GLint visual_attributes[] = { GLX_RGBA, GLX_DOUBLEBUFFER, GLX_RED_SIZE, 8, GLX_GREEN_SIZE, 8, GLX_BLUE_SIZE, 8, None };
+    XVisualInfo* visual = glXChooseVisual(display, DefaultScreen(display), visual_attributes);
+    if (visual == nullptr)
+    {
+        fprintf(stderr, "No RGBA double buffered visual.\n");
+        return EXIT_FAILURE;
+    }
+
+    Window root = RootWindow(display, visual->screen);
+    XSetWindowAttributes window_attributes = {};
+    window_attributes.colormap = XCreateColormap(display, root, visual->visual, AllocNone);
+    Window window = XCreateWindow(display, root, 0, 0, WindowWidth, WindowHeight, 0, visual->depth, InputOutput, visual->visual, CWColormap, &window_attributes);
+    XMapWindow(display, window);
+
+    GLXContext context = glXCreateContext(display, visual, nullptr, True);
+    glXMakeCurrent(display, window, context);
+    if (gladLoaderLoadGL() == 0)
+    {
+        fprintf(stderr, "Failed to load OpenGL.\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%s, %s\n", reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.DisplaySize = ImVec2(WindowWidth, WindowHeight);
+    io.DeltaTime = 1.0f / 60.0f;
+    io.IniFilename = nullptr;
+    ImGui_ImplOpenGL3_Init();
+
+    OpenGL_Quad_Renderer quad_renderer;
+    std::vector<unsigned char> imgui_frame, quad_frame;
+    size_t imgui_bytes, quad_bytes;
+
+    const double imgui_ms = run(nullptr, frames, imgui_bytes, imgui_frame);
+    const double quad_ms = run(&quad_renderer, frames, quad_bytes, quad_frame);
+
+    size_t different_pixels = 0;
+    for (size_t i = 0; i < imgui_frame.size(); i += 4)
+    {
+        if (std::abs(imgui_frame[i] - quad_frame[i]) > 1 || std::abs(imgui_frame[i + 1] - quad_frame[i + 1]) > 1 || std::abs(imgui_frame[i + 2] - quad_frame[i + 2]) > 1)
+            ++different_pixels;
+    }
+
+    printf("imgui     %8.3f ms  %9zu bytes uploaded per frame\n", imgui_ms, imgui_bytes);
+    printf("instanced %8.3f ms  %9zu bytes uploaded per frame, %u quads\n", quad_ms, quad_bytes, quad_renderer.GetQuadCount());
+    printf("%zu pixels differ on the first frame\n", different_pixels);
+
+    quad_renderer.Destroy();
+    ImGui_ImplOpenGL3_Shutdown();
+    ImGui::DestroyContext();
+
+    glXMakeCurrent(display, None, nullptr);
+    glXDestroyContext(display, context);
+    XDestroyWindow(display, window);
+    XFree(visual);
+    XCloseDisplay(display);
+
+    return different_pixels == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
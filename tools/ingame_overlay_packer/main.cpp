@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+// Builds an Asset_Pack at build time:
+//   ingame_overlay_packer <output> [asset]...
+//     --image <name> <file> [--mipmaps] [--max-size <size>]   PNG, JPEG, BMP or TGA, decoded to RGBA
+//     --compressed <name> <file> <BC1-BC5|ETC2_RGB|ETC2_RGBA> <width> <height>   raw 4x4 blocks
+//     --blob <name> <file>
+
+#include <ingame_overlay/Asset_Pack.h>
+
+#include "../../src/Pixel_Convert.h"
+#include "../../src/Texture_Decompress.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_STATIC
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace ingame_overlay;
+
+struct Asset_t
+{
+    std::string Name;
+    AssetPackEntry_t Entry;
+    std::vector<uint8_t> Data;
+};
+
+static bool ReadFile(std::string const& path, std::vector<uint8_t>& data)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+        return false;
+
+    file.seekg(0, std::ios::end);
+    data.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+static bool ParseCompressedFormat(std::string const& name, CompressedFormat& format)
+{
+    static const struct { const char* Name; CompressedFormat Format; } formats[] = {
+        { "BC1"      , CompressedFormat::BC1       },
+        { "BC2"      , CompressedFormat::BC2       },
+        { "BC3"      , CompressedFormat::BC3       },
+        { "BC4"      , CompressedFormat::BC4       },
+        { "BC5"      , CompressedFormat::BC5       },
+        { "ETC2_RGB" , CompressedFormat::ETC2_RGB  },
+        { "ETC2_RGBA", CompressedFormat::ETC2_RGBA },
+    };
+
+    for (auto const& item : formats)
+    {
+        if (name == item.Name)
+        {
+            format = item.Format;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static int Usage()
+{
+    fprintf(stderr,
+        "Usage: ingame_overlay_packer <output> [asset]...\n"
+        "  --image <name> <file> [--mipmaps] [--max-size <size>]\n"
+        "  --compressed <name> <file> <BC1|BC2|BC3|BC4|BC5|ETC2_RGB|ETC2_RGBA> <width> <height>\n"
+        "  --blob <name> <file>\n");
+    return 1;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+        return Usage();
+
+    std::vector<Asset_t> assets;
+    for (int i = 2; i < argc;)
+    {
+        std::string kind = argv[i++];
+        // Every asset starts with its name and file.
+        if (i + 1 >= argc)
+            return Usage();
+
+        Asset_t asset;
+        memset(&asset.Entry, 0, sizeof(asset.Entry));
+        asset.Name = argv[i++];
+        std::string path = argv[i++];
+
+        std::vector<uint8_t> file_data;
+        if (!ReadFile(path, file_data))
+        {
+            fprintf(stderr, "Failed to read %s.\n", path.c_str());
+            return 1;
+        }
+
+        if (kind == "--image")
+        {
+            bool mipmaps = false;
+            uint32_t max_size = 0;
+            while (i < argc)
+            {
+                if (strcmp(argv[i], "--mipmaps") == 0)
+                {
+                    mipmaps = true;
+                    ++i;
+                }
+                else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc)
+                {
+                    max_size = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+                    i += 2;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            int width, height, channels;
+            stbi_uc* pixels = stbi_load_from_memory(file_data.data(), static_cast<int>(file_data.size()), &width, &height, &channels, 4);
+            if (pixels == nullptr)
+            {
+                fprintf(stderr, "Failed to decode %s: %s.\n", path.c_str(), stbi_failure_reason());
+                return 1;
+            }
+
+            uint32_t new_width = static_cast<uint32_t>(width);
+            uint32_t new_height = static_cast<uint32_t>(height);
+            if (!Pixel_Convert::Fit(pixels, width, height, max_size, max_size, asset.Data, new_width, new_height))
+                asset.Data.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+            stbi_image_free(pixels);
+
+            asset.Entry.Type = static_cast<uint32_t>(AssetType::Image);
+            asset.Entry.Width = new_width;
+            asset.Entry.Height = new_height;
+            asset.Entry.Flags = mipmaps ? AssetFlag_Mipmaps : 0;
+        }
+        else if (kind == "--compressed")
+        {
+            CompressedFormat format;
+            if (i + 2 >= argc || !ParseCompressedFormat(argv[i], format))
+                return Usage();
+
+            const uint32_t width = static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+            const uint32_t height = static_cast<uint32_t>(strtoul(argv[i + 2], nullptr, 10));
+            i += 3;
+
+            const size_t size = Texture_Decompress::CompressedSize(format, width, height);
+            if (width == 0 || height == 0 || file_data.size() < size)
+            {
+                fprintf(stderr, "%s is too small for a %ux%u %s image.\n", path.c_str(), width, height, argv[i - 3]);
+                return 1;
+            }
+
+            file_data.resize(size);
+            asset.Data = std::move(file_data);
+            asset.Entry.Type = static_cast<uint32_t>(AssetType::CompressedImage);
+            asset.Entry.Format = static_cast<uint32_t>(format);
+            asset.Entry.Width = width;
+            asset.Entry.Height = height;
+        }
+        else if (kind == "--blob")
+        {
+            asset.Data = std::move(file_data);
+            asset.Entry.Type = static_cast<uint32_t>(AssetType::Blob);
+        }
+        else
+        {
+            return Usage();
+        }
+
+        assets.emplace_back(std::move(asset));
+    }
+
+    // Asset_Pack::FindAsset does a binary search.
+    std::sort(assets.begin(), assets.end(), [](Asset_t const& a, Asset_t const& b) { return a.Name < b.Name; });
+    for (size_t i = 1; i < assets.size(); ++i)
+    {
+        if (assets[i - 1].Name == assets[i].Name)
+        {
+            fprintf(stderr, "Asset %s is packed twice.\n", assets[i].Name.c_str());
+            return 1;
+        }
+    }
+
+    auto align = [](uint64_t offset) { return (offset + 15) & ~static_cast<uint64_t>(15); };
+
+    uint64_t offset = sizeof(AssetPackHeader_t) + sizeof(AssetPackEntry_t) * assets.size();
+    for (auto& asset : assets)
+    {
+        asset.Entry.NameOffset = offset;
+        asset.Entry.NameSize = static_cast<uint32_t>(asset.Name.size());
+        offset += asset.Name.size();
+    }
+    for (auto& asset : assets)
+    {
+        offset = align(offset);
+        asset.Entry.DataOffset = offset;
+        asset.Entry.DataSize = asset.Data.size();
+        offset += asset.Data.size();
+    }
+
+    std::ofstream output(argv[1], std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!output)
+    {
+        fprintf(stderr, "Failed to create %s.\n", argv[1]);
+        return 1;
+    }
+
+    AssetPackHeader_t header;
+    memcpy(header.Magic, AssetPackMagic, sizeof(header.Magic));
+    header.Version = AssetPackVersion;
+    header.AssetCount = static_cast<uint32_t>(assets.size());
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (auto const& asset : assets)
+        output.write(reinterpret_cast<const char*>(&asset.Entry), sizeof(asset.Entry));
+
+    for (auto const& asset : assets)
+        output.write(asset.Name.data(), asset.Name.size());
+
+    uint64_t position = sizeof(AssetPackHeader_t) + sizeof(AssetPackEntry_t) * assets.size();
+    for (auto const& asset : assets)
+        position += asset.Name.size();
+
+    static const char padding[16] = {};
+    for (auto const& asset : assets)
+    {
+        output.write(padding, static_cast<std::streamsize>(asset.Entry.DataOffset - position));
+        output.write(reinterpret_cast<const char*>(asset.Data.data()), asset.Data.size());
+        position = asset.Entry.DataOffset + asset.Data.size();
+    }
+
+    if (!output)
+    {
+        fprintf(stderr, "Failed to write %s.\n", argv[1]);
+        return 1;
+    }
+
+    printf("Packed %u assets in %s (%llu bytes).\n", header.AssetCount, argv[1], static_cast<unsigned long long>(position));
+    return 0;
+}
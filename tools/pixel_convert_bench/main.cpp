@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) Nemirtingas
+ * This file is part of the ingame overlay project
+ *
+ * The ingame overlay project is free software; you can redistribute it
+ * and/or modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * The ingame overlay project is distributed in the hope that it will be
+ * useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with the ingame overlay project; if not, see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+
+// Times every Pixel_Convert kernel set this CPU can run on the same rows, and checks they give the scalar bytes.
+//
+//   pixel_convert_bench [iterations]
+//
+// Exits with 1 when a kernel set output differs from the scalar one.
+
+#include "../../src/Pixel_Convert.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ingame_overlay;
+
+static constexpr uint32_t RowWidth = 1920;
+static constexpr uint32_t RowCount = 64;
+
+struct Case_t
+{
+    const char* Name;
+    PixelFormat Format;
+    AlphaMode Alpha;
+};
+
+static const Case_t Cases[] = {
+    { "RGBA premultiplied", PixelFormat::RGBA, AlphaMode::Premultiplied },
+    { "BGRA straight"     , PixelFormat::BGRA, AlphaMode::Straight      },
+    { "BGRA premultiplied", PixelFormat::BGRA, AlphaMode::Premultiplied },
+    { "RGB"               , PixelFormat::RGB , AlphaMode::Straight      },
+    { "BGR"               , PixelFormat::BGR , AlphaMode::Straight      },
+};
+
+static const Pixel_Convert::KernelSet KernelSets[] = {
+    Pixel_Convert::KernelSet::Scalar,
+    Pixel_Convert::KernelSet::SSE2,
+    Pixel_Convert::KernelSet::AVX2,
+    Pixel_Convert::KernelSet::NEON,
+};
+
+// Premultiplied pixels never have a color above their alpha, with some fully transparent and opaque ones.
+static void fill_rows(std::vector<uint8_t>& rows, uint32_t bytes_per_pixel, bool premultiplied)
+{
+    std::mt19937 random(1234);
+    for (size_t i = 0; i < rows.size(); i += bytes_per_pixel)
+    {
+        const uint32_t value = random();
+        uint8_t alpha = static_cast<uint8_t>(value >> 24);
+        if ((value & 0xf) == 0)
+            alpha = 0;
+        else if ((value & 0xf) == 1)
+            alpha = 255;
+
+        for (uint32_t c = 0; c < bytes_per_pixel; ++c)
+        {
+            const uint8_t channel = static_cast<uint8_t>(value >> (c * 8));
+            rows[i + c] = premultiplied ? static_cast<uint8_t>(channel * alpha / 255) : channel;
+        }
+
+        if (bytes_per_pixel == 4)
+            rows[i + 3] = alpha;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    using clock = std::chrono::steady_clock;
+
+    const int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 200;
+
+    printf("ConvertRow uses %s, %u rows of %u pixels\n", Pixel_Convert::KernelSetName(Pixel_Convert::GetKernelSet()), RowCount, RowWidth);
+
+    std::vector<uint8_t> reference(static_cast<size_t>(RowWidth) * RowCount * 4);
+    std::vector<uint8_t> output(reference.size());
+
+    bool success = true;
+    for (auto const& test_case : Cases)
+    {
+        const uint32_t bytes_per_pixel = Pixel_Convert::BytesPerPixel(test_case.Format);
+        std::vector<uint8_t> rows(static_cast<size_t>(RowWidth) * RowCount * bytes_per_pixel);
+        fill_rows(rows, bytes_per_pixel, test_case.Alpha == AlphaMode::Premultiplied);
+
+        for (uint32_t row = 0; row < RowCount; ++row)
+            Pixel_Convert::ConvertRow(&rows[static_cast<size_t>(row) * RowWidth * bytes_per_pixel], &reference[static_cast<size_t>(row) * RowWidth * 4], RowWidth, test_case.Format, test_case.Alpha, Pixel_Convert::KernelSet::Scalar);
+
+        double scalar_ns = 0.0;
+        for (auto kernel_set : KernelSets)
+        {
+            if (!Pixel_Convert::HasKernelSet(kernel_set))
+                continue;
+
+            const auto start = clock::now();
+            for (int i = 0; i < iterations; ++i)
+            {
+                for (uint32_t row = 0; row < RowCount; ++row)
+                    Pixel_Convert::ConvertRow(&rows[static_cast<size_t>(row) * RowWidth * bytes_per_pixel], &output[static_cast<size_t>(row) * RowWidth * 4], RowWidth, test_case.Format, test_case.Alpha, kernel_set);
+            }
+            const auto end = clock::now();
+
+            const double pixel_ns = std::chrono::duration<double, std::nano>(end - start).count() / (static_cast<double>(iterations) * RowWidth * RowCount);
+            if (kernel_set == Pixel_Convert::KernelSet::Scalar)
+                scalar_ns = pixel_ns;
+
+            const bool same = memcmp(output.data(), reference.data(), reference.size()) == 0;
+            printf("%-18s %-6s %7.3f ns/pixel  x%5.2f  %s\n", test_case.Name, Pixel_Convert::KernelSetName(kernel_set), pixel_ns, scalar_ns / pixel_ns, same ? "ok" : "DIFFERS FROM SCALAR");
+
+            success = success && same;
+        }
+    }
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}